@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdint.h>
+
+/*
+* Allocation guard used to check that TitanReset hot paths never touch the heap.
+*
+* Define TR_ALLOC_GUARD (for example in EXTRA_CXXFLAGS of the Makefile) to replace the global operator new with a counting version.
+* Without the define every guard compiles away to nothing.
+*/
+
+/**
+ * @brief Scope that counts heap allocations made while it is alive.
+ */
+class tr_alloc_scope
+{
+public:
+
+    /**
+     * @brief Starts counting allocations.
+     * @param name name of the guarded path, printed when the path allocates
+     */
+    tr_alloc_scope(const char* name);
+
+    /**
+     * @brief Stops counting and reports the path if it allocated.
+     */
+    ~tr_alloc_scope();
+
+    /**
+     * @brief Total heap allocations made inside of guarded scopes since startup.
+     */
+    static uint32_t violations();
+
+    /**
+     * @brief Total heap allocations made since startup.
+     */
+    static uint32_t allocations();
+
+private:
+    const char* name;
+    uint32_t start;
+};
+
+#ifdef TR_ALLOC_GUARD
+#define TR_ALLOC_CONCAT_INNER(a, b) a##b
+#define TR_ALLOC_CONCAT(a, b) TR_ALLOC_CONCAT_INNER(a, b)
+#define TR_NO_ALLOC(name) tr_alloc_scope TR_ALLOC_CONCAT(tr_alloc_scope_, __LINE__)(name)
+#else
+#define TR_NO_ALLOC(name) ((void)0)
+#endif
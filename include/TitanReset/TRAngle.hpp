@@ -0,0 +1,127 @@
+#pragma once
+
+#include "TRTypes.hpp"
+#include <math.h>
+#include <stdint.h>
+
+/**
+ * @brief Wrapping 16 bit binary angle. A full turn is 65536 units, so normalization is free and quadrant math is integer only.
+ *
+ * Resolution is 360 / 65536 degrees, roughly 0.0055 degrees.
+ */
+class tr_angle
+{
+public:
+
+    /**
+     * Units in a full turn.
+     */
+    static constexpr int32_t turn = 65536;
+
+    /**
+     * Units in a quarter turn.
+     */
+    static constexpr int32_t quarter = turn / 4;
+
+    /**
+     * Units in an eighth of a turn, 45 degrees.
+     */
+    static constexpr int32_t eighth = turn / 8;
+
+    constexpr tr_angle() : raw(0) {}
+
+    /**
+     * @brief Constructs an angle from raw binary units.
+     */
+    static constexpr tr_angle from_raw(uint16_t raw)
+    {
+        return tr_angle(raw);
+    }
+
+    /**
+     * @brief Constructs an angle from degrees of any magnitude. NaN and infinite degrees give 0.
+     *
+     * Whole turns are taken off with fmodf first, which is exact, so the rounded units always fit and huge wind-up keeps the
+     * precision of the heading the float actually holds.
+     */
+    static tr_angle from_degrees(float degrees)
+    {
+        if (!isfinite(degrees)) return tr_angle();
+        return tr_angle((uint16_t)llrintf(fmodf(degrees, 360.0f) * (turn / 360.0f)));
+    }
+
+    /**
+     * @brief Gets the raw binary units.
+     */
+    constexpr uint16_t get_raw() const
+    {
+        return raw;
+    }
+
+    /**
+     * @brief Gets the angle in degrees in the domain of 0 to 360.
+     */
+    float to_degrees() const
+    {
+        return raw * (360.0f / turn);
+    }
+
+    /**
+     * @brief Gets the angle in degrees in the domain of -180 to 180.
+     */
+    float to_signed_degrees() const
+    {
+        return (int16_t)raw * (360.0f / turn);
+    }
+
+    /**
+     * @brief Signed error to the nearest multiple of 90 degrees in raw units, in the domain of -45 to 45 degrees.
+     */
+    constexpr int16_t square_error() const
+    {
+        return (int16_t)(((raw + eighth) & (quarter - 1)) - eighth);
+    }
+
+    /**
+     * @brief Signed error to the nearest multiple of 90 degrees in degrees, in the domain of -45 to 45.
+     */
+    float square_error_degrees() const
+    {
+        return square_error() * (360.0f / turn);
+    }
+
+    /**
+     * @brief Heading quadrant used to pick the relevant sensors.
+     *
+     * Boundaries belong to the lower quadrant, so 45 degrees is POS_POS and 135 degrees is NEG_POS.
+     */
+    constexpr tr_quadrant quadrant() const
+    {
+        return (tr_quadrant)((uint16_t)(raw + eighth - 1) >> 14);
+    }
+
+    constexpr tr_angle operator+(tr_angle other) const
+    {
+        return tr_angle((uint16_t)(raw + other.raw));
+    }
+
+    constexpr tr_angle operator-(tr_angle other) const
+    {
+        return tr_angle((uint16_t)(raw - other.raw));
+    }
+
+    constexpr bool operator==(tr_angle other) const
+    {
+        return raw == other.raw;
+    }
+
+    constexpr bool operator!=(tr_angle other) const
+    {
+        return raw != other.raw;
+    }
+
+private:
+    constexpr explicit tr_angle(uint16_t raw) : raw(raw) {}
+
+    uint16_t raw;
+};
@@ -0,0 +1,201 @@
+#pragma once
+
+#include "TRTypes.hpp"
+#include "../pros/rtos.hpp"
+#include <atomic>
+
+/**
+ * States of an asynchronous distance sensor reset.
+ */
+enum tr_dsr_state
+{
+    /**
+     * Reset is waiting for the worker.
+     */
+    DSR_QUEUED,
+
+    /**
+     * Worker is waiting for the robot to pass the waypoint of the reset and for favourable beam geometry.
+     */
+    DSR_WAITING,
+
+    /**
+     * Worker is reading the sensors and applying the reset.
+     */
+    DSR_RUNNING,
+
+    /**
+     * Reset finished. The result is available.
+     */
+    DSR_DONE,
+
+    /**
+     * Reset was never performed. The rejection reason explains why.
+     */
+    DSR_REJECTED,
+};
+
+/**
+ * Waypoint an asynchronous reset waits for before reading the sensors.
+ */
+struct tr_dsr_trigger
+{
+    /**
+     * Whether the reset waits for the waypoint. A reset without a trigger runs as soon as the worker reaches it.
+     */
+    bool enabled;
+
+    /**
+     * The reset triggers once the robot crosses the line through point perpendicular to the approach from from.
+     */
+    tr_vector2 point;
+    tr_vector2 from;
+
+    /**
+     * Time in milliseconds to wait for the waypoint and favourable beam geometry.
+     */
+    uint32_t timeout;
+};
+
+/**
+ * Request and result storage for a single asynchronous reset.
+ */
+struct tr_dsr_slot
+{
+    std::atomic<tr_dsr_state> state;
+    std::atomic<uint32_t> generation;
+    bool use_quadrant;
+    tr_quadrant quadrant;
+    tr_dsr_trigger trigger;
+    tr_vector3 pose;
+    tr_dsr_result result;
+};
+
+/**
+ * Function performing a queued reset and filling in its result. Context is the pointer given to the worker.
+ */
+typedef void (*tr_dsr_executor)(void* context, tr_dsr_slot& slot);
+
+/**
+ * @brief Lightweight handle to an asynchronous distance sensor reset.
+ *
+ * Handles are plain values and can be copied freely. A handle whose slot has since been reused by a newer reset reports DSR_REJECTED with REJECT_EXPIRED.
+ * Results are copied out of the slot and kept only if the generation is unchanged after the copy, so a copy torn by a newer reset is never returned.
+ */
+class tr_dsr_handle
+{
+public:
+
+    /**
+     * @brief Constructs a handle that refers to no reset.
+     */
+    tr_dsr_handle();
+
+    /**
+     * @brief Gets the state of the reset.
+     */
+    tr_dsr_state get_state() const;
+
+    /**
+     * @brief Whether the reset has either finished or been rejected.
+     */
+    bool is_done() const;
+
+    /**
+     * @brief Blocks until the reset is done or the timeout runs out.
+     * @param timeout maximum time to wait in milliseconds
+     * @return Whether the reset finished within the timeout
+     */
+    bool wait(uint32_t timeout) const;
+
+    /**
+     * @brief Pose of the drivebase after the reset. Only valid once the state is DSR_DONE.
+     */
+    tr_vector3 get_pose() const;
+
+    /**
+     * @brief Confidence of the calculated pose. Only valid once the state is DSR_DONE.
+     */
+    tr_probability get_confidence() const;
+
+    /**
+     * @brief Reason the reset was not applied, REJECT_NONE if it was.
+     */
+    tr_rejection_reason get_rejection() const;
+
+    /**
+     * @brief Full result of the reset. Only valid once the state is DSR_DONE or DSR_REJECTED.
+     */
+    tr_dsr_result get_result() const;
+
+private:
+    friend class tr_dsr_worker;
+
+    tr_dsr_handle(tr_dsr_slot* slot, uint32_t generation, tr_rejection_reason rejection);
+
+    bool is_current() const;
+
+    tr_dsr_slot* slot;
+    uint32_t generation;
+
+    /**
+     * Rejection for handles that never got a slot.
+     */
+    tr_rejection_reason rejection;
+};
+
+/**
+ * @brief Background worker that performs distance sensor resets queued by autonomous code.
+ *
+ * Requests live in a fixed ring of slots so queuing never allocates. The worker task is created on the first request.
+ */
+class tr_dsr_worker
+{
+public:
+
+    /**
+     * Maximum amount of resets that can be queued or kept for polling at once.
+     */
+    static constexpr int slot_count = 8;
+
+    /**
+     * @brief Constructs a worker.
+     * @param executor function performing each reset
+     * @param context pointer passed to the executor
+     */
+    tr_dsr_worker(tr_dsr_executor executor, void* context);
+
+    /**
+     * @brief Queues a reset.
+     * @param use_quadrant whether to use the given quadrant instead of the quadrant from odometry
+     * @param quadrant quadrant to use when use_quadrant is set
+     * @param trigger waypoint the reset waits for
+     * @return Handle of the queued reset. Rejected with REJECT_QUEUE_FULL if every slot is busy.
+     */
+    tr_dsr_handle submit(bool use_quadrant, tr_quadrant quadrant, tr_dsr_trigger trigger = {});
+
+    /**
+     * @brief Deletes the worker task. Queued resets are never performed.
+     * @warning The task is deleted wherever it is, so the owner has to keep it out of the executor, such as by holding a lock the executor takes.
+     */
+    void stop();
+
+private:
+
+    static void task_body(void* param);
+
+    void run();
+
+    tr_dsr_executor executor;
+    void* context;
+    pros::task_t task;
+
+    tr_dsr_slot slots[slot_count];
+    int head;
+    int tail;
+
+    /**
+     * Held while a slot is claimed, as any task may queue resets.
+     */
+    pros::Mutex submit_mutex;
+};
@@ -0,0 +1,180 @@
+#pragma once
+
+#include "TRTypes.hpp"
+
+/**
+ * Whether a beam reading can be used and why not.
+ */
+enum tr_beam_validity
+{
+    /**
+     * The reading is usable.
+     */
+    BEAM_VALID,
+
+    /**
+     * The sensor could not read a distance.
+     */
+    BEAM_NO_READING,
+
+    /**
+     * The reading is closer than the sensor can measure reliably.
+     */
+    BEAM_TOO_CLOSE,
+
+    /**
+     * The reading is further than the sensor can measure reliably.
+     */
+    BEAM_TOO_FAR,
+
+    /**
+     * The beam meets the wall at too steep an angle.
+     */
+    BEAM_STEEP_INCIDENCE,
+
+    /**
+     * The beam cone catches the adjacent wall by more than the cone model can correct, or the beam hits a different wall than the one it was assigned.
+     */
+    BEAM_NEAR_CORNER,
+};
+
+/**
+ * Validity of a beam reading and the variance of the distance it measured.
+ */
+struct tr_beam_quality
+{
+    tr_beam_validity validity;
+
+    /**
+     * Variance of the reading in square inches.
+     */
+    float variance;
+
+    /**
+     * Confidence the sensor reported the reading with, from 0 to 1.
+     */
+    float confidence;
+
+    bool is_valid() const
+    {
+        return validity == BEAM_VALID;
+    }
+};
+
+/**
+ * Ideal ray traced from a point to the field walls.
+ */
+struct tr_beam_trace
+{
+    /**
+     * Distance along the ray to the first wall in inches.
+     */
+    float range;
+
+    /**
+     * Angle between the ray and the normal of the wall it hits in degrees.
+     */
+    float incidence;
+
+    /**
+     * Distance along the wall from where the ray hits to the adjacent wall in inches.
+     */
+    float corner_distance;
+
+    /**
+     * Whether the ray hits one of the walls at constant X.
+     */
+    bool hits_x_wall;
+};
+
+/**
+ * @brief Traces an ideal ray from a point to the field walls.
+ * @param origin start of the ray in inches
+ * @param facing direction of the ray in degrees, clockwise from +Y
+ */
+tr_beam_trace tr_trace_beam(tr_vector2 origin, float facing);
+
+/**
+ * @brief Validity limits and noise model of the V5 Distance Sensor.
+ *
+ * Noise follows the datasheet accuracy, 15 mm below 200 mm and 5% beyond, grown with incidence and shrunk with confidence.
+ *
+ * Near corners the emission cone catches the adjacent wall and the sensor reads short. The expected range integrates the cone over the field walls
+ * as a fan of rays with a precomputed angle and intensity table, each return weighted by its intensity, its incidence and the inverse square of its range.
+ */
+class tr_beam_model
+{
+public:
+
+    /**
+     * Amount of rays the emission cone is integrated over.
+     */
+    static constexpr int cone_rays = 15;
+
+    /**
+     * Largest short reading in inches the cone model is trusted to correct.
+     */
+    static constexpr float max_corner_bias = 2.0f;
+
+    /**
+     * @brief Constructs a beam model.
+     * @param min_range closest reliable reading in inches
+     * @param max_range furthest reliable reading in inches
+     * @param max_incidence steepest reliable incidence in degrees
+     * @param cone_half_angle half angle of the emission cone in degrees
+     */
+    tr_beam_model(float min_range = 0.8, float max_range = 78.0, float max_incidence = 30.0, float cone_half_angle = 13.5);
+
+    /**
+     * @brief Rates a single reading.
+     * @param reading reading in inches
+     * @param confidence confidence reported by the sensor from 0 to 1
+     * @param incidence angle between the beam and the wall normal in degrees, either sign
+     * @param corner_bias predicted short reading from the cone catching the adjacent wall, from corner_bias()
+     */
+    tr_beam_quality evaluate(float reading, float confidence, float incidence, float corner_bias) const;
+
+    /**
+     * @brief Expected reading of a beam over the field walls including the emission cone.
+     * @param origin position of the sensor in inches
+     * @param facing direction of the beam in degrees, clockwise from +Y
+     * @return Expected reading in inches. Equal to the ideal ray range away from corners.
+     */
+    float expected_range(tr_vector2 origin, float facing) const;
+
+    /**
+     * @brief Amount the cone makes a beam read further than the ideal ray, negative when it reads short near a corner.
+     * @param origin position of the sensor in inches
+     * @param facing direction of the beam in degrees, clockwise from +Y
+     * @param ideal ideal ray traced from the same origin and facing
+     */
+    float corner_bias(tr_vector2 origin, float facing, const tr_beam_trace& ideal) const;
+
+    /**
+     * @brief Distance along the wall the cone spreads past the hit point towards a corner.
+     */
+    float cone_reach(float reading, float incidence) const;
+
+    float get_min_range() const { return min_range; }
+    float get_max_range() const { return max_range; }
+    float get_max_incidence() const { return max_incidence; }
+    float get_cone_half_angle() const { return cone_half_angle; }
+
+private:
+    float min_range;
+    float max_range;
+    float max_incidence;
+    float cone_half_angle;
+
+    /**
+     * Sine, cosine and normalized intensity of each cone ray offset from the center of the beam.
+     */
+    float ray_sin[cone_rays];
+    float ray_cos[cone_rays];
+    float ray_weight[cone_rays];
+
+    /**
+     * @brief Intensity weighted range of the cone against a flat wall at a perpendicular distance.
+     */
+    float flat_wall_range(float perpendicular_distance, float incidence) const;
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+/*
+* Batched transform of the four distance sensor beams.
+*
+* Every sensor shares the heading error to the nearest wall, so the trigonometry is computed once per heading and applied to all beams in a single pass.
+* The V5 build uses NEON, hosts with SSE use SSE, and anything else falls back to the scalar reference.
+*/
+
+/**
+ * @brief Fast sine and cosine for angles within +-45 degrees.
+ * @note Polynomial approximation with an absolute error below 1e-6 inside the domain. Outside of it the error grows quickly.
+ *
+ * @param rad angle in radians
+ * @param sin_out sine of the angle
+ * @param cos_out cosine of the angle
+ */
+void tr_fast_sincos(float rad, float& sin_out, float& cos_out);
+
+/**
+ * @brief Converts four raw beam readings into distances from the center of the robot perpendicular to the wall.
+ *
+ * out[i] = cos(err) * (readings[i] + parallel[i]) - sin(err) * perpendicular[i]
+ *
+ * @param heading_error signed error to the nearest multiple of 90 degrees in degrees
+ * @param readings raw readings in inches
+ * @param parallel parallel offsets of the sensors in inches
+ * @param perpendicular perpendicular offsets of the sensors in inches
+ * @param out transformed distances in inches
+ */
+void tr_beam_transform(float heading_error, const float readings[4], const float parallel[4], const float perpendicular[4], float out[4]);
+
+/**
+ * @brief Scalar reference implementation of tr_beam_transform using double precision libm trigonometry.
+ */
+void tr_beam_transform_scalar(float heading_error, const float readings[4], const float parallel[4], const float perpendicular[4], float out[4]);
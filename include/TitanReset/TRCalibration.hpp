@@ -0,0 +1,161 @@
+#pragma once
+
+#include "TRTypes.hpp"
+#include "TRConstants.hpp"
+#include <stdint.h>
+
+class tr_chassis;
+
+/**
+ * Single raw reading of a sensor together with the pose of the robot when it was taken.
+ */
+struct tr_calibration_sample
+{
+    float x;
+    float y;
+    float heading;
+    float reading;
+};
+
+/**
+ * Mounting of a sensor solved from calibration samples.
+ */
+struct tr_sensor_calibration
+{
+    /**
+     * Offset of the sensor with X parallel to its facing and Y perpendicular, in inches.
+     */
+    tr_vector2 offset;
+
+    /**
+     * Mounting yaw in degrees, clockwise from the nominal facing.
+     */
+    float yaw;
+
+    /**
+     * Root mean square of the reading residuals in inches.
+     */
+    float rms;
+
+    /**
+     * Amount of samples the solution was fit to.
+     */
+    int samples;
+
+    /**
+     * Whether the solver converged to a plausible mounting.
+     */
+    bool valid;
+};
+
+/**
+ * @brief Solves the mounting of a sensor by nonlinear least squares.
+ *
+ * Fits the parallel offset, perpendicular offset and mounting yaw that best predict every reading from the pose it was taken at,
+ * intersecting the beam with the field walls. Solved with Levenberg-Marquardt, samples far off the first fit are dropped and the fit repeated once.
+ *
+ * @param samples samples of the sensor
+ * @param count amount of samples
+ * @param mount mounting direction of the sensor in quarter turns clockwise from the front of the robot
+ * @param initial starting guess of the offset, usually the hand measured one
+ * @return Solved mounting
+ */
+tr_sensor_calibration tr_solve_mounting(const tr_calibration_sample* samples, int count, int mount, tr_vector2 initial);
+
+/**
+ * @brief Predicts the reading of a sensor from the pose of the robot and a mounting.
+ * @param incidence_deg if given, set to the angle between the beam and the normal of the wall it hits in degrees
+ * @return Distance along the beam to the first wall it hits in inches
+ */
+double tr_predict_reading(const tr_calibration_sample& sample, int mount, double parallel, double perpendicular, double yaw_rad, double* incidence_deg = nullptr);
+
+/**
+ * @brief Calibration mode recording sensor readings and solving each sensor's mounting.
+ *
+ * Record while the robot rotates in place at a known position, or while it drives along a wall with odometry providing the position.
+ * Samples live in fixed buffers inside the calibrator so recording never allocates.
+ */
+class tr_calibrator
+{
+public:
+
+    /**
+     * Maximum amount of samples kept per sensor.
+     */
+    static constexpr int max_samples = 512;
+
+    /**
+     * Least amount of samples a sensor needs to be solved.
+     */
+    static constexpr int min_samples = 20;
+
+    /**
+     * @brief Constructs a calibrator for the sensors of a chassis.
+     */
+    tr_calibrator(tr_chassis* chassis);
+
+    /**
+     * @brief Uses a known position for every sample instead of odometry. Use when rotating in place.
+     * @param position position of the center of the robot in inches
+     */
+    void set_known_position(tr_vector2 position);
+
+    /**
+     * @brief Goes back to taking the position of every sample from odometry.
+     */
+    void clear_known_position();
+
+    /**
+     * @brief Discards every sample.
+     */
+    void clear();
+
+    /**
+     * @brief Records one sample of every sensor that can read.
+     * @return Amount of sensors sampled
+     */
+    int sample();
+
+    /**
+     * @brief Samples for a duration. Start the rotation or drive motion first, for example with pid_turn_set.
+     * @param duration time to record in milliseconds
+     * @param period time between samples in milliseconds
+     * @return Amount of sample rounds recorded
+     */
+    int record(uint32_t duration, uint32_t period = 20);
+
+    /**
+     * @brief Gets the amount of samples of a sensor, ordered north, east, south, west.
+     */
+    int get_sample_count(int sensor) const;
+
+    /**
+     * @brief Solves the mounting of a sensor, ordered north, east, south, west.
+     */
+    tr_sensor_calibration solve(int sensor) const;
+
+    /**
+     * @brief Solves every sensor, applies the valid solutions and writes them to a calibration file.
+     * @param path path of the calibration file
+     * @return Whether the file was written
+     */
+    bool save(const char* path = calibration_file);
+
+    /**
+     * @brief Builds a range and incidence correction table for every sensor from the residuals of its samples against its current mounting.
+     * @note Run after save() so the tables only hold what the mounting cannot explain.
+     *
+     * @param format path of the table files, formatted with the sensor port
+     * @return Amount of tables written
+     */
+    int save_corrections(const char* format = correction_file_format);
+
+private:
+    tr_chassis* chassis;
+
+    bool use_known_position;
+    tr_vector2 known_position;
+
+    tr_calibration_sample samples[4][max_samples];
+    int sample_count[4];
+};
@@ -1,6 +1,17 @@
 #pragma once
 
 #include "TRSensor.hpp"
+#include "TRRecorder.hpp"
+#include "TRAsync.hpp"
+#include "TRWallFollow.hpp"
+#include "TREvents.hpp"
+#include "TRTrust.hpp"
+#include "TRDrivebase.hpp"
+#include "TRConstants.hpp"
+#include "TRBeamModel.hpp"
+#include "TROdomEstimator.hpp"
+#include "TRImuFusion.hpp"
+#include "TRGps.hpp"
 #include "../pros/imu.hpp"
 #include "../EZ-Template/drive/drive.hpp"
 
@@ -15,6 +26,26 @@ struct tr_options
      * Sensor trust threshold on whether to use dsr if called. 0 is least trust and 1 is full trust.
      */
     const float sensor_trust = 1.0;
+
+    /**
+     * Largest correction in inches a reset may apply. 0 allows any correction.
+     */
+    const float max_correction = 0.0;
+
+    /**
+     * Largest disagreement in inches between a single beam and odometry. 0 allows any disagreement.
+     */
+    const float max_residual = 0.0;
+
+    /**
+     * Largest variance in square inches of either axis of a reset. 0 allows any variance.
+     */
+    const float max_variance = 0.0;
+
+    /**
+     * Share of the lateral correction fused each wall following step, from 0 to 1.
+     */
+    const float follow_gain = 0.2;
 };
 
 /**
@@ -22,77 +53,245 @@ struct tr_options
  */
 class tr_chassis
 {
+    friend class tr_field_map;
+    friend class tr_calibrator;
+    friend class tr_start_detector;
+    friend class tr_pose_tracker;
+
 public:
 
     /**
      * @brief Initialize the localization chassis
      * @note ONLY INITIALIZE THIS WHEN YOUR ROBOT IS NOT MOVING!
      *
-     * @param settings customizable trust and gain options for the localization algorithm
      * @param inertial pointer to the inertial sensor on the robot
-     * @param base pointer to the ez drive of the robot
+     * @param base pointer to the drivebase of the robot. Accepts an ez::Drive, okapi::OdomChassisController, okapi::Odometry, tr_pose or tr_drivebase_generic pointer, or any tr_drivebase_adapter.
      * @param sensors array of pointers to the localization sensors of the robot
+     * @param settings customizable trust and gain options for the localization algorithm
      */
-    tr_chassis(pros::Imu* inertial, ez::Drive* base, std::array<tr_sensor*,4> sensors);
+    tr_chassis(pros::Imu* inertial, tr_drivebase base, std::array<tr_sensor*,4> sensors, tr_options settings = tr_options());
 
     /**
-     * @brief Initialize the localization chassis
-     * @note ONLY INITIALIZE THIS WHEN YOUR ROBOT IS NOT MOVING!
+     * @brief Initialize the localization chassis with the fused heading of several IMUs
+     * @note The fused rotation is also written into the IMU of the drivebase every period, so odometry uses it too.
      *
-     * @param settings customizable trust and gain options for the localization algorithm
-     * @param inertial pointer to the inertial sensor on the robot
-     * @param base pointer to the lemlib chassis of the robot
+     * @param fusion fusion of the inertial sensors on the robot
+     * @param base pointer to the drivebase of the robot
      * @param sensors array of pointers to the localization sensors of the robot
+     * @param settings customizable trust and gain options for the localization algorithm
      */
-    tr_chassis(pros::Imu* inertial, tr_drivebase_generic* base, std::array<tr_sensor*,4> sensors);
+    tr_chassis(tr_imu_fusion* fusion, tr_drivebase base, std::array<tr_sensor*,4> sensors, tr_options settings = tr_options());
 
     /**
      * @brief Performs a distance sensor reset using the sensors on the robot given the robot already knows where it is and where it is facing.
      *
-     * @param trust_sensors Whether to ignore the sensor trust threshold defined in the options
-     * @return Whether the function decided to reset the location of the robot
+     * @return Result of the reset, including whether it was applied and why not
      */
-    void perform_dsr();
+    tr_dsr_result perform_dsr();
 
     /**
      * @brief Performs a distance sensor reset using the sensors on the robot given the robot does not know which quadrant it is in.
      * 
      * @note Use this function after a movement that performs an action such as driving over a parking zone which crosses quadrants.
      *
-     * @param quad The quadrant the robot is currently in
-     * @return Whether the function decided to reset the location of the robot
+     * @param quadrant The quadrant the robot is currently in
+     * @return Result of the reset, including whether it was applied and why not
      */
-    void perform_dsr_quad(tr_quadrant quadrant);
+    tr_dsr_result perform_dsr_quad(tr_quadrant quadrant);
+
+    /**
+     * @brief Queues a distance sensor reset on the TitanReset worker task and returns immediately.
+     * @note The quadrant is taken from odometry when the worker runs the reset.
+     *
+     * @return Handle that can be polled or waited on for the result
+     */
+    tr_dsr_handle perform_dsr_async();
+
+    /**
+     * @brief Queues a distance sensor reset in a known quadrant on the TitanReset worker task and returns immediately.
+     *
+     * @param quadrant The quadrant the robot is currently in
+     * @return Handle that can be polled or waited on for the result
+     */
+    tr_dsr_handle perform_dsr_quad_async(tr_quadrant quadrant);
+
+    /**
+     * @brief Schedules a reset for when the robot passes a point during a motion, without stopping.
+     *
+     * Semantics follow pid_wait_until_point: the point is passed once the robot crosses the line through it perpendicular to the approach from where the robot is now.
+     * After that the worker takes the reading on the fly as soon as the robot is square enough to the walls and not turning quickly.
+     * The reading is compared against the odometry pose from when it was taken, and the correction is added to the current pose.
+     *
+     * @note Schedule before starting the motion. Resets are performed in the order they were scheduled.
+     *
+     * @param point point on the field in inches
+     * @param timeout time in milliseconds to wait for the point and favourable beam geometry
+     * @return Handle that can be polled or waited on for the result. Rejected with REJECT_WAYPOINT_MISSED if the timeout runs out.
+     */
+    tr_dsr_handle perform_dsr_at_point(tr_vector2 point, uint32_t timeout = 3000);
+
+    /**
+     * @brief Schedules a reset for when the robot passes a point of an odometry path, without stopping.
+     *
+     * Semantics follow pid_wait_until_index: the approach to the point is from the previous point in the path, or from where the robot is now for the first point.
+     *
+     * @param path points of the motion, as given to pid_odom_set
+     * @param index index of the point in the path, 0 is the first point
+     * @param timeout time in milliseconds to wait for the point and favourable beam geometry
+     * @return Handle that can be polled or waited on for the result. Rejected with REJECT_WAYPOINT_MISSED if the timeout runs out or the index is out of range.
+     */
+    tr_dsr_handle perform_dsr_at_index(const std::vector<ez::odom>& path, int index, uint32_t timeout = 3000);
+
+    /**
+     * @brief Starts correcting lateral drift in the background during straight drive motions, without ever stopping.
+     *
+     * While pid_drive_set or a point to point motion runs parallel to a wall, the side beam is read every sensor update and follow_gain of its
+     * correction across the direction of travel is fused into odometry. The coordinate along the direction of travel is left to odometry.
+     * The side beam has to be valid and the lateral correction has to pass the trust policy.
+     *
+     * @note Only EZ-Template drivebases report their motions, so no other drivebase is ever corrected.
+     * @return Whether the wall follower is running
+     */
+    bool start_wall_following();
+
+    /**
+     * @brief Stops the wall follower and waits for its task to exit.
+     */
+    void stop_wall_following();
+
+    /**
+     * @brief Gets the wall follower to check its state and how many corrections it fused.
+     */
+    const tr_wall_follower& get_wall_follower();
+
+    /**
+     * @brief Starts detecting wheel slip, pushes and sensor faults in the background.
+     *
+     * The IMU acceleration is sampled every 10 ms and the disagreement between the sensors and odometry every sensor update. Poll the events
+     * from get_event_detector to re-localize right after contact instead of running the rest of the route offset.
+     *
+     * @note Corrections applied by TitanReset are taken out of the disagreement. Setting the pose from anywhere else reads as a divergence.
+     * @return Whether the event detector is running
+     */
+    bool start_event_detection();
+
+    /**
+     * @brief Stops the event detector and waits for its task to exit.
+     */
+    void stop_event_detection();
+
+    /**
+     * @brief Gets the event detector to poll its events and read its counters.
+     */
+    tr_event_detector& get_event_detector();
+
+    /**
+     * @brief Gets the estimate of systematic odometry error built from the corrections of applied resets.
+     * @note Every reset applied through the trust policy after the first adds the interval since the previous one. perform_dsr_init starts over from its pose.
+     */
+    const tr_odom_estimator& get_odometry_estimator();
+
+    /**
+     * @brief Applies a bounded step of the estimated scale correction to the drivebase.
+     *
+     * Nothing is changed until the scale error is significant. Without trackers the drive ratio is scaled, otherwise the wheel diameter of each tracker.
+     * Odometry sees the rescaled sensors as a jump on its next update, so the pose is held and restored after it.
+     *
+     * @note Call between motions while the robot is stopped. Only EZ-Template drivebases can be scaled, and nothing is changed while a motion or
+     * driver control runs or the drive wheels are still turning.
+     *
+     * @param trackers tracking wheels odometry uses, empty when it uses the drive motors
+     * @param max_step largest change of the scale, 0.01 is 1%
+     * @return Factor distances were multiplied by, 1 if nothing was changed
+     */
+    float apply_odometry_scale(const std::vector<ez::tracking_wheel*>& trackers = {}, float max_step = 0.01);
 
     /**
      * @brief Performs a distance sensor reset using the sensors on the robot given the robot does not know where it is and the sensors are fully trusted.
      * 
      * @note This will set the heading of the chassis and imu as it performs a distance sensor reset. 
-     * @warning This will always set the location of the robot. Use only in a situation where the robot starts in familliar place each time like the start of an auton.
+     * @warning This ignores the trust policy and sets the location of the robot unless a sensor cannot read or a beam is invalid. Use only in a situation where the robot starts in familliar place each time like the start of an auton.
      *
      * @param quadrant The quadrant the robot is currently in
      * @param heading The heading of the robot
+     * @return Result of the reset
+     */
+    tr_dsr_result perform_dsr_init(tr_quadrant quadrant, float heading);
+
+    /**
+     * @brief Fuses a GPS sensor into every reset. Pass nullptr to stop.
+     *
+     * Where the beams are usable, the GPS fix is gated against them per axis and averaged in weighted by the inverse of each variance, so near the
+     * walls the beams dominate. Where they are out of range, too steep or below the minimum confidence, as they are mid-field, the fix is used alone
+     * with a confidence from its error. Any other rejection, such as an impossible position, stands. Either way the result goes through the trust policy
+     * and sets GPS_SENSOR in the sensors used, and the counters of the GPS only count applied resets. The wall follower and the event detector only use the beams.
+     */
+    void set_gps(tr_gps* gps);
+
+    /**
+     * @brief Sets the alliance mirror between the frame odometry reports in and the field frame. Call once when the match is set up.
+     *
+     * Quadrants, headings and points passed to TitanReset are in the frame of odometry and are mirrored into the field frame, so mirrored routines
+     * reuse the same reset calls. Results, recordings and everything below the utilities note stay in the field frame.
+     */
+    void set_mirror(const tr_mirror& mirror);
+
+    /**
+     * @brief Sets the mirror to the odom_x_flip, odom_y_flip and odom_theta_flip EZ-Template odometry is set to. Call after flipping.
+     * @return Whether the drivebase exposes its flips, only EZ-Template does
      */
-    void perform_dsr_init(tr_quadrant quadrant, float heading);
+    bool sync_mirror();
+
+    const tr_mirror& get_mirror();
+
+    /**
+     * @brief Gets the trust policy built from the options, to evaluate results against the same thresholds.
+     */
+    const tr_trust_policy& get_trust_policy();
 
     /**
      * @breif Gets the robots quadrant based on its coordinates
-     * @return The quadrant of the robot
+     * @return The quadrant of the robot in the frame of odometry
      */
     tr_quadrant get_quadrant();
 
     /**
      * @brief Starts an odometry system and distance sensor system recording in a background task
+     * @note The date and time are copied into fixed buffers and truncated to 15 characters.
      *
-     * @param filename name of the file for the recording
+     * @param date date written into the recording header
+     * @param time time written into the recording header
      */
-    void start_location_recording(std::string date, std::string time);
+    void start_location_recording(const char* date, const char* time);
 
     /**
-     * @brief Stops the current odometry system recording
+     * @brief Stops the current odometry system recording. Buffered records are written before the recording task exits.
      */
     void stop_location_recording();
 
+    /**
+     * @brief Gets the location recorder to check its state and dropped sample count.
+     */
+    const tr_recorder& get_location_recorder();
+
+    /**
+     * @brief Loads the calibrated sensor mountings written by tr_calibrator. Call from initialize().
+     * @note Sensors without an entry keep their hand measured offsets.
+     *
+     * @param path path of the calibration file
+     * @return Amount of sensors that loaded a calibration
+     */
+    int load_calibration(const char* path = calibration_file);
+
+    /**
+     * @brief Loads the range and incidence correction table of every sensor. Call from initialize().
+     * @note Sensors without a table read uncorrected.
+     *
+     * @param format path of the table files, formatted with the sensor port
+     * @return Amount of sensors that loaded a table
+     */
+    int load_corrections(const char* format = correction_file_format);
+
     /*
     *   Note - Everything below this line is either utilities to aid with the implementation of TitanReset and are most likey irrelevant to your goals.
     */
@@ -115,6 +314,7 @@ public:
 
     /**
      * @brief Normalizes heading to the domain of 0-360. Also called finding the coterminal angle
+     * @note Runs in constant time through tr_angle regardless of how far the heading has wound up.
      * @param heading heading to normalize.
      * @return Normalized heading
      */
@@ -129,7 +329,11 @@ public:
      */
     static bool can_position_exist(tr_vector3 pose);
 
-    static std::string get_quadrant_string(tr_quadrant quadrant);
+    /**
+     * @brief Gets the name of a quadrant.
+     * @return Static string naming the quadrant
+     */
+    static const char* get_quadrant_string(tr_quadrant quadrant);
 
     /**
      * @brief Returns the relevant sensors based on the heading of the robot.
@@ -139,7 +343,7 @@ public:
     /**
      * @brief Returns the relevant sensors based on the heading of the robot.
      *
-     * Requires normalized heading 0-360 degrees.
+     * Accepts any heading, wrapping is handled by tr_angle.
      *
      * For 315 - 45 degrees: ++
      * For 45 - 135 degrees: -+
@@ -181,6 +385,17 @@ public:
      */
     static void shutdown_display();
 
+    /**
+     * @brief Gets the validity and variance of a beam from the last position calculation.
+     * @param beam beam index ordered north, east, south, west
+     */
+    tr_beam_quality get_beam_quality(int beam) const;
+
+    /**
+     * @brief Gets the validity limits and noise model of the beams.
+     */
+    const tr_beam_model& get_beam_model() const;
+
     /**
      * @breif Uses flags to return whether a sensor is being used.
      * @note Active sensors are set by performing a distance sensor reset.
@@ -198,9 +413,104 @@ private:
     */
 
     /**
-     * Location recording task pointer
+     * Location recorder
+     */
+    tr_recorder location_recorder;
+
+    /**
+     * Fills a location recording sample.
+     */
+    static void record_location(void* param, tr_record& record);
+
+    /**
+     * Worker performing asynchronous resets
      */
-    pros::Task* location_task;
+    tr_dsr_worker dsr_worker;
+
+    /**
+     * Performs a queued asynchronous reset.
+     */
+    static void execute_async_dsr(void* param, tr_dsr_slot& slot);
+
+    /**
+     * Wall follower and the pose of its previous step, which the readings of the current step were taken at.
+     */
+    tr_wall_follower wall_follower;
+    tr_pose follow_reference;
+    bool follow_primed;
+
+    /**
+     * Performs a wall following step.
+     */
+    static tr_follow_outcome follow_wall(void* param);
+
+    /**
+     * @brief Fuses the side beam into the coordinate across the direction of travel relative to an odometry pose.
+     */
+    tr_follow_outcome apply_lateral_correction(const tr_pose& reference);
+
+    /**
+     * @brief Gets the quadrant of the robot in the field frame.
+     */
+    tr_quadrant field_quadrant();
+
+    /**
+     * @brief Calculates the position in a quadrant and fills a result relative to an odometry pose without applying it. Callers hold dsr_mutex.
+     */
+    tr_dsr_result evaluate_dsr(tr_quadrant quadrant, float heading, tr_vector3 odom);
+
+    /**
+     * @brief Gates the GPS fix against the beams of a result and fuses it in, or replaces the result with it if the beams are unusable.
+     * @note A result rejected for anything but missing or invalid beams is left unchanged.
+     * @return How the fix took part, recorded on the GPS once the reset is applied
+     */
+    tr_gps_outcome fuse_gps(tr_gps* fix_gps, tr_dsr_result& result, const tr_pose& odom);
+
+    /**
+     * @brief Calculates the position in a quadrant and writes it to the drivebase if it passes the checks. Callers hold dsr_mutex.
+     * @param use_policy whether the trust policy has to accept the reset
+     * @param reference odometry pose the readings are compared against, the current pose if null
+     */
+    tr_dsr_result apply_dsr(tr_quadrant quadrant, bool use_policy, const tr_pose* reference = nullptr);
+
+    /**
+     * @brief Waits for the waypoint of a queued reset and performs it on the fly once the beam geometry is favourable.
+     */
+    tr_dsr_result apply_dsr_at_waypoint(tr_dsr_slot& slot);
+
+    /**
+     * @brief Calculates the position in a quadrant from the sensors. Callers hold dsr_mutex.
+     */
+    tr_conf_pair<tr_vector3> calculate_position(tr_quadrant quadrant, float heading);
+
+    /**
+     * Held over every position calculation and every reset, from reading the sensors to writing the pose. The worker, the wall follower, the event
+     * detector, the recorder and autonomous all share the members below and the pose of the drivebase.
+     */
+    mutable pros::Mutex dsr_mutex;
+
+    /**
+     * Sensor flags of the beams the last position calculation used for each axis and whether either could not read.
+     */
+    int x_beam;
+    int y_beam;
+    bool beam_error;
+
+    /**
+     * Heading corrected readings of the last position calculation ordered north, east, south, west, below zero if a sensor could not read.
+     */
+    float beam_lengths[4];
+
+    /**
+     * Corrected readings of the last position calculation along each beam from its sensor, err_reading_value if a sensor could not read.
+     */
+    float beam_readings[4];
+
+    /**
+     * Validity limits and noise model of the beams, and the rating of each beam from the last position calculation.
+     */
+    tr_beam_model beam_model;
+    tr_beam_quality beam_quality[4];
 
     /** 
      * Sensors
@@ -210,14 +520,64 @@ private:
     tr_sensor* south;
     tr_sensor* west;
     pros::Imu* imu;
+    tr_gps* gps;
+
+    /**
+     * Fusion writing into the IMU of the drivebase, detached when the chassis is destroyed. Null when constructed from a single IMU.
+     */
+    tr_imu_fusion* imu_fusion;
 
     /** 
-     * Drivebase reference
+     * Drivebase adapter
      */
-    tr_drivebase_generic* chassis;
+    tr_drivebase chassis;
 
     /**
      * Provided options
      */
     tr_options options;
+
+    /**
+     * Trust policy built from the options
+     */
+    tr_trust_policy trust_policy;
+
+    /**
+     * Pose before and after the last applied reset, the sensors and readings it used, and the amount of resets applied.
+     */
+    tr_vector3 last_reset_from;
+    tr_vector3 last_reset_to;
+    int last_reset_sensors;
+    float last_reset_beams[4];
+    uint32_t reset_count;
+
+    /**
+     * Event detector, the pose and total correction of its previous innovation sample, and the total of every correction TitanReset applied.
+     */
+    tr_event_detector event_detector;
+    tr_pose event_reference;
+    tr_vector2 event_reference_correction;
+    bool event_primed;
+    tr_vector2 correction_total;
+
+    /**
+     * Fills an event detector sample.
+     */
+    static void sample_events(void* param, tr_event_sample& sample);
+
+    /**
+     * Odometry error estimator, the pose and IMU rotation of the last applied reset it measures from, and the corrections the wall follower fused since.
+     */
+    tr_odom_estimator odom_estimator;
+    tr_vector3 estimator_anchor;
+    float anchor_rotation;
+    bool anchor_valid;
+    tr_vector2 follow_correction;
+
+    /**
+     * @brief Adds the interval since the last applied reset to the odometry estimator and measures the next one from the corrected pose.
+     * @param odom odometry pose the reset was compared against
+     * @param add whether the interval is added, or only the anchor moved
+     */
+    void record_interval(const tr_pose& odom, const tr_dsr_result& result, bool add);
 };
\ No newline at end of file
@@ -32,4 +32,14 @@ static constexpr float wall_coord = 70.208;
 /**
  * Domain of the confidence readings from the V5 Distance Sensor
  */
-static constexpr float confidence_domain = 63.0;
\ No newline at end of file
+static constexpr float confidence_domain = 63.0;
+
+/**
+ * File on the SD card holding the calibrated sensor mountings
+ */
+static constexpr const char* calibration_file = "/usd/tr_calibration.txt";
+
+/**
+ * Format of the per-sensor correction table files on the SD card, formatted with the sensor port
+ */
+static constexpr const char* correction_file_format = "/usd/tr_lut_%d.bin";
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <stdint.h>
+
+/*
+* Per-sensor range and incidence correction tables.
+*
+* Files are little endian: a tr_correction_header followed by range_bins * angle_bins int16 corrections in tenths of a millimetre, ordered [range][angle].
+* Axes are stored in raw millimetres and degrees of incidence, and converted to inches once when loaded.
+*/
+
+/**
+ * Header of a correction table file.
+ */
+struct tr_correction_header
+{
+    char magic[4];
+    uint16_t version;
+    uint16_t range_bins;
+    uint16_t angle_bins;
+    uint16_t reserved;
+    float range_min_mm;
+    float range_step_mm;
+    float angle_min_deg;
+    float angle_step_deg;
+};
+
+/**
+ * Logged reading with the distance it should have read, used to build a table.
+ */
+struct tr_correction_sample
+{
+    float raw_mm;
+    float incidence_deg;
+    float true_mm;
+};
+
+/**
+ * @brief Bilinear correction table of a single distance sensor indexed by reading and incidence angle.
+ *
+ * The table is held in a fixed array inside the object so lookups stay within a couple of kilobytes and never allocate.
+ */
+class tr_correction_table
+{
+public:
+
+    /**
+     * Largest table dimensions that can be loaded.
+     */
+    static constexpr int max_range_bins = 32;
+    static constexpr int max_angle_bins = 16;
+
+    /**
+     * File format version written and accepted.
+     */
+    static constexpr uint16_t version = 1;
+
+    /**
+     * @brief Constructs an empty table that applies no correction.
+     */
+    tr_correction_table();
+
+    /**
+     * @brief Whether a table is loaded.
+     */
+    bool is_loaded() const;
+
+    /**
+     * @brief Correction to add to a reading.
+     * @param reading reading in inches
+     * @param incidence angle between the beam and the wall normal in degrees, either sign
+     * @return Correction in inches, 0 if no table is loaded
+     */
+    float lookup(float reading, float incidence) const;
+
+    /**
+     * @brief Loads a table file.
+     * @return Whether the file was valid. An invalid file leaves the table empty.
+     */
+    bool load(const char* path);
+
+    /**
+     * @brief Builds a table file from logged readings. Nodes without nearby samples copy the nearest filled node at the same incidence.
+     *
+     * @param path path of the file to write
+     * @param samples logged readings
+     * @param count amount of samples
+     * @param range_bins amount of range nodes, up to max_range_bins
+     * @param range_min_mm reading of the first range node in millimetres
+     * @param range_step_mm spacing of the range nodes in millimetres
+     * @param angle_bins amount of incidence nodes, up to max_angle_bins
+     * @param angle_step_deg spacing of the incidence nodes in degrees, starting at 0
+     * @return Whether the file was written
+     */
+    static bool build(const char* path, const tr_correction_sample* samples, int count, int range_bins, float range_min_mm, float range_step_mm, int angle_bins, float angle_step_deg);
+
+private:
+
+    /**
+     * Corrections in inches ordered [range][angle].
+     */
+    float table[max_range_bins * max_angle_bins];
+
+    int range_bins;
+    int angle_bins;
+
+    /**
+     * Axes in inches and degrees with the inverse steps cached for the lookup.
+     */
+    float range_min;
+    float range_inv_step;
+    float angle_min;
+    float angle_inv_step;
+};
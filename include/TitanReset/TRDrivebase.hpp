@@ -0,0 +1,332 @@
+#pragma once
+
+#include "TRTypes.hpp"
+#include "TRMirror.hpp"
+#include <concepts>
+#include <new>
+#include <stddef.h>
+#include <type_traits>
+
+namespace ez
+{
+    class Drive;
+}
+
+namespace okapi
+{
+    class OdomChassisController;
+    class Odometry;
+    enum class StateMode;
+}
+
+/**
+ * Double precision pose used between TitanReset and the drivebase. Heading is in degrees, clockwise from +Y.
+ */
+struct tr_pose
+{
+    double x;
+    double y;
+    double theta;
+
+    /**
+     * @brief Converts the pose to the float vector used by the TitanReset geometry.
+     */
+    tr_vector3 to_vector() const
+    {
+        return tr_vector3(x, y, theta);
+    }
+};
+
+/**
+ * Requirements of a drivebase adapter. Adapters are small structs holding a pointer to the drivebase.
+ */
+template<typename T>
+concept tr_drivebase_adapter = requires(const T adapter, tr_pose pose)
+{
+    { adapter.get_pose() } -> std::same_as<tr_pose>;
+    adapter.set_pose(pose);
+};
+
+/**
+ * @brief EZ-Template drivebase adapter.
+ */
+struct tr_ez_drivebase
+{
+    ez::Drive* drive;
+
+    tr_pose get_pose() const;
+    void set_pose(tr_pose pose) const;
+
+    /**
+     * @brief Whether a straight drive motion, pid_drive_set or a point to point motion, is running.
+     */
+    bool is_driving() const;
+
+    /**
+     * @brief Whether no motion is running and the drive wheels are still.
+     */
+    bool is_stopped() const;
+
+    /**
+     * @brief Multiplies the distances the drive motors report by a factor through the drive ratio.
+     */
+    void scale_distance(double factor) const;
+
+    /**
+     * @brief Builds the mirror matching the flips odometry is set to.
+     */
+    tr_mirror get_mirror() const;
+
+    /**
+     * @brief Sets the rotation of the IMU the drive reads, undoing its IMU scaler.
+     */
+    void set_rotation(double rotation) const;
+
+    /**
+     * @brief Gets the rotation the drive reads from its IMU, with its IMU scaler applied.
+     */
+    double get_rotation() const;
+
+    uint8_t get_imu_port() const;
+};
+
+/**
+ * @brief okapi odometry chassis controller adapter. Converts okapi's frame transformation state into the TitanReset frame.
+ */
+struct tr_okapi_drivebase
+{
+    okapi::OdomChassisController* controller;
+
+    tr_pose get_pose() const;
+    void set_pose(tr_pose pose) const;
+};
+
+/**
+ * @brief okapi odometry adapter for Odometry implementations such as ThreeEncoderOdometry, used without a chassis controller.
+ *
+ * The state is read and written in the given StateMode and converted to the TitanReset frame, which matches okapi's CARTESIAN mode.
+ */
+struct tr_okapi_odometry_drivebase
+{
+    okapi::Odometry* odometry;
+    okapi::StateMode mode;
+
+    tr_pose get_pose() const;
+    void set_pose(tr_pose pose) const;
+};
+
+/**
+ * @brief Adapter for a plain pose maintained by user code.
+ */
+struct tr_struct_drivebase
+{
+    tr_pose* pose;
+
+    tr_pose get_pose() const
+    {
+        return *pose;
+    }
+
+    void set_pose(tr_pose new_pose) const
+    {
+        *pose = new_pose;
+    }
+};
+
+/**
+ * @brief Adapter for the virtual tr_drivebase_generic interface. Use for drivebases without a built in adapter.
+ */
+struct tr_virtual_drivebase
+{
+    tr_drivebase_generic* base;
+
+    tr_pose get_pose() const
+    {
+        tr_vector3 pose = base->getPose();
+        return {pose.x, pose.y, pose.z};
+    }
+
+    void set_pose(tr_pose pose) const
+    {
+        base->setPose(pose.to_vector());
+    }
+};
+
+/**
+ * @brief Any other adapter satisfying tr_drivebase_adapter, copied into inline storage and called through static thunks.
+ *
+ * The thunks are instantiated per adapter type when tr_drivebase is constructed, so there is no heap and no vtable, only one indirect call.
+ */
+struct tr_custom_drivebase
+{
+    /**
+     * Largest adapter in bytes that fits the inline storage.
+     */
+    static constexpr size_t max_size = 4 * sizeof(void*);
+
+    alignas(max_align_t) unsigned char storage[max_size];
+    tr_pose (*get)(const void* adapter);
+    void (*set)(const void* adapter, tr_pose pose);
+
+    tr_pose get_pose() const
+    {
+        return get(storage);
+    }
+
+    void set_pose(tr_pose pose) const
+    {
+        set(storage, pose);
+    }
+};
+
+static_assert(tr_drivebase_adapter<tr_ez_drivebase>);
+static_assert(tr_drivebase_adapter<tr_okapi_drivebase>);
+static_assert(tr_drivebase_adapter<tr_okapi_odometry_drivebase>);
+static_assert(tr_drivebase_adapter<tr_struct_drivebase>);
+static_assert(tr_drivebase_adapter<tr_virtual_drivebase>);
+static_assert(tr_drivebase_adapter<tr_custom_drivebase>);
+
+/**
+ * Kinds of drivebase adapters.
+ */
+enum tr_drivebase_kind
+{
+    DRIVEBASE_EZ,
+    DRIVEBASE_OKAPI,
+    DRIVEBASE_OKAPI_ODOMETRY,
+    DRIVEBASE_STRUCT,
+    DRIVEBASE_VIRTUAL,
+    DRIVEBASE_CUSTOM,
+};
+
+/**
+ * @brief Drivebase used by tr_chassis.
+ *
+ * Holds one of the adapters by value and dispatches with a switch. Built in adapters are called directly and keep the pose in double precision.
+ * Only drivebases passed as tr_drivebase_generic go through a virtual call.
+ * Constructs implicitly from any supported drivebase pointer. okapi Odometry defaults to the FRAME_TRANSFORMATION mode okapi itself defaults to.
+ * Also constructs from any adapter satisfying tr_drivebase_adapter, which is held inline and called through a static thunk.
+ * Poses are mirrored between the frame of the adapter and the field frame, so callers always see the field frame.
+ */
+class tr_drivebase
+{
+public:
+    tr_drivebase(ez::Drive* drive);
+    tr_drivebase(okapi::OdomChassisController* controller);
+    tr_drivebase(okapi::Odometry* odometry);
+    tr_drivebase(okapi::Odometry* odometry, okapi::StateMode mode);
+    tr_drivebase(tr_pose* pose);
+    tr_drivebase(tr_drivebase_generic* base);
+
+    /**
+     * @brief Wraps an adapter. The EZ-Template adapter keeps its motion and IMU support, any other adapter only provides the pose.
+     * @note Adapters have to be trivially copyable and fit tr_custom_drivebase::max_size, like the built in ones holding a pointer.
+     */
+    template<tr_drivebase_adapter Adapter>
+    requires (!std::is_same_v<Adapter, tr_drivebase>)
+    tr_drivebase(Adapter adapter) : kind(DRIVEBASE_CUSTOM), custom_base()
+    {
+        if constexpr (std::is_same_v<Adapter, tr_ez_drivebase>)
+        {
+            kind = DRIVEBASE_EZ;
+            ez_base = adapter;
+        }
+        else
+        {
+            static_assert(sizeof(Adapter) <= tr_custom_drivebase::max_size, "TitanReset drivebase adapters have to fit tr_custom_drivebase::max_size");
+            static_assert(alignof(Adapter) <= alignof(max_align_t), "TitanReset drivebase adapters cannot be over aligned");
+            static_assert(std::is_trivially_copyable_v<Adapter>, "TitanReset drivebase adapters have to be trivially copyable");
+
+            new (custom_base.storage) Adapter(adapter);
+            custom_base.get = [](const void* held) { return static_cast<const Adapter*>(held)->get_pose(); };
+            custom_base.set = [](const void* held, tr_pose pose) { static_cast<const Adapter*>(held)->set_pose(pose); };
+        }
+    }
+
+    /**
+     * @brief Gets the pose of the drivebase in the field frame.
+     */
+    tr_pose get_pose() const;
+
+    /**
+     * @brief Sets the pose of the drivebase from a pose in the field frame.
+     */
+    void set_pose(tr_pose pose) const;
+
+    /**
+     * @brief Sets the mirror between the frame of the adapter and the field frame.
+     */
+    void set_mirror(const tr_mirror& new_mirror);
+
+    /**
+     * @brief Sets the mirror to the flips odometry is set to.
+     * @note Only EZ-Template exposes its flips. Every other drivebase keeps its mirror.
+     * @return Whether the mirror was read from the drivebase
+     */
+    bool sync_mirror();
+
+    const tr_mirror& get_mirror() const
+    {
+        return mirror;
+    }
+
+    /**
+     * @brief Whether the drivebase is running a straight drive motion.
+     * @note Only EZ-Template reports its motions. Every other drivebase always returns false.
+     */
+    bool is_driving() const;
+
+    /**
+     * @brief Whether no motion is running and the drive wheels are still.
+     * @note Only EZ-Template reports its motions. Every other drivebase always returns false.
+     */
+    bool is_stopped() const;
+
+    /**
+     * @brief Multiplies the distances odometry measures by a factor.
+     * @note Only EZ-Template exposes its drive ratio. Every other drivebase is left unchanged.
+     * @return Whether the drivebase was scaled
+     */
+    bool scale_distance(double factor) const;
+
+    /**
+     * @brief Sets the rotation of the IMU odometry reads, clockwise in degrees and never mirrored.
+     * @note Only EZ-Template exposes its IMU. Every other drivebase is left unchanged.
+     * @return Whether the rotation was set
+     */
+    bool set_rotation(double rotation) const;
+
+    /**
+     * @brief Gets the rotation of the IMU odometry reads, clockwise in degrees and never mirrored.
+     * @note Only EZ-Template exposes its IMU. Every other drivebase leaves the rotation unchanged.
+     * @return Whether the rotation was read
+     */
+    bool get_rotation(double& rotation) const;
+
+    /**
+     * @brief Port of the IMU odometry reads, 0 if the drivebase does not expose one.
+     */
+    uint8_t get_imu_port() const;
+
+    /**
+     * @brief Gets the kind of adapter in use.
+     */
+    tr_drivebase_kind get_kind() const
+    {
+        return kind;
+    }
+
+private:
+    tr_drivebase_kind kind;
+    tr_mirror mirror;
+
+    union
+    {
+        tr_ez_drivebase ez_base;
+        tr_okapi_drivebase okapi_base;
+        tr_okapi_odometry_drivebase okapi_odometry_base;
+        tr_struct_drivebase struct_base;
+        tr_virtual_drivebase virtual_base;
+        tr_custom_drivebase custom_base;
+    };
+};
@@ -0,0 +1,250 @@
+#pragma once
+
+#include "TRTypes.hpp"
+#include "../pros/rtos.hpp"
+#include <atomic>
+
+/**
+ * Kinds of events the event detector reports.
+ */
+enum tr_event_kind
+{
+    /**
+     * Odometry diverged from the sensors without a collision, the wheels slipped.
+     */
+    EVENT_SLIP,
+
+    /**
+     * Odometry diverged from the sensors right after an acceleration spike, the robot was pushed or hit something.
+     */
+    EVENT_PUSH,
+
+    /**
+     * An assigned beam lost its reading or jumped for a single sample, the sensors are not to be trusted.
+     */
+    EVENT_SENSOR_FAULT,
+};
+
+/**
+ * Detected event.
+ */
+struct tr_event
+{
+    tr_event_kind kind;
+
+    /**
+     * Time the event was detected in milliseconds.
+     */
+    uint32_t time;
+
+    /**
+     * Change of the disagreement between the sensors and odometry that triggered the event in inches.
+     */
+    tr_vector2 divergence;
+
+    /**
+     * Largest planar acceleration of the robot in g within the acceleration window.
+     */
+    float accel;
+};
+
+/**
+ * Single sample of the detector inputs.
+ */
+struct tr_event_sample
+{
+    uint32_t time;
+
+    /**
+     * Planar acceleration of the robot in g.
+     */
+    float accel;
+
+    /**
+     * Set by the detector when it wants the innovation filled in, left set by the source if it did.
+     */
+    bool has_innovation;
+
+    /**
+     * Whether an assigned beam could not read.
+     */
+    bool reading_lost;
+
+    /**
+     * Whether the innovation comes from valid beams with enough confidence.
+     */
+    bool valid;
+
+    /**
+     * Position from the sensors minus odometry without any TitanReset corrections in inches, and its variance in square inches.
+     */
+    tr_vector2 innovation;
+    tr_vector2 variance;
+};
+
+/**
+ * Function filling a sample. Context is the pointer given to the detector.
+ */
+typedef void (*tr_event_source)(void* context, tr_event_sample& sample);
+
+/**
+ * States of the event detector.
+ */
+enum tr_detector_state
+{
+    /**
+     * Detector has never been started.
+     */
+    DETECTOR_IDLE,
+
+    /**
+     * Detector task is sampling.
+     */
+    DETECTOR_RUNNING,
+
+    /**
+     * Task has exited. The detector can be started again.
+     */
+    DETECTOR_STOPPED,
+};
+
+/**
+ * @brief Detects wheel slip, pushes and sensor faults from the innovation sequence of the distance sensors and the IMU acceleration.
+ *
+ * The innovation is compared against itself a window earlier, so slow odometry drift and the corrections TitanReset applies never trigger.
+ * A change that passes both the distance floor and the chi-square gate for a few samples in a row is a push if the acceleration spiked
+ * shortly before, and slip otherwise. Each divergence is reported once, until the innovation settles again.
+ *
+ * Events are kept in a fixed single producer, single consumer queue. When it is full new events are dropped but still counted.
+ */
+class tr_event_detector
+{
+public:
+
+    /**
+     * Period between acceleration samples in milliseconds, and the amount of periods between innovation samples, the update rate of the V5 Distance Sensor.
+     */
+    static constexpr uint32_t period = 10;
+    static constexpr int innovation_periods = 3;
+
+    /**
+     * Amount of innovation samples the innovation is compared back over, about half a second.
+     */
+    static constexpr int window_samples = 16;
+
+    /**
+     * Smallest change of the innovation in inches and its chi-square gate, 99% for two degrees of freedom.
+     */
+    static constexpr float min_divergence = 2.0f;
+    static constexpr float divergence_gate = 9.21f;
+
+    /**
+     * Amount of innovation samples in a row a divergence has to last to be reported.
+     */
+    static constexpr int persist_samples = 3;
+
+    /**
+     * Planar acceleration in g above what the drive produces on its own, and the time in milliseconds a spike is tied to a divergence after it.
+     */
+    static constexpr float push_accel = 0.8f;
+    static constexpr uint32_t accel_window = 300;
+
+    /**
+     * Largest change of the innovation in inches between two samples the robot can produce, and the amount of samples in a row a beam may lose its reading.
+     */
+    static constexpr float max_jump = 4.0f;
+    static constexpr int fault_samples = 10;
+
+    /**
+     * Amount of events the queue holds.
+     */
+    static constexpr int queue_size = 16;
+
+    /**
+     * @brief Constructs a detector.
+     * @param source function filling each sample
+     * @param context pointer passed to the source
+     */
+    tr_event_detector(tr_event_source source, void* context);
+
+    /**
+     * @brief Starts detecting. Does nothing if the detector is already running.
+     * @return Whether the detector is running
+     */
+    bool start();
+
+    /**
+     * @brief Requests the detector to stop and waits for its task to exit.
+     * @param timeout maximum time to wait in milliseconds
+     * @return Whether the detector reached the stopped state within the timeout
+     */
+    bool stop(uint32_t timeout = 1000);
+
+    /**
+     * @brief Gets the current state of the detector.
+     */
+    tr_detector_state get_state() const;
+
+    /**
+     * @brief Feeds one sample through the classification. Called by the detector task every period.
+     */
+    void update(const tr_event_sample& sample);
+
+    /**
+     * @brief Takes the oldest event off of the queue.
+     * @param event filled with the event
+     * @return Whether there was an event
+     */
+    bool poll(tr_event& event);
+
+    /**
+     * @brief Amount of events of a kind detected since the detector was constructed.
+     */
+    uint32_t get_count(tr_event_kind kind) const;
+
+    /**
+     * @brief Amount of events dropped because the queue was full.
+     */
+    uint32_t get_dropped() const;
+
+    /**
+     * @brief Discards the innovation history, for when the pose was set from outside of TitanReset.
+     */
+    void clear_history();
+
+private:
+
+    static void task_body(void* param);
+
+    void run();
+    void emit(tr_event_kind kind, uint32_t time, tr_vector2 divergence);
+
+    tr_event_source source;
+    void* context;
+
+    std::atomic<tr_detector_state> state;
+    std::atomic<bool> stop_requested;
+    std::atomic<bool> clear_requested;
+
+    /**
+     * Innovation history, oldest first once full.
+     */
+    tr_vector2 history[window_samples + 1];
+    int history_count;
+    int history_head;
+
+    int diverged_samples;
+    int lost_samples;
+    bool latched;
+
+    uint32_t spike_time;
+    float spike_accel;
+    bool spiked;
+
+    tr_event queue[queue_size];
+    std::atomic<int> queue_head;
+    std::atomic<int> queue_tail;
+
+    std::atomic<uint32_t> counts[3];
+    std::atomic<uint32_t> dropped;
+};
@@ -0,0 +1,241 @@
+#pragma once
+
+#include "TRTypes.hpp"
+#include <stdint.h>
+
+struct _lv_obj_t;
+class tr_chassis;
+
+/**
+ * Pixel rectangle with inclusive bounds used for dirty-rectangle tracking.
+ */
+struct tr_rect
+{
+    int16_t x1;
+    int16_t y1;
+    int16_t x2;
+    int16_t y2;
+
+    /**
+     * @brief Whether the rectangle contains no pixels.
+     */
+    bool empty() const
+    {
+        return x2 < x1 || y2 < y1;
+    }
+
+    /**
+     * @brief Grows the rectangle so it also covers another rectangle.
+     * @param other rectangle to merge in
+     */
+    void join(const tr_rect& other)
+    {
+        if (other.empty()) return;
+        if (empty())
+        {
+            *this = other;
+            return;
+        }
+        if (other.x1 < x1) x1 = other.x1;
+        if (other.y1 < y1) y1 = other.y1;
+        if (other.x2 > x2) x2 = other.x2;
+        if (other.y2 > y2) y2 = other.y2;
+    }
+};
+
+/**
+ * Rectangle that contains nothing. Joining anything into it yields the other rectangle.
+ */
+static constexpr tr_rect tr_rect_empty = {0, 0, -1, -1};
+
+/**
+ * @brief Off-screen rasterizer used by the field map.
+ *
+ * Draws into a caller provided 32 bit pixel buffer and records the bounding box of everything drawn since the last call to take_dirty().
+ * Holds no LVGL state so it can be driven against any buffer.
+ */
+class tr_field_canvas
+{
+public:
+
+    /**
+     * @brief Constructs a canvas over an existing buffer.
+     * @param buffer pixel buffer of at least width * height entries
+     * @param width width in pixels
+     * @param height height in pixels
+     */
+    tr_field_canvas(uint32_t* buffer, int16_t width, int16_t height);
+
+    /**
+     * @brief Fills the whole buffer with a color and marks it dirty.
+     */
+    void fill(uint32_t color);
+
+    /**
+     * @brief Sets a single pixel. Pixels outside the buffer are ignored.
+     */
+    void set_px(int16_t x, int16_t y, uint32_t color);
+
+    /**
+     * @brief Draws a line using Bresenham's algorithm.
+     */
+    void draw_line(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint32_t color);
+
+    /**
+     * @brief Draws a filled square centered on a pixel.
+     * @param radius half width of the square in pixels
+     */
+    void draw_dot(int16_t x, int16_t y, int16_t radius, uint32_t color);
+
+    /**
+     * @brief Copies a region from another buffer of identical size, used to erase the previous overlay.
+     * @param source buffer to copy from
+     * @param area region to copy
+     */
+    void restore(const uint32_t* source, tr_rect area);
+
+    /**
+     * @brief Returns the region drawn since the last call and resets it.
+     */
+    tr_rect take_dirty();
+
+    /**
+     * @brief Clips a rectangle to the buffer bounds.
+     */
+    tr_rect clip(tr_rect area) const;
+
+    int16_t get_width() const { return width; }
+    int16_t get_height() const { return height; }
+    const uint32_t* get_buffer() const { return buffer; }
+
+private:
+    uint32_t* buffer;
+    int16_t width;
+    int16_t height;
+    tr_rect dirty;
+};
+
+/**
+ * Everything the field map needs to draw a single frame.
+ */
+struct tr_field_frame
+{
+    /**
+     * Odometry pose of the robot.
+     */
+    tr_vector3 odom_pose;
+
+    /**
+     * Pose calculated from the distance sensors.
+     */
+    tr_vector3 dsr_pose;
+
+    /**
+     * Sensor flags of the beams used by the last reset.
+     */
+    int active_sensors;
+
+    /**
+     * Heading corrected readings of the sensors, ordered north, east, south, west, drawn from the dsr pose. Values below zero are not drawn.
+     */
+    float beam_lengths[4];
+};
+
+/**
+ * @brief LVGL field map widget that draws the field, the robot footprint, active sensor beams, dsr and odometry poses and a trail of corrections.
+ *
+ * The static field is drawn once into a background buffer. Each update erases the previous overlay from the background and only invalidates the union of the old and new overlay bounds.
+ */
+class tr_field_map
+{
+public:
+
+    /**
+     * Canvas size in pixels. The field is square so a single value is used for both axes.
+     */
+    static constexpr int16_t size = 200;
+
+    /**
+     * Amount of corrections kept in the trail.
+     */
+    static constexpr int trail_length = 16;
+
+    /**
+     * @brief Constructs the field map.
+     * @param robot_size robot footprint in inches with X being the width and Y being the length
+     */
+    tr_field_map(tr_vector2 robot_size);
+
+    tr_field_map(const tr_field_map&) = delete;
+    tr_field_map& operator=(const tr_field_map&) = delete;
+
+    /**
+     * @brief Creates the LVGL canvas on a parent object.
+     * @param parent parent LVGL object, usually lv_scr_act()
+     * @param x x position on the parent
+     * @param y y position on the parent
+     */
+    void create(_lv_obj_t* parent, int16_t x, int16_t y);
+
+    /**
+     * @brief Draws a frame and invalidates only the changed region of the canvas.
+     */
+    void update(const tr_field_frame& frame);
+
+    /**
+     * @brief Collects a frame from a TitanReset chassis and draws it.
+     * @note The dsr pose and beams are those of the last applied reset. Until the first reset the dsr pose follows odometry.
+     */
+    void update(tr_chassis* chassis);
+
+    /**
+     * @brief Records a correction from an odometry pose to a dsr pose in the trail.
+     */
+    void push_correction(tr_vector3 from, tr_vector3 to);
+
+    /**
+     * @brief Draws a frame into the off-screen buffer without touching LVGL.
+     * @return Region of the buffer that changed
+     */
+    tr_rect render(const tr_field_frame& frame);
+
+    /**
+     * @brief Converts a field coordinate in inches to a pixel coordinate, clamped to one canvas width beyond each edge.
+     */
+    static int16_t to_px_x(float x);
+    static int16_t to_px_y(float y);
+
+    const uint32_t* get_buffer() const { return canvas.get_buffer(); }
+
+private:
+
+    void draw_background();
+    void draw_robot(tr_vector3 pose, uint32_t color);
+
+    /**
+     * Static field drawing used to erase the previous overlay.
+     */
+    uint32_t background[size * size];
+
+    /**
+     * Buffer displayed by the LVGL canvas.
+     */
+    uint32_t pixels[size * size];
+
+    tr_field_canvas canvas;
+    tr_vector2 robot_size;
+    _lv_obj_t* lv_canvas;
+    tr_rect last_overlay;
+
+    /**
+     * Ring buffer of corrections.
+     */
+    std::array<std::pair<tr_vector3, tr_vector3>, trail_length> trail;
+    int trail_head;
+    int trail_count;
+
+    /**
+     * Reset count of the chassis when the last correction was pushed.
+     */
+    uint32_t seen_resets;
+};
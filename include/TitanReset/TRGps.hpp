@@ -0,0 +1,202 @@
+#pragma once
+
+#include "TRTypes.hpp"
+#include <atomic>
+#include <stdint.h>
+
+/**
+ * Reading of a GPS sensor in the frame of the field code it sees, which is how the sensor reports it.
+ */
+struct tr_gps_reading
+{
+    /**
+     * Whether the sensor answered with a position.
+     */
+    bool valid;
+
+    /**
+     * Position of the sensor in inches from the center of the field.
+     */
+    tr_vector2 position;
+
+    /**
+     * Heading of the sensor in degrees, clockwise from north of the field code.
+     */
+    float heading;
+
+    /**
+     * Root mean square error of the position the sensor reports in inches.
+     */
+    float error;
+};
+
+/**
+ * Pose of the robot measured by a GPS sensor, in the field frame.
+ */
+struct tr_gps_fix
+{
+    /**
+     * Position of the center of the robot in inches.
+     */
+    tr_vector2 position;
+
+    /**
+     * Heading of the robot in degrees, from the heading of the sensor.
+     */
+    float heading;
+
+    /**
+     * Variance of either axis of the position in square inches.
+     */
+    float variance;
+
+    /**
+     * Confidence from 0 to 1, min_error over the error of the fix, which the trust policy checks when the fix is used alone.
+     */
+    tr_probability confidence;
+};
+
+/**
+ * How a GPS fix took part in a reset.
+ */
+enum tr_gps_outcome
+{
+    /**
+     * There was no usable fix, or the beams were rejected for a reason the fix cannot stand in for.
+     */
+    GPS_UNUSED,
+
+    /**
+     * The fix was fused into the beams.
+     */
+    GPS_FUSED,
+
+    /**
+     * The fix was used alone, as the beams were unusable.
+     */
+    GPS_ALONE,
+
+    /**
+     * The fix was left out for disagreeing with the beams.
+     */
+    GPS_GATED,
+};
+
+/**
+ * Backend a GPS reading is taken from, called with the parameter it was registered with.
+ */
+typedef tr_gps_reading (*tr_gps_read_fn)(void* param);
+
+/**
+ * @brief V5 GPS Sensor used as a position source alongside the distance sensor resets.
+ *
+ * The sensor reports its own position in the frame of the field code. The position is turned into the field frame by whole quarter turns, then the
+ * mounting offset is taken out along the heading of odometry, which is steadier than the heading of the sensor. The variance of a fix is the square of the
+ * error the sensor reports, no smaller than min_error, and its confidence is min_error over that error.
+ *
+ * Readings come from a backend, the V5 GPS Sensor on a port or any function returning a tr_gps_reading, such as tr_simulated_gps in tools/tests on a host.
+ */
+class tr_gps
+{
+    friend class tr_chassis;
+
+public:
+
+    /**
+     * Smallest error in inches a fix is weighed with, as the sensor reports less than it achieves while still, and the largest error it is used at.
+     */
+    static constexpr float min_error = 0.5f;
+    static constexpr float max_error = 4.0f;
+
+    /**
+     * Largest chi-square per axis of the disagreement between a fix and the beams for the two to be fused. A fix past it is left out of the reset.
+     */
+    static constexpr float gate_chi_square = 9.0f;
+
+    /**
+     * @brief Constructs a GPS on a port.
+     * @note Offsets should be done in inches.
+     *
+     * @param port port of the GPS sensor
+     * @param offset offset of the sensor from the center of the robot, with X to the right of the robot and Y ahead of it
+     * @param yaw mounting yaw of the sensor in degrees, clockwise from the front of the robot
+     * @param field_rotation quarter turns clockwise from the frame of the field code to the field frame TitanReset works in
+     */
+    tr_gps(uint8_t port, tr_vector2 offset, float yaw = 0, int field_rotation = 0);
+
+    /**
+     * @brief Constructs a GPS reading from another backend.
+     * @param read function returning a reading, called with param
+     */
+    tr_gps(tr_gps_read_fn read, void* param, tr_vector2 offset, float yaw = 0, int field_rotation = 0);
+
+    /**
+     * @brief Clears the offset set on the device, as the offset is taken out by TitanReset. Call from initialize().
+     * @return Whether the device accepted it, always true for other backends
+     */
+    bool initialize();
+
+    /**
+     * @brief Takes a reading from the backend.
+     */
+    tr_gps_reading read() const;
+
+    /**
+     * @brief Measures the pose of the robot.
+     * @param heading heading of odometry in degrees in the field frame, which the mounting offset is taken out along
+     * @param fix filled with the pose if the reading is usable
+     * @return Whether the sensor answered with an error no larger than max_error
+     */
+    bool measure(float heading, tr_gps_fix& fix) const;
+
+    /**
+     * @brief Gets the offset of the sensor from the center of the robot.
+     */
+    tr_vector2 get_offset() const;
+
+    float get_yaw() const;
+
+    /**
+     * @brief Gets the port of the GPS sensor, 0 for other backends.
+     */
+    uint8_t get_port() const;
+
+    /**
+     * @brief Applied resets the fix was fused into together with the beams.
+     */
+    uint32_t get_fused() const;
+
+    /**
+     * @brief Applied resets the fix was used for alone, as the beams were unusable.
+     */
+    uint32_t get_alone() const;
+
+    /**
+     * @brief Applied resets the fix was left out of for disagreeing with the beams.
+     */
+    uint32_t get_gated() const;
+
+private:
+
+    /**
+     * @brief Counts how the fix took part in a reset once it is applied.
+     */
+    void record(tr_gps_outcome outcome);
+
+    /**
+     * @brief Reads the V5 GPS Sensor on the port of the GPS passed as the parameter.
+     */
+    static tr_gps_reading read_device(void* param);
+
+    tr_gps_read_fn read_fn;
+    void* read_param;
+    uint8_t port;
+
+    tr_vector2 offset;
+    float yaw;
+    int field_rotation;
+
+    std::atomic<uint32_t> fused;
+    std::atomic<uint32_t> alone;
+    std::atomic<uint32_t> gated;
+};
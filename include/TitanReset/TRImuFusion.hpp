@@ -0,0 +1,289 @@
+#pragma once
+
+#include "TRTypes.hpp"
+#include "../pros/imu.hpp"
+#include "../pros/rtos.hpp"
+#include <atomic>
+#include <stdint.h>
+#include <vector>
+
+class tr_drivebase;
+
+/**
+ * Health of a fused IMU.
+ */
+enum tr_imu_health
+{
+    /**
+     * The unit is fused.
+     */
+    IMU_HEALTHY,
+
+    /**
+     * The unit is calibrating and is fused again once it is done.
+     */
+    IMU_CALIBRATING,
+
+    /**
+     * The unit does not answer and is fused again once it reconnects.
+     */
+    IMU_DISCONNECTED,
+
+    /**
+     * The unit turned differently from the others. It stays rejected until the units are calibrated again.
+     */
+    IMU_DISAGREEING,
+};
+
+/**
+ * State of a single fused IMU.
+ */
+struct tr_imu_unit
+{
+    uint8_t port;
+    tr_imu_health health;
+
+    /**
+     * Last rotation the unit reported in degrees, and whether there is one to take the next change from.
+     */
+    double last_rotation;
+    bool primed;
+
+    /**
+     * Estimated gyro bias in degrees per second and its variance.
+     */
+    float bias;
+    float bias_variance;
+
+    /**
+     * Estimated gyro scale relative to the other units, and the regression sums it is solved from.
+     */
+    float scale;
+    float scale_xy;
+    float scale_xx;
+
+    /**
+     * Leaky integral in degrees of how much the unit turned differently from the median of the units.
+     */
+    float divergence;
+};
+
+/**
+ * States of the IMU fusion.
+ */
+enum tr_fusion_state
+{
+    /**
+     * Fusion has never been started.
+     */
+    FUSION_IDLE,
+
+    /**
+     * Fusion task is integrating the units.
+     */
+    FUSION_RUNNING,
+
+    /**
+     * Task has exited. The fusion can be started again.
+     */
+    FUSION_STOPPED,
+};
+
+/**
+ * @brief Fuses the heading of several V5 Inertial Sensors, estimating the gyro bias and scale of each.
+ *
+ * Every period the change of each unit is corrected for its bias and scale and the units are averaged, weighted by the certainty of their bias.
+ * While every unit reads still the robot is taken to be still, the fused heading holds and a scalar Kalman filter per unit learns its bias.
+ * While the robot turns quickly each scale is regressed against the others, normalized so the scales average to one. Absolute scale needs an
+ * external reference, the units only correct each other.
+ *
+ * A unit that stops answering or starts calibrating is left out until it is back. With three or more units, one that turns differently from the
+ * median of the units by more than the divergence limit is rejected until the units are calibrated again. Two units cannot outvote each other, so they are always both fused.
+ *
+ * The fusion is a pros::Imu, so it can be passed to tr_chassis in place of a single IMU. The fused rotation can also be written into the IMU of an
+ * EZ-Template drivebase every period, so its odometry and turns use it too. When anything else writes into that IMU, such as EZ-Template resetting
+ * or setting its heading, what it reads moves away from the rotation written last period by more than the units turned since. The fused rotation
+ * then continues from what the drivebase reads and the jump is kept out of the fusion. With the drivebase IMU as the only unit, a write smaller
+ * than the IMU can turn in one period is fused as turning, which lands on the same rotation.
+ */
+class tr_imu_fusion : public pros::Imu
+{
+public:
+
+    /**
+     * Largest amount of units that can be fused.
+     */
+    static constexpr int max_imus = 4;
+
+    /**
+     * Period between updates in milliseconds, the update rate of the V5 Inertial Sensor.
+     */
+    static constexpr uint32_t period = 10;
+
+    /**
+     * Largest rate in degrees per second every unit has to read, and the time in milliseconds it has to last, for the robot to count as still.
+     */
+    static constexpr float still_rate = 0.5f;
+    static constexpr uint32_t still_time = 250;
+
+    /**
+     * Standard deviation of a single rate sample in degrees per second, the initial standard deviation of the bias,
+     * and the random walk of the bias in square degrees per second squared per second.
+     */
+    static constexpr float rate_noise = 0.15f;
+    static constexpr float initial_bias_sigma = 0.3f;
+    static constexpr float bias_random_walk = 1e-5f;
+
+    /**
+     * Smallest reference rate in degrees per second the scales are regressed at, and the largest fraction of it a unit may differ by
+     * for the sample to count.
+     */
+    static constexpr float min_scale_rate = 30.0f;
+    static constexpr float max_scale_error = 0.1f;
+
+    /**
+     * Largest divergence in degrees before a unit is rejected, and the time constant in milliseconds the divergence leaks away with.
+     */
+    static constexpr float max_divergence = 2.0f;
+    static constexpr uint32_t divergence_leak = 10000;
+
+    /**
+     * Fastest rate in degrees per second the V5 Inertial Sensor measures, which bounds how far a lone unit can turn in one period.
+     */
+    static constexpr float max_rate = 1000.0f;
+
+    /**
+     * @brief Constructs a fusion of IMUs on explicit ports. Ports past max_imus are ignored.
+     */
+    tr_imu_fusion(const std::vector<uint8_t>& ports);
+
+    /**
+     * @brief Stops the fusion and waits for its task to exit, as the task updates the fusion every period.
+     */
+    ~tr_imu_fusion();
+
+    /**
+     * @brief Adds every connected IMU that is not fused yet. Call from initialize(), before starting.
+     * @return Amount of units fused
+     */
+    int add_all_devices();
+
+    /**
+     * @brief Writes the fused rotation into the IMU of a drivebase every period. Null stops writing.
+     * @note Only EZ-Template exposes its IMU. Every other drivebase is left unchanged.
+     * @note Waits for an update in progress, so the previous drivebase can be destroyed once this returns.
+     */
+    void set_drivebase(const tr_drivebase* drivebase);
+
+    /**
+     * @brief Starts fusing. Does nothing if the fusion is already running.
+     * @return Whether the fusion is running
+     */
+    bool start();
+
+    /**
+     * @brief Requests the fusion to stop and waits for its task to exit.
+     * @param timeout maximum time to wait in milliseconds
+     * @return Whether the fusion reached the stopped state within the timeout
+     */
+    bool stop(uint32_t timeout = 1000);
+
+    tr_fusion_state get_state() const;
+
+    /**
+     * @brief Reads every unit and integrates the fused heading. Called by the fusion task every period.
+     * @param elapsed time since the last update in milliseconds
+     */
+    void update(uint32_t elapsed = period);
+
+    /**
+     * @brief Gets the state of a fused unit. Only read from the task running the fusion.
+     */
+    const tr_imu_unit& get_unit(int index) const;
+
+    int get_unit_count() const;
+
+    /**
+     * @brief Amount of units fused in the last update.
+     */
+    int get_healthy_count() const;
+
+    /**
+     * @brief Whether the robot was still in the last update.
+     */
+    bool is_still() const;
+
+    /*
+    * pros::Imu in terms of the fused heading. Headings and rotations are clockwise in degrees, the same as a single IMU.
+    */
+
+    double get_rotation() const override;
+    double get_heading() const override;
+    std::int32_t set_rotation(const double target) const override;
+    std::int32_t set_heading(const double target) const override;
+    std::int32_t tare_rotation() const override;
+    std::int32_t tare_heading() const override;
+    std::int32_t tare() const override;
+
+    /**
+     * @brief Calibrates every unit. The learned biases and scales are kept, as calibration only removes most of the bias.
+     * @note Units rejected for disagreeing are fused again.
+     */
+    std::int32_t reset(bool blocking = false) const override;
+
+    bool is_calibrating() const override;
+
+    /**
+     * @brief Averaged acceleration of the fused units.
+     */
+    pros::imu_accel_s_t get_accel() const override;
+
+private:
+
+    static void task_body(void* param);
+
+    void run();
+
+    /**
+     * @brief Adds a unit on a port if there is room and it is not fused yet.
+     */
+    bool add_unit(uint8_t port);
+
+    tr_imu_unit units[max_imus];
+    int unit_count;
+
+    /**
+     * Drivebase written into, held by update for the whole update, and the rotation last written into it.
+     */
+    const tr_drivebase* drivebase;
+    pros::Mutex drivebase_mutex;
+    double written_rotation;
+    bool rotation_written;
+
+    /**
+     * Fused rotation integrated by the task, and the time in milliseconds every unit has read still.
+     */
+    double rotation;
+    uint32_t still_elapsed;
+
+    /**
+     * Fused rotation published to other tasks, and a rotation requested by them for the task to continue from.
+     */
+    mutable std::atomic<double> published_rotation;
+    mutable std::atomic<double> requested_rotation;
+    mutable std::atomic<bool> rotation_requested;
+
+    /**
+     * Bit per unit that was fused in the last update, and whether the robot was still.
+     */
+    std::atomic<uint8_t> healthy_mask;
+    std::atomic<bool> still;
+
+    /**
+     * Set by reset() for the task to fuse disagreeing units again.
+     */
+    mutable std::atomic<bool> readmit_requested;
+
+    std::atomic<tr_fusion_state> state;
+    std::atomic<bool> stop_requested;
+};
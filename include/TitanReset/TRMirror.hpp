@@ -0,0 +1,113 @@
+#pragma once
+
+#include "TRWalls.hpp"
+
+/*
+* Alliance mirroring between the frame odometry reports in and the field frame the TitanReset geometry works in.
+*
+* EZ-Template's odom_x_flip, odom_y_flip and odom_theta_flip negate each axis of every pose odometry reports and takes, so a routine written for
+* one side of the field runs mirrored on the other. The wall table, the quadrants and every wall_coord - distance sign assume the field frame,
+* so TitanReset maps poses through the mirror where they cross the drivebase and the public API, and never branches on it in the geometry.
+*/
+
+/**
+ * @brief Mirror between the odometry frame and the field frame. Every mirror is its own inverse, so it maps both ways.
+ *
+ * Signs and the quadrant table are worked out once when the mirror is built, so mapping a pose is three multiplications and a lookup.
+ */
+struct tr_mirror
+{
+    /**
+     * Sign each axis of a pose is multiplied by.
+     */
+    double x_sign;
+    double y_sign;
+    double theta_sign;
+
+    /**
+     * Quadrant in the other frame, indexed by quadrant.
+     */
+    tr_quadrant quadrants[4];
+
+    /**
+     * @brief Builds a mirror from the EZ-Template flips.
+     * @param flip_x whether left is positive X
+     * @param flip_y whether down is positive Y
+     * @param flip_theta whether counterclockwise is positive
+     */
+    constexpr tr_mirror(bool flip_x = false, bool flip_y = false, bool flip_theta = false) :
+                x_sign(flip_x ? -1.0 : 1.0),
+                y_sign(flip_y ? -1.0 : 1.0),
+                theta_sign(flip_theta ? -1.0 : 1.0),
+                quadrants{}
+    {
+        // Signs of X then Y of each quadrant, the same as the wall table.
+        const double x_signs[4] = {1, -1, -1, 1};
+        const double y_signs[4] = {1, 1, -1, -1};
+        for (int quadrant = 0; quadrant < 4; quadrant++)
+        {
+            quadrants[quadrant] = tr_position_quadrant(x_signs[quadrant] * x_sign, y_signs[quadrant] * y_sign);
+        }
+    }
+
+    /**
+     * @brief Whether the mirror leaves every pose unchanged.
+     */
+    constexpr bool is_identity() const
+    {
+        return x_sign > 0 && y_sign > 0 && theta_sign > 0;
+    }
+
+    constexpr tr_quadrant quadrant(tr_quadrant quadrant) const
+    {
+        return quadrants[quadrant];
+    }
+
+    /**
+     * @brief Mirrors a heading in degrees. The result is not wrapped.
+     */
+    constexpr double heading(double heading) const
+    {
+        return theta_sign * heading;
+    }
+
+    tr_vector2 point(tr_vector2 point) const
+    {
+        return tr_vector2(x_sign * point.x, y_sign * point.y);
+    }
+};
+
+/**
+ * @brief Checks every combination of flips: mirroring twice is the identity, each flip swaps the quadrants across its axis only,
+ * theta never moves a quadrant, and the flips compose independently.
+ */
+constexpr bool tr_mirrors_consistent()
+{
+    const tr_quadrant x_swapped[4] = {NEG_POS, POS_POS, POS_NEG, NEG_NEG};
+    const tr_quadrant y_swapped[4] = {POS_NEG, NEG_NEG, NEG_POS, POS_POS};
+
+    for (int flips = 0; flips < 8; flips++)
+    {
+        bool flip_x = flips & 1;
+        bool flip_y = flips & 2;
+        bool flip_theta = flips & 4;
+        tr_mirror mirror(flip_x, flip_y, flip_theta);
+
+        if (mirror.is_identity() != (flips == 0)) return false;
+        if (mirror.heading(mirror.heading(90.0)) != 90.0 || (mirror.heading(90.0) < 0) != flip_theta) return false;
+
+        for (int index = 0; index < 4; index++)
+        {
+            tr_quadrant quadrant = (tr_quadrant)index;
+            tr_quadrant expected = flip_x ? x_swapped[quadrant] : quadrant;
+            expected = flip_y ? y_swapped[expected] : expected;
+
+            if (mirror.quadrant(quadrant) != expected) return false;
+            if (mirror.quadrant(mirror.quadrant(quadrant)) != quadrant) return false;
+            if (tr_mirror(flip_x, flip_y, !flip_theta).quadrant(quadrant) != expected) return false;
+        }
+    }
+    return true;
+}
+
+static_assert(tr_mirrors_consistent(), "TitanReset mirror is inconsistent for a combination of flips");
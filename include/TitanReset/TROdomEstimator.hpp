@@ -0,0 +1,103 @@
+#pragma once
+
+#include "TRTypes.hpp"
+
+/**
+ * @brief Recursive estimator of systematic odometry error from the corrections of distance sensor resets.
+ *
+ * Between two resets odometry reports a displacement and the reset then corrects it. With the heading from the IMU, a wrong wheel diameter
+ * or drive ratio scales the whole displacement, while a wrong tracking wheel distance to center adds forward distance for every radian turned.
+ * Each interval is regressed as correction = scale_error * displacement + turn_error * turned * forward, weighted by the variance of the reset
+ * and the noise odometry picks up over the distance travelled. The normal equations are accumulated in information form around a weak prior,
+ * so an axis the intervals do not excite stays at zero instead of becoming singular.
+ */
+class tr_odom_estimator
+{
+public:
+
+    /**
+     * Variance in square inches odometry picks up per inch travelled regardless of calibration.
+     */
+    static constexpr float odometry_noise = 0.01f;
+
+    /**
+     * @brief Constructs an estimator.
+     * @param scale_prior standard deviation of the expected scale error, 0.05 expects distances within about 5%
+     * @param turn_prior standard deviation of the expected turn error in inches per radian
+     */
+    tr_odom_estimator(float scale_prior = 0.05, float turn_prior = 1.0);
+
+    /**
+     * @brief Adds the interval between two resets.
+     *
+     * @param displacement displacement odometry reported since the previous reset in inches
+     * @param turned angle turned since the previous reset in degrees, clockwise and unwrapped
+     * @param mid_heading heading halfway through the turn in degrees
+     * @param correction correction the reset applied in inches
+     * @param variance variance of the reset in square inches
+     */
+    void add(tr_vector2 displacement, float turned, float mid_heading, tr_vector2 correction, tr_vector2 variance);
+
+    /**
+     * @brief Factor odometry distances should be multiplied by.
+     */
+    float get_scale() const;
+
+    /**
+     * @brief Standard deviation of the scale.
+     */
+    float get_scale_sigma() const;
+
+    /**
+     * @brief Forward distance in inches odometry misses per radian turned clockwise.
+     */
+    float get_turn_error() const;
+
+    /**
+     * @brief Standard deviation of the turn error in inches per radian.
+     */
+    float get_turn_sigma() const;
+
+    /**
+     * @brief Amount of intervals added since the estimator was constructed or reset.
+     */
+    int get_observations() const;
+
+    /**
+     * @brief Whether the scale error is at least twice its standard deviation after enough intervals.
+     * @param min_observations least amount of intervals
+     */
+    bool is_scale_significant(int min_observations = 3) const;
+
+    /**
+     * @brief Takes a bounded step of the scale correction, for when it is applied to the drivebase.
+     *
+     * The estimate is shifted by the step, so the intervals already added keep counting against the corrected odometry.
+     *
+     * @param max_step largest change of the scale, 0.01 is 1%
+     * @return Factor to multiply odometry distances by
+     */
+    float take_scale_step(float max_step);
+
+    /**
+     * @brief Discards every interval and returns to the prior.
+     */
+    void reset();
+
+private:
+
+    /**
+     * Upper triangle of the information matrix and the information vector of scale error and turn error.
+     */
+    float info_scale;
+    float info_cross;
+    float info_turn;
+    float vector_scale;
+    float vector_turn;
+
+    float scale_prior;
+    float turn_prior;
+    int observations;
+
+    float determinant() const;
+};
@@ -0,0 +1,26 @@
+#pragma once
+
+/*
+* Reset point picked by the offline planner in tools/tr_planner.cpp. Generated reset tables are arrays of these.
+*/
+
+/**
+ * Planned reset location.
+ */
+struct tr_plan_point
+{
+    float x;
+    float y;
+    float heading;
+
+    /**
+     * Index of the waypoint the path is heading to at this point.
+     */
+    int index;
+
+    /**
+     * Standard deviation of the X and Y a reset here would measure, in inches.
+     */
+    float sigma_x;
+    float sigma_y;
+};
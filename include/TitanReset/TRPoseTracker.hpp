@@ -0,0 +1,154 @@
+#pragma once
+
+#include "TRTypes.hpp"
+#include "TRDrivebase.hpp"
+
+class tr_chassis;
+
+/**
+ * Asymmetric field element the beams can hit, such as a goal or a barrier, as a line segment in the field frame.
+ */
+struct tr_field_element
+{
+    tr_vector2 from;
+    tr_vector2 to;
+};
+
+/**
+ * One pose the robot could be at.
+ */
+struct tr_hypothesis
+{
+    /**
+     * Pose in the field frame.
+     */
+    tr_pose pose;
+
+    /**
+     * Log likelihood relative to the most likely hypothesis, which is always 0.
+     */
+    float log_likelihood;
+
+    /**
+     * Whether the hypothesis is still tracked. Pruned hypotheses never come back until the tracker is reset.
+     */
+    bool active;
+};
+
+/**
+ * @brief Tracks every pose a set of readings is consistent with on the symmetric field until asymmetric evidence tells them apart.
+ *
+ * The walls look the same after every quarter turn of the field about its center, so a robot unsure of its heading reads the same at four poses.
+ * Hypothesis k is the odometry pose turned k quarter turns about the center. Each is propagated with the odometry displacement turned the same way,
+ * reset against the walls its own quadrant and heading assign, and weighed by how well it predicts all four beams over the walls and the registered
+ * field elements. Walls weigh every hypothesis equally, so only field elements and heading evidence separate them.
+ *
+ * Hypotheses less likely than the best by the prune ratio are dropped. The tracker commits to the best once it is more likely than every other by the commit ratio.
+ */
+class tr_pose_tracker
+{
+public:
+
+    /**
+     * Amount of hypotheses, one per quarter turn of the field.
+     */
+    static constexpr int max_hypotheses = 4;
+
+    /**
+     * Largest amount of field elements that can be registered.
+     */
+    static constexpr int max_elements = 16;
+
+    /**
+     * Likelihood ratio over every other hypothesis the best needs to be committed to, and below the best a hypothesis is pruned at.
+     */
+    static constexpr float commit_ratio = 100.0f;
+    static constexpr float prune_ratio = 10000.0f;
+
+    /**
+     * Largest chi-square a single beam contributes per update, so one bad reading cannot prune the true pose, and the chi-square of a beam
+     * that should read but did not.
+     */
+    static constexpr float max_beam_chi_square = 9.0f;
+    static constexpr float missing_reading_chi_square = 9.0f;
+
+    /**
+     * Largest disagreement in inches between a beam and a hypothesis that resets the hypothesis.
+     */
+    static constexpr float max_correction = 6.0f;
+
+    /**
+     * @brief Constructs a tracker for a TitanReset chassis. Register field elements, then reset it where the robot is ambiguous.
+     */
+    tr_pose_tracker(tr_chassis* chassis);
+
+    /**
+     * @brief Registers a field element the beams can hit.
+     * @return Whether there was room to register it
+     */
+    bool add_element(tr_vector2 from, tr_vector2 to);
+
+    /**
+     * @brief Spawns every hypothesis from the current odometry pose.
+     * @param heading_sigma how far in degrees the odometry heading may be from the true heading, 0 if it says nothing about which quarter turn is right
+     */
+    void reset(float heading_sigma = 0);
+
+    /**
+     * @brief Propagates every hypothesis with odometry, weighs it against the current readings and resets it against the walls.
+     * @note Call at the update rate of the sensors. Readings are correlated between updates, so keep the robot moving rather than updating still.
+     */
+    void update();
+
+    /**
+     * @brief Weighs every hypothesis against an absolute heading.
+     * @param heading heading in degrees in the field frame
+     * @param sigma standard deviation of the heading in degrees
+     */
+    void observe_heading(float heading, float sigma);
+
+    /**
+     * @brief Index of the hypothesis the tracker committed to, -1 while the evidence is not yet strong enough.
+     */
+    int get_committed() const;
+
+    /**
+     * @brief Likelihood ratio of the best hypothesis over the next best active one, infinite once only one is left.
+     */
+    float get_likelihood_ratio() const;
+
+    const tr_hypothesis& get_hypothesis(int index) const;
+
+    int get_active_count() const;
+
+    /**
+     * @brief Writes the committed hypothesis to the drivebase and the IMU. The hypotheses are renumbered so the committed one is 0 again.
+     * @return Whether the tracker had committed
+     */
+    bool apply();
+
+private:
+
+    tr_chassis* chassis;
+
+    tr_hypothesis hypotheses[max_hypotheses];
+    tr_pose last_odom;
+
+    tr_field_element elements[max_elements];
+    int element_count;
+
+    /**
+     * @brief Range in inches along a beam to the nearest field element and the incidence it hits at, infinite if it hits none.
+     */
+    float trace_elements(tr_vector2 origin, float facing, float& incidence) const;
+
+    /**
+     * @brief Log likelihood of the readings at a hypothesis. Resets the hypothesis against the walls its beams hit.
+     */
+    float weigh(tr_hypothesis& hypothesis, const float readings[4]);
+
+    /**
+     * @brief Shifts the log likelihoods so the best is 0 and prunes the unlikely hypotheses.
+     */
+    void normalize();
+};
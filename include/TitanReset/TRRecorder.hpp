@@ -0,0 +1,132 @@
+#pragma once
+
+#include "TRTypes.hpp"
+#include "../pros/rtos.hpp"
+#include <atomic>
+#include <stdio.h>
+
+/**
+ * States of the location recorder.
+ */
+enum tr_recorder_state
+{
+    /**
+     * Recorder has never been started.
+     */
+    RECORDER_IDLE,
+
+    /**
+     * Recorder task is sampling and writing.
+     */
+    RECORDER_RUNNING,
+
+    /**
+     * A stop was requested and the task is writing the last buffered records.
+     */
+    RECORDER_DRAINING,
+
+    /**
+     * Task has closed its files and exited. The recorder can be started again.
+     */
+    RECORDER_STOPPED,
+};
+
+/**
+ * Single recorded sample.
+ */
+struct tr_record
+{
+    uint32_t time;
+    tr_vector3 odom;
+    tr_vector3 dsr;
+};
+
+/**
+ * Function filling a sample. Context is the pointer given to the recorder.
+ */
+typedef void (*tr_record_source)(void* context, tr_record& record);
+
+/**
+ * @brief Background location recorder with cooperative shutdown.
+ *
+ * Samples are buffered and written in batches. Only complete lines are ever written and the files are flushed after each batch, so a log is intact even if power is lost.
+ * Stopping sets a flag that the task checks every period. The task then writes what it has buffered, closes its files and returns, which frees its stack.
+ */
+class tr_recorder
+{
+public:
+
+    /**
+     * Period between samples in milliseconds.
+     */
+    static constexpr uint32_t period = 50;
+
+    /**
+     * Amount of samples buffered before they are written.
+     */
+    static constexpr int batch_size = 8;
+
+    /**
+     * @brief Constructs a recorder.
+     * @param source function filling each sample
+     * @param context pointer passed to the source
+     */
+    tr_recorder(tr_record_source source, void* context);
+
+    /**
+     * @brief Stops the recorder and waits for its task to exit however long the last records take to write, as the task uses the recorder.
+     */
+    ~tr_recorder();
+
+    /**
+     * @brief Starts recording. A recording that is already running is stopped first.
+     *
+     * @param date date written into the recording header
+     * @param time time written into the recording header
+     * @return Whether the recorder task was started
+     */
+    bool start(const char* date, const char* time);
+
+    /**
+     * @brief Requests the recorder to stop and waits for it to finish writing.
+     * @param timeout maximum time to wait in milliseconds
+     * @return Whether the recorder reached the stopped state within the timeout
+     */
+    bool stop(uint32_t timeout = 1000);
+
+    /**
+     * @brief Gets the current state of the recorder.
+     */
+    tr_recorder_state get_state() const;
+
+    /**
+     * @brief Samples missed in the current or last recording, either because a period was overrun or a record could not be written.
+     */
+    uint32_t get_dropped() const;
+
+    /**
+     * @brief Samples written in the current or last recording.
+     */
+    uint32_t get_written() const;
+
+private:
+
+    static void task_body(void* param);
+
+    void run();
+    void write_batch(FILE* odom_file, FILE* dist_file);
+
+    tr_record_source source;
+    void* context;
+
+    std::atomic<tr_recorder_state> state;
+    std::atomic<bool> stop_requested;
+    std::atomic<uint32_t> dropped;
+    std::atomic<uint32_t> written;
+
+    tr_record batch[batch_size];
+    int batch_count;
+
+    char date[16];
+    char time[16];
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "TRTypes.hpp"
+#include "TRCorrection.hpp"
 #include "../pros/distance.hpp"
 
 /**
@@ -13,7 +14,19 @@ class tr_sensor
      * X is the parrallel offset (the way it is facing) of the sensor from the center of the robot to the sensor
      * Y is the perpendicular offset (left or right of the way the sensor is facing) of the sensor from the center of the robot to the sensor
      */
-    const tr_vector2 offset;
+    tr_vector2 offset;
+
+    /**
+     * Mounting yaw of the sensor in degrees, clockwise from its nominal facing, with its sine and cosine cached.
+     */
+    float yaw;
+    float yaw_sin;
+    float yaw_cos;
+
+    /**
+     * Range and incidence correction applied to every reading.
+     */
+    tr_correction_table correction;
 
     /**
      * Pros distance sensor object.
@@ -44,6 +57,67 @@ public:
      */
     tr_distance distance();
 
+    /**
+     * @brief Gets the offset of the sensor from the center of the robot.
+     */
+    tr_vector2 get_offset() const;
+
+    /**
+     * @brief Gets the mounting yaw of the sensor in degrees, clockwise from its nominal facing.
+     */
+    float get_yaw() const;
+
+    /**
+     * @brief Gets the port of the distance sensor.
+     */
+    int get_port() const;
+
+    /**
+     * @brief Replaces the hand measured mounting with a calibrated one.
+     * @param off Offset of the sensor with X being parallel to its facing and Y perpendicular
+     * @param mount_yaw Mounting yaw in degrees, clockwise from its nominal facing
+     */
+    void set_calibration(tr_vector2 off, float mount_yaw);
+
+    /**
+     * @brief Loads the calibration of this sensor's port from a calibration file written by tr_calibrator.
+     * @note Keeps the hand measured mounting if the file or the port's entry is missing.
+     * @param path path of the calibration file
+     * @return Whether a calibration for this sensor was loaded
+     */
+    bool load_calibration(const char* path);
+
+    /**
+     * @brief Splits a raw reading into components along and across the nominal facing of the sensor, accounting for the mounting yaw.
+     * @param reading raw reading in inches
+     * @param along component along the nominal facing
+     * @param across component to the right of the nominal facing
+     */
+    void beam_components(float reading, float& along, float& across) const;
+
+    /**
+     * @brief Position of the sensor on the field.
+     * @param robot position of the center of the robot in inches
+     * @param facing nominal facing of the sensor in degrees, clockwise from +Y
+     */
+    tr_vector2 get_origin(tr_vector2 robot, float facing) const;
+
+    /**
+     * @brief Loads the range and incidence correction table of this sensor.
+     * @note Readings stay uncorrected if the file is missing or invalid.
+     * @param path path of the correction table file
+     * @return Whether a table was loaded
+     */
+    bool load_correction(const char* path);
+
+    /**
+     * @brief Applies the correction table to a reading.
+     * @param reading raw reading in inches
+     * @param heading_error signed error of the robot heading to the nearest multiple of 90 degrees
+     * @return Corrected reading in inches. Error readings are returned unchanged.
+     */
+    float correct(float reading, float heading_error) const;
+
 public:
 
     /**
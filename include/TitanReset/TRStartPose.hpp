@@ -0,0 +1,180 @@
+#pragma once
+
+#include "TRTypes.hpp"
+#include <stdint.h>
+
+class tr_chassis;
+
+/**
+ * Start pose registered for an autonomous routine.
+ */
+struct tr_start_pose
+{
+    /**
+     * Name of the routine, the same as its entry in the EZ-Template auton selector.
+     */
+    const char* name;
+
+    tr_vector2 position;
+    float heading;
+};
+
+/**
+ * Result of matching a sensor snapshot against the registered start poses.
+ */
+struct tr_start_match
+{
+    /**
+     * Index of the start pose that fits the snapshot best, -1 if none fits.
+     */
+    int index;
+
+    /**
+     * Root mean square in inches of the difference between the averaged readings and the readings expected at the best start pose.
+     */
+    float rms;
+
+    /**
+     * Placement skew in degrees that fit the best start pose. Coarse, as beams square to the walls barely change with small skews.
+     */
+    float skew;
+
+    /**
+     * Whether the robot stayed still while the snapshot was taken.
+     */
+    bool stable;
+
+    /**
+     * Whether no start pose at a different place or heading fits nearly as well.
+     */
+    bool unique;
+};
+
+/**
+ * Outcome of checking the selected autonomous routine against the placement of the robot.
+ */
+enum tr_start_check
+{
+    /**
+     * The start pose of the selected routine fits the placement.
+     */
+    START_CONFIRMED,
+
+    /**
+     * The placement uniquely fits another routine, which is now selected.
+     */
+    START_CORRECTED,
+
+    /**
+     * The placement fits no routine, or fits several and the selected one is not among them. Check the placement of the robot.
+     */
+    START_UNKNOWN,
+};
+
+/**
+ * @brief Detects which registered start pose the robot was placed at from a snapshot of its sensors.
+ *
+ * The readings of every sensor are averaged over several samples while the IMU confirms the robot is still. Each start pose is scored by
+ * the root mean square difference to the readings the beam model expects there, searched over a few degrees of placement skew.
+ * The IMU only reports heading relative to where it was calibrated, so the absolute heading comes from the start pose and the IMU only confirms the robot is still.
+ * The skew search lets a slightly crooked robot still match its start pose.
+ *
+ * Register one start pose per auton selector entry in initialize(), detect and confirm the selection while the robot waits for the match,
+ * and apply the match at the start of autonomous() instead of hard coding perform_dsr_init.
+ * Start poses are in the frame of odometry, mirrored by the mirror the chassis has when detecting and applying.
+ */
+class tr_start_detector
+{
+public:
+
+    /**
+     * Largest amount of start poses that can be registered.
+     */
+    static constexpr int max_starts = 16;
+
+    /**
+     * Largest root mean square in inches a start pose fits at.
+     */
+    static constexpr float max_rms = 1.5f;
+
+    /**
+     * Least root mean square in inches between the best start pose and any other at a different place or heading for the match to be unique.
+     */
+    static constexpr float ambiguity_margin = 1.0f;
+
+    /**
+     * Largest placement skew in degrees searched and its step.
+     */
+    static constexpr float max_skew = 5.0f;
+    static constexpr float skew_step = 0.5f;
+
+    /**
+     * Largest rotation in degrees while the snapshot is taken for the robot to count as still.
+     */
+    static constexpr float max_rotation = 1.0f;
+
+    /**
+     * @brief Constructs a start detector for a TitanReset chassis.
+     */
+    tr_start_detector(tr_chassis* chassis);
+
+    /**
+     * @brief Registers the start pose of an autonomous routine.
+     * @param name name of the routine in the auton selector
+     * @param position position of the center of the robot in inches
+     * @param heading heading of the robot in degrees
+     * @return Whether there was room to register it
+     */
+    bool add(const char* name, tr_vector2 position, float heading);
+
+    /**
+     * @brief Takes a snapshot of the sensors and matches it against every registered start pose.
+     * @param samples amount of samples averaged per sensor
+     * @param period time between samples in milliseconds
+     */
+    tr_start_match detect(int samples = 10, uint32_t period = 35);
+
+    /**
+     * @brief Confirms the routine selected in the EZ-Template auton selector against a match, and selects the matched routine if the placement uniquely fits it instead.
+     */
+    tr_start_check confirm_selection(const tr_start_match& match);
+
+    /**
+     * @brief Sets the IMU heading and pose of the robot from a match.
+     * @note The heading is the registered one. The skew is too coarse to set the IMU from, robots are squared to the tiles when placed.
+     * @return Result of the initial reset, rejected with REJECT_START_UNKNOWN if the match fits no start pose or is not unique
+     */
+    tr_dsr_result apply(const tr_start_match& match);
+
+    /**
+     * @brief Gets the last match detect returned.
+     */
+    const tr_start_match& get_last_match() const;
+
+    /**
+     * @brief Gets a registered start pose.
+     */
+    const tr_start_pose& get_start(int index) const;
+
+    /**
+     * @brief Root mean square in inches a registered start pose fit the last snapshot at, infinite if too few beams could be compared.
+     */
+    float get_start_rms(int index) const;
+
+    int get_start_count() const;
+
+private:
+
+    tr_chassis* chassis;
+
+    tr_start_pose starts[max_starts];
+    float start_rms[max_starts];
+    int start_count;
+
+    tr_start_match last_match;
+
+    /**
+     * @brief Root mean square difference between averaged readings and the readings expected at a pose, over the beams valid at that pose.
+     */
+    float fit(const float readings[4], tr_vector2 position, float heading) const;
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "TRTypes.hpp"
+
+/**
+ * @brief Decides whether a distance sensor reset is trusted enough to be applied.
+ */
+class tr_trust_policy
+{
+public:
+
+    /**
+     * @brief Constructs a trust policy.
+     *
+     * @param sensor_trust trust in the sensors from 0 to 1. A reset needs a confidence of at least 1 - sensor_trust, so 1 trusts every reading.
+     * @param max_correction largest allowed correction in inches. 0 disables the check.
+     * @param max_residual largest allowed single beam residual in inches. 0 disables the check.
+     * @param max_variance largest allowed variance of either axis in square inches. 0 disables the check.
+     */
+    tr_trust_policy(float sensor_trust, float max_correction, float max_residual, float max_variance = 0);
+
+    /**
+     * @brief Evaluates a reset result against the thresholds.
+     * @param result result with everything except applied and rejection filled in
+     * @return REJECT_NONE if the reset should be applied, otherwise the first failed check
+     */
+    tr_rejection_reason evaluate(const tr_dsr_result& result) const;
+
+    float get_min_confidence() const { return min_confidence; }
+    float get_max_correction() const { return max_correction; }
+    float get_max_residual() const { return max_residual; }
+    float get_max_variance() const { return max_variance; }
+
+private:
+    float min_confidence;
+    float max_correction;
+    float max_residual;
+    float max_variance;
+};
@@ -23,6 +23,77 @@ enum tr_sensors
     EAST = 2,
     SOUTH = 4,
     WEST = 8,
+
+    /**
+     * GPS sensor, set in the sensors of a reset it was fused into.
+     */
+    GPS_SENSOR = 16,
+};
+
+/**
+ * Reasons TitanReset did not apply a distance sensor reset.
+ */
+enum tr_rejection_reason
+{
+    /**
+     * The reset was applied.
+     */
+    REJECT_NONE,
+
+    /**
+     * Every asynchronous reset slot was busy.
+     */
+    REJECT_QUEUE_FULL,
+
+    /**
+     * The handle refers to a reset whose result has been replaced by a newer one.
+     */
+    REJECT_EXPIRED,
+
+    /**
+     * A sensor used by the reset could not read a distance.
+     */
+    REJECT_NO_READING,
+
+    /**
+     * The averaged confidence of the used sensors was below the trust threshold.
+     */
+    REJECT_LOW_CONFIDENCE,
+
+    /**
+     * The calculated position cannot physically exist.
+     */
+    REJECT_IMPOSSIBLE_POSITION,
+
+    /**
+     * The correction from the odometry pose was larger than allowed.
+     */
+    REJECT_CORRECTION_TOO_LARGE,
+
+    /**
+     * A single beam disagreed with odometry by more than allowed.
+     */
+    REJECT_RESIDUAL_TOO_LARGE,
+
+    /**
+     * A beam used by the reset was out of range, too steep, or too close to a corner.
+     */
+    REJECT_INVALID_BEAM,
+
+    /**
+     * The variance of the calculated position was larger than allowed.
+     */
+    REJECT_VARIANCE_TOO_LARGE,
+
+    /**
+     * The waypoint of the reset was not passed before the timeout.
+     */
+    REJECT_WAYPOINT_MISSED,
+
+    /**
+     * The placement of the robot fit no start pose, or several at different places or headings.
+     */
+    REJECT_START_UNKNOWN,
 };
 
 /**
@@ -109,19 +180,29 @@ public:
 typedef tr_conf_pair<float> tr_distance;
 
 
+/**
+ * Scalar used by the TitanReset geometry. Define TR_DOUBLE_PRECISION to build the geometry in double precision.
+ */
+#ifdef TR_DOUBLE_PRECISION
+typedef double tr_scalar;
+#else
+typedef float tr_scalar;
+#endif
+
 /*
  * 3D vector data structure. Z is expressed as theta for TitanReset
  */
-struct tr_vector3
+template<typename S>
+struct tr_vector3_t
 {
-    float x;
-    float y;
-    float z;
+    S x;
+    S y;
+    S z;
 
     /**
      * @breif Default constructor for vector, initializes X, Y, and Z to zero.
      */
-    tr_vector3()
+    tr_vector3_t()
     {
         x = 0;
         y = 0;
@@ -134,7 +215,7 @@ struct tr_vector3
      * @param Y y value of vector
      * @param Z z or theta value of vector depending on plane interpreted
      */
-    tr_vector3(float X, float Y, float Z)
+    tr_vector3_t(S X, S Y, S Z)
     {
         x = X;
         y = Y;
@@ -145,29 +226,41 @@ struct tr_vector3
      * @brief Standard constructor for vector, initializes values to input parameters
      * @param arr
      */
-    tr_vector3(std::array<float, 3> arr)
+    tr_vector3_t(std::array<S, 3> arr)
     {
         x = arr[0];
         y = arr[1];
         z = arr[2];
     }
+
+    /**
+     * @brief Converts from a vector of another scalar.
+     */
+    template<typename O>
+    explicit tr_vector3_t(const tr_vector3_t<O>& other)
+    {
+        x = other.x;
+        y = other.y;
+        z = other.z;
+    }
 };
 
 /**
  * Two dimensional vector object used by TitanReset
  */
-struct tr_vector2
+template<typename S>
+struct tr_vector2_t
 {
-    float x;
-    float y;
+    S x;
+    S y;
 
-    tr_vector2()
+    tr_vector2_t()
     {
-        x = 0.0f;
-        y = 0.0f;
+        x = 0;
+        y = 0;
     }
 
-    tr_vector2(float X, float Y)
+    tr_vector2_t(S X, S Y)
     {
         x = X;
         y = Y;
@@ -177,11 +270,76 @@ struct tr_vector2
      * @brief Standard constructor for vector, initializes values to input parameters
      * @param arr
      */
-    tr_vector2(std::array<float, 2> arr)
+    tr_vector2_t(std::array<S, 2> arr)
     {
         x = arr[0];
         y = arr[1];
     }
+
+    /**
+     * @brief Converts from a vector of another scalar.
+     */
+    template<typename O>
+    explicit tr_vector2_t(const tr_vector2_t<O>& other)
+    {
+        x = other.x;
+        y = other.y;
+    }
+};
+
+/**
+ * Vectors in the precision selected for the build.
+ */
+typedef tr_vector3_t<tr_scalar> tr_vector3;
+typedef tr_vector2_t<tr_scalar> tr_vector2;
+
+/**
+ * Vectors in explicit precisions.
+ */
+typedef tr_vector3_t<float> tr_vector3f;
+typedef tr_vector3_t<double> tr_vector3d;
+typedef tr_vector2_t<float> tr_vector2f;
+typedef tr_vector2_t<double> tr_vector2d;
+
+/**
+ * Result of a distance sensor reset.
+ */
+struct tr_dsr_result
+{
+    /**
+     * Whether the pose of the drivebase was changed.
+     */
+    bool applied;
+
+    /**
+     * Reason the reset was not applied, REJECT_NONE if it was.
+     */
+    tr_rejection_reason rejection;
+
+    /**
+     * Difference between the calculated position and the odometry position in inches.
+     */
+    tr_vector2 correction;
+
+    /**
+     * Averaged confidence of the used sensors.
+     */
+    tr_probability confidence;
+
+    /**
+     * Sensor flags of the used sensors.
+     */
+    int sensors_used;
+
+    /**
+     * Per beam reading minus the reading predicted from the odometry pose in inches, ordered north, east, south, west. Zero for unused beams.
+     */
+    float residuals[4];
+
+    /**
+     * Variance of the calculated X and Y in square inches from the beam model.
+     */
+    tr_vector2 variance;
 };
 
 /**
@@ -191,6 +349,7 @@ class tr_drivebase_generic
 {
 public:
     tr_drivebase_generic() {}
+    virtual ~tr_drivebase_generic() {}
 
     virtual tr_vector3 getPose() = 0;
     virtual void setPose(tr_vector3 new_pose) = 0;
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "TRTypes.hpp"
+
+/*
+* Compile time unit tags for TitanReset quantities. A quantity is a bare scalar at runtime, the tag only exists for the compiler.
+*
+* Each unit stores its scale to the base unit of its dimension, inches for length and radians for angle, so conversion is a single constant multiply folded at compile time.
+*/
+
+/**
+ * Dimensions a unit can measure.
+ */
+enum tr_dimension
+{
+    DIMENSION_LENGTH,
+    DIMENSION_ANGLE,
+};
+
+/**
+ * Inches, the base length unit of TitanReset.
+ */
+struct tr_inch
+{
+    static constexpr tr_dimension dimension = DIMENSION_LENGTH;
+    static constexpr double scale = 1.0;
+};
+
+/**
+ * Millimetres, the unit reported by the V5 Distance Sensor.
+ */
+struct tr_millimetre
+{
+    static constexpr tr_dimension dimension = DIMENSION_LENGTH;
+    static constexpr double scale = 1.0 / 25.4;
+};
+
+/**
+ * Metres, the unit reported by the V5 GPS Sensor.
+ */
+struct tr_metre
+{
+    static constexpr tr_dimension dimension = DIMENSION_LENGTH;
+    static constexpr double scale = 1000.0 / 25.4;
+};
+
+/**
+ * Radians, the base angle unit of TitanReset.
+ */
+struct tr_radian
+{
+    static constexpr tr_dimension dimension = DIMENSION_ANGLE;
+    static constexpr double scale = 1.0;
+};
+
+/**
+ * Degrees, the unit of IMU and drivebase headings.
+ */
+struct tr_degree
+{
+    static constexpr tr_dimension dimension = DIMENSION_ANGLE;
+    static constexpr double scale = 3.14159265358979323846 / 180.0;
+};
+
+/**
+ * @brief Scalar tagged with a unit.
+ *
+ * Converting between units of different dimensions does not compile. Quantities of the same unit can be added, subtracted and scaled.
+ */
+template<typename Unit, typename S = tr_scalar>
+class tr_quantity
+{
+public:
+
+    constexpr tr_quantity() : value(0) {}
+
+    constexpr explicit tr_quantity(S value) : value(value) {}
+
+    /**
+     * @brief Gets the bare value in this unit.
+     */
+    constexpr S get() const
+    {
+        return value;
+    }
+
+    /**
+     * @brief Converts to another unit of the same dimension.
+     */
+    template<typename To>
+    constexpr tr_quantity<To, S> to() const
+    {
+        static_assert(Unit::dimension == To::dimension, "TitanReset quantities can only be converted within a dimension");
+        return tr_quantity<To, S>(value * (S)(Unit::scale / To::scale));
+    }
+
+    constexpr tr_quantity operator+(tr_quantity other) const
+    {
+        return tr_quantity(value + other.value);
+    }
+
+    constexpr tr_quantity operator-(tr_quantity other) const
+    {
+        return tr_quantity(value - other.value);
+    }
+
+    constexpr tr_quantity operator*(S factor) const
+    {
+        return tr_quantity(value * factor);
+    }
+
+private:
+    S value;
+};
+
+typedef tr_quantity<tr_inch> tr_inches;
+typedef tr_quantity<tr_millimetre> tr_millimetres;
+typedef tr_quantity<tr_metre> tr_metres;
+typedef tr_quantity<tr_degree> tr_degrees;
+typedef tr_quantity<tr_radian> tr_radians;
+
+static_assert(sizeof(tr_inches) == sizeof(tr_scalar), "TitanReset quantities must be the size of a bare scalar");
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "TRTypes.hpp"
+#include "../pros/rtos.hpp"
+#include <atomic>
+
+/**
+ * States of the wall follower.
+ */
+enum tr_follower_state
+{
+    /**
+     * Follower has never been started.
+     */
+    FOLLOWER_IDLE,
+
+    /**
+     * Follower task is correcting the lateral axis during drive motions.
+     */
+    FOLLOWER_RUNNING,
+
+    /**
+     * Task has exited. The follower can be started again.
+     */
+    FOLLOWER_STOPPED,
+};
+
+/**
+ * Outcome of a single wall following step.
+ */
+enum tr_follow_outcome
+{
+    /**
+     * No drive motion is running or the robot is not driving parallel to a wall.
+     */
+    FOLLOW_IDLE,
+
+    /**
+     * The side beam could not be trusted, so odometry was left alone.
+     */
+    FOLLOW_REJECTED,
+
+    /**
+     * A lateral correction was fused into odometry.
+     */
+    FOLLOW_APPLIED,
+};
+
+/**
+ * Function performing one wall following step. Context is the pointer given to the follower.
+ */
+typedef tr_follow_outcome (*tr_follow_step)(void* context);
+
+/**
+ * @brief Background task that keeps correcting lateral drift while the robot drives along a wall.
+ *
+ * Every period the step fuses the coordinate across the direction of travel from the side beam with a small gain and leaves the coordinate along it to odometry.
+ * Stopping sets a flag that the task checks every period, the task then returns which frees its stack.
+ */
+class tr_wall_follower
+{
+public:
+
+    /**
+     * Period between steps in milliseconds, close to the update rate of the V5 Distance Sensor.
+     */
+    static constexpr uint32_t period = 30;
+
+    /**
+     * @brief Constructs a wall follower.
+     * @param step function performing each step
+     * @param context pointer passed to the step
+     */
+    tr_wall_follower(tr_follow_step step, void* context);
+
+    /**
+     * @brief Starts following. Does nothing if the follower is already running.
+     * @return Whether the follower is running
+     */
+    bool start();
+
+    /**
+     * @brief Requests the follower to stop and waits for its task to exit.
+     * @param timeout maximum time to wait in milliseconds
+     * @return Whether the follower reached the stopped state within the timeout
+     */
+    bool stop(uint32_t timeout = 1000);
+
+    /**
+     * @brief Gets the current state of the follower.
+     */
+    tr_follower_state get_state() const;
+
+    /**
+     * @brief Corrections fused since the follower was started.
+     */
+    uint32_t get_applied() const;
+
+    /**
+     * @brief Steps during a drive motion whose side beam was rejected since the follower was started.
+     */
+    uint32_t get_rejected() const;
+
+private:
+
+    static void task_body(void* param);
+
+    void run();
+
+    tr_follow_step step;
+    void* context;
+
+    std::atomic<tr_follower_state> state;
+    std::atomic<bool> stop_requested;
+    std::atomic<uint32_t> applied;
+    std::atomic<uint32_t> rejected;
+};
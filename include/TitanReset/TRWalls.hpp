@@ -0,0 +1,122 @@
+#pragma once
+
+#include "TRTypes.hpp"
+#include <stdint.h>
+
+/*
+* Wall assignment table generated at compile time from the sensor mounting description.
+*
+* Headings follow EZ-Template, clockwise from +Y. World directions are counted in quarter turns clockwise from +Y, so 0 is the +Y wall, 1 the +X wall, 2 the -Y wall and 3 the -X wall.
+*/
+
+/**
+ * Mounting direction of each sensor in quarter turns clockwise from the front of the robot, ordered north, east, south, west.
+ */
+static constexpr uint8_t tr_sensor_mounts[4] = {0, 1, 2, 3};
+
+/**
+ * Which beam measures each axis and which wall it measures against.
+ */
+struct tr_wall_assignment
+{
+    /**
+     * Index of the beam measuring X and Y, ordered north, east, south, west.
+     */
+    uint8_t x_beam;
+    uint8_t y_beam;
+
+    /**
+     * Sign of the wall each beam measures against. Coordinate = sign * (wall_coord - distance).
+     */
+    int8_t x_sign;
+    int8_t y_sign;
+};
+
+/**
+ * @brief Quadrant of a position on the field. Positions on an axis count as positive, the same as tr_chassis::get_quadrant.
+ */
+constexpr tr_quadrant tr_position_quadrant(float x, float y)
+{
+    if (x < 0 && y > 0) return NEG_POS;
+    if (x < 0 && y < 0) return NEG_NEG;
+    if (x > 0 && y < 0) return POS_NEG;
+    return POS_POS;
+}
+
+/**
+ * @brief Turns a vector clockwise by quarter turns about the center of the field.
+ * @param quarters quarter turns from 0 to 3
+ */
+inline tr_vector2d tr_turn_quarters(double x, double y, int quarters)
+{
+    // Cosine and sine of each quarter turn, clockwise.
+    const double quarter_cos[4] = {1, 0, -1, 0};
+    const double quarter_sin[4] = {0, 1, 0, -1};
+    return tr_vector2d(quarter_cos[quarters] * x + quarter_sin[quarters] * y, quarter_cos[quarters] * y - quarter_sin[quarters] * x);
+}
+
+/**
+ * @brief Finds the beam that faces a world direction at a heading quadrant.
+ * @param direction world direction in quarter turns
+ * @param heading_quadrant heading quadrant in quarter turns
+ * @return Index of the beam, or 4 if no sensor faces that direction
+ */
+constexpr uint8_t tr_beam_facing(int direction, int heading_quadrant)
+{
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        if ((tr_sensor_mounts[i] + heading_quadrant) % 4 == direction) return i;
+    }
+    return 4;
+}
+
+/**
+ * @brief Generates the wall assignment of every robot quadrant and heading quadrant pair.
+ *
+ * A robot quadrant names the sign of X then Y, so POS_NEG measures X against the +X wall and Y against the -Y wall.
+ * Table is indexed [robot quadrant][heading quadrant].
+ */
+constexpr std::array<std::array<tr_wall_assignment, 4>, 4> tr_make_wall_table()
+{
+    std::array<std::array<tr_wall_assignment, 4>, 4> table = {};
+    const int8_t x_signs[4] = {1, -1, -1, 1};
+    const int8_t y_signs[4] = {1, 1, -1, -1};
+
+    for (int quadrant = 0; quadrant < 4; quadrant++)
+    {
+        for (int heading = 0; heading < 4; heading++)
+        {
+            tr_wall_assignment& entry = table[quadrant][heading];
+            entry.x_sign = x_signs[quadrant];
+            entry.y_sign = y_signs[quadrant];
+            entry.x_beam = tr_beam_facing(entry.x_sign > 0 ? 1 : 3, heading);
+            entry.y_beam = tr_beam_facing(entry.y_sign > 0 ? 0 : 2, heading);
+        }
+    }
+    return table;
+}
+
+/**
+ * Wall assignment table indexed [robot quadrant][heading quadrant].
+ */
+static constexpr std::array<std::array<tr_wall_assignment, 4>, 4> tr_wall_table = tr_make_wall_table();
+
+/**
+ * @brief Checks that every entry uses two different, existing beams, and that each beam faces the wall it is assigned to.
+ */
+constexpr bool tr_wall_table_consistent()
+{
+    for (int quadrant = 0; quadrant < 4; quadrant++)
+    {
+        for (int heading = 0; heading < 4; heading++)
+        {
+            const tr_wall_assignment& entry = tr_wall_table[quadrant][heading];
+            if (entry.x_beam > 3 || entry.y_beam > 3 || entry.x_beam == entry.y_beam) return false;
+            if ((tr_sensor_mounts[entry.x_beam] + heading) % 4 != (entry.x_sign > 0 ? 1 : 3)) return false;
+            if ((tr_sensor_mounts[entry.y_beam] + heading) % 4 != (entry.y_sign > 0 ? 0 : 2)) return false;
+        }
+    }
+    return true;
+}
+
+static_assert(tr_wall_table_consistent(), "TitanReset wall assignment table is inconsistent with the sensor mounts");
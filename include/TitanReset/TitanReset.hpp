@@ -4,4 +4,25 @@
 
 #include "TRChassis.hpp"
 #include "TRSensor.hpp"
-#include "TRTypes.hpp"
\ No newline at end of file
+#include "TRTypes.hpp"
+#include "TRUnits.hpp"
+#include "TRCalibration.hpp"
+#include "TRStartPose.hpp"
+#include "TRPoseTracker.hpp"
+#include "TRCorrection.hpp"
+#include "TRBeamModel.hpp"
+#include "TRAngle.hpp"
+#include "TRWalls.hpp"
+#include "TRMirror.hpp"
+#include "TRFieldMap.hpp"
+#include "TRAllocGuard.hpp"
+#include "TRRecorder.hpp"
+#include "TRAsync.hpp"
+#include "TRWallFollow.hpp"
+#include "TREvents.hpp"
+#include "TRTrust.hpp"
+#include "TROdomEstimator.hpp"
+#include "TRImuFusion.hpp"
+#include "TRGps.hpp"
+#include "TRDrivebase.hpp"
+#include "TRPlanPoint.hpp"
@@ -1,5 +1,12 @@
 #pragma once
 
+#include "TitanReset/TRTypes.hpp"
+
 void default_constants();
+void dsr_init_fallback(tr_quadrant quadrant, float heading);
 
-void distance_sensor_reset_example();
\ No newline at end of file
+void distance_sensor_reset_example();
+void distance_sensor_reset_waypoint_example();
+void distance_sensor_wall_following_example();
+void distance_sensor_event_example();
+void distance_sensor_mirrored_example();
\ No newline at end of file
@@ -6,6 +6,7 @@
 
 extern Drive chassis;
 extern tr_chassis dsr_system;
+extern tr_dsr_result start_reset;
 
 // Your motors, sensors, etc. should go here.  Below are examples
 
@@ -0,0 +1,86 @@
+#include "../../include/TitanReset/TRAllocGuard.hpp"
+#include <stdio.h>
+#include <stdlib.h>
+#include <new>
+
+/**
+ * Allocation counters. Plain integers are used as the V5 runs a single core and the counters are only informative.
+ */
+static volatile uint32_t allocation_count = 0;
+static volatile uint32_t violation_count = 0;
+
+tr_alloc_scope::tr_alloc_scope(const char* name) : name(name), start(allocation_count)
+{}
+
+tr_alloc_scope::~tr_alloc_scope()
+{
+    uint32_t made = allocation_count - start;
+    if (made == 0) return;
+
+    violation_count = violation_count + made;
+    printf("[TitanReset] %s made %lu heap allocation(s)\n", name, (unsigned long)made);
+}
+
+uint32_t tr_alloc_scope::violations()
+{
+    return violation_count;
+}
+
+uint32_t tr_alloc_scope::allocations()
+{
+    return allocation_count;
+}
+
+#ifdef TR_ALLOC_GUARD
+
+static void* tr_counted_alloc(size_t size)
+{
+    allocation_count = allocation_count + 1;
+    void* ptr = malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr) abort();
+    return ptr;
+}
+
+void* operator new(size_t size)
+{
+    return tr_counted_alloc(size);
+}
+
+void* operator new[](size_t size)
+{
+    return tr_counted_alloc(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    allocation_count = allocation_count + 1;
+    return malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    allocation_count = allocation_count + 1;
+    return malloc(size == 0 ? 1 : size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+#endif
@@ -0,0 +1,157 @@
+#include "../../include/TitanReset/TRAsync.hpp"
+#include <mutex>
+
+tr_dsr_handle::tr_dsr_handle() : slot(nullptr), generation(0), rejection(REJECT_EXPIRED)
+{}
+
+tr_dsr_handle::tr_dsr_handle(tr_dsr_slot* slot, uint32_t generation, tr_rejection_reason rejection) :
+            slot(slot),
+            generation(generation),
+            rejection(rejection)
+{}
+
+bool tr_dsr_handle::is_current() const
+{
+    // Orders the copy of the result before the generation is checked again after it.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot != nullptr && slot->generation.load() == generation;
+}
+
+tr_dsr_state tr_dsr_handle::get_state() const
+{
+    if (!is_current()) return DSR_REJECTED;
+
+    tr_dsr_state state = slot->state.load();
+
+    // The slot may have been reused between the two loads.
+    return is_current() ? state : DSR_REJECTED;
+}
+
+bool tr_dsr_handle::is_done() const
+{
+    tr_dsr_state state = get_state();
+    return state == DSR_DONE || state == DSR_REJECTED;
+}
+
+bool tr_dsr_handle::wait(uint32_t timeout) const
+{
+    uint32_t start_time = pros::millis();
+    while (!is_done())
+    {
+        if (pros::millis() - start_time >= timeout) return false;
+        pros::delay(1);
+    }
+    return true;
+}
+
+tr_vector3 tr_dsr_handle::get_pose() const
+{
+    if (!is_current()) return tr_vector3();
+    tr_vector3 pose = slot->pose;
+
+    // A submit reusing the slot during the copy bumps the generation first, so a torn copy is never reported as current.
+    return is_current() ? pose : tr_vector3();
+}
+
+tr_probability tr_dsr_handle::get_confidence() const
+{
+    if (!is_current()) return 0.0f;
+    tr_probability confidence = slot->result.confidence;
+    return is_current() ? confidence : 0.0f;
+}
+
+tr_rejection_reason tr_dsr_handle::get_rejection() const
+{
+    if (slot == nullptr) return rejection;
+    if (!is_current()) return REJECT_EXPIRED;
+    tr_rejection_reason reason = slot->result.rejection;
+    return is_current() ? reason : REJECT_EXPIRED;
+}
+
+tr_dsr_result tr_dsr_handle::get_result() const
+{
+    tr_dsr_result result = {};
+    result.rejection = slot == nullptr ? rejection : REJECT_EXPIRED;
+    if (!is_current()) return result;
+
+    tr_dsr_result copy = slot->result;
+    return is_current() ? copy : result;
+}
+
+tr_dsr_worker::tr_dsr_worker(tr_dsr_executor executor, void* context) :
+            executor(executor),
+            context(context),
+            task(nullptr),
+            slots(),
+            head(0),
+            tail(0),
+            submit_mutex()
+{
+    for (tr_dsr_slot& slot : slots)
+    {
+        slot.state = DSR_DONE;
+        slot.generation = 0;
+    }
+}
+
+tr_dsr_handle tr_dsr_worker::submit(bool use_quadrant, tr_quadrant quadrant, tr_dsr_trigger trigger)
+{
+    std::lock_guard<pros::Mutex> lock(submit_mutex);
+    tr_dsr_slot& slot = slots[tail];
+    tr_dsr_state state = slot.state.load();
+    if (state == DSR_QUEUED || state == DSR_WAITING || state == DSR_RUNNING) return tr_dsr_handle(nullptr, 0, REJECT_QUEUE_FULL);
+
+    if (task == nullptr)
+    {
+        task = pros::c::task_create(task_body, this, TASK_PRIORITY_DEFAULT, TASK_STACK_DEPTH_DEFAULT, "TR DSR Worker");
+        if (task == nullptr) return tr_dsr_handle(nullptr, 0, REJECT_QUEUE_FULL);
+    }
+
+    // Bumping the generation first expires any handle still pointing at the old result.
+    uint32_t generation = slot.generation.load() + 1;
+    slot.generation = generation;
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.use_quadrant = use_quadrant;
+    slot.quadrant = quadrant;
+    slot.trigger = trigger;
+    slot.pose = tr_vector3();
+    slot.result = {};
+    slot.result.rejection = REJECT_NONE;
+    slot.state = DSR_QUEUED;
+
+    tail = (tail + 1) % slot_count;
+    pros::c::task_notify(task);
+
+    return tr_dsr_handle(&slot, generation, REJECT_NONE);
+}
+
+void tr_dsr_worker::stop()
+{
+    std::lock_guard<pros::Mutex> lock(submit_mutex);
+    if (task == nullptr) return;
+
+    pros::c::task_delete(task);
+    task = nullptr;
+}
+
+void tr_dsr_worker::task_body(void* param)
+{
+    static_cast<tr_dsr_worker*>(param)->run();
+}
+
+void tr_dsr_worker::run()
+{
+    while (true)
+    {
+        pros::c::task_notify_take(true, TIMEOUT_MAX);
+
+        while (slots[head].state.load() == DSR_QUEUED)
+        {
+            tr_dsr_slot& slot = slots[head];
+            slot.state = DSR_RUNNING;
+            executor(context, slot);
+            slot.state = slot.result.applied ? DSR_DONE : DSR_REJECTED;
+            head = (head + 1) % slot_count;
+        }
+    }
+}
@@ -0,0 +1,164 @@
+#include "../../include/TitanReset/TRBeamModel.hpp"
+#include "../../include/TitanReset/TRConstants.hpp"
+#include "../../include/TitanReset/TRUnits.hpp"
+#include <math.h>
+
+/*
+* Datasheet accuracy of the V5 Distance Sensor, treated as one standard deviation.
+*/
+static constexpr float near_sigma = 15.0f / 25.4f;
+static constexpr float far_sigma_ratio = 0.05f;
+
+/**
+ * Lowest confidence used when scaling the variance, so a zero confidence reading does not divide by zero.
+ */
+static constexpr float min_confidence = 0.1f;
+
+/**
+ * Share of a predicted corner bias kept as model uncertainty in the variance.
+ */
+static constexpr float corner_model_error = 0.5f;
+
+typedef tr_quantity<tr_degree, float> tr_beam_degrees;
+
+tr_beam_trace tr_trace_beam(tr_vector2 origin, float facing)
+{
+    float rad = tr_beam_degrees(facing).to<tr_radian>().get();
+    float dir_x = sinf(rad);
+    float dir_y = cosf(rad);
+
+    float to_x_wall = HUGE_VALF;
+    float to_y_wall = HUGE_VALF;
+    if (dir_x > 1e-6f) to_x_wall = (wall_coord - origin.x) / dir_x;
+    if (dir_x < -1e-6f) to_x_wall = (-wall_coord - origin.x) / dir_x;
+    if (dir_y > 1e-6f) to_y_wall = (wall_coord - origin.y) / dir_y;
+    if (dir_y < -1e-6f) to_y_wall = (-wall_coord - origin.y) / dir_y;
+
+    tr_beam_trace trace;
+    trace.hits_x_wall = to_x_wall < to_y_wall;
+    trace.range = trace.hits_x_wall ? to_x_wall : to_y_wall;
+
+    float normal_component = fminf(1.0f, fabsf(trace.hits_x_wall ? dir_x : dir_y));
+    trace.incidence = tr_quantity<tr_radian, float>(acosf(normal_component)).to<tr_degree>().get();
+
+    float along_wall = trace.hits_x_wall ? origin.y + dir_y * trace.range : origin.x + dir_x * trace.range;
+    trace.corner_distance = wall_coord - fabsf(along_wall);
+    return trace;
+}
+
+tr_beam_model::tr_beam_model(float min_range, float max_range, float max_incidence, float cone_half_angle) :
+            min_range(min_range),
+            max_range(max_range),
+            max_incidence(max_incidence),
+            cone_half_angle(cone_half_angle)
+{
+    // Rays spread evenly across the cone with a Gaussian intensity profile whose edge sits at two standard deviations.
+    float weight_sum = 0;
+    for (int k = 0; k < cone_rays; k++)
+    {
+        float position = 2.0f * k / (cone_rays - 1) - 1.0f;
+        float offset = tr_beam_degrees(position * cone_half_angle).to<tr_radian>().get();
+        ray_sin[k] = sinf(offset);
+        ray_cos[k] = cosf(offset);
+        ray_weight[k] = expf(-2.0f * position * position);
+        weight_sum += ray_weight[k];
+    }
+    for (int k = 0; k < cone_rays; k++) ray_weight[k] /= weight_sum;
+}
+
+float tr_beam_model::cone_reach(float reading, float incidence) const
+{
+    // The edge of the cone tilted towards the corner lands furthest from the hit point.
+    float tilt = tr_beam_degrees(fabsf(incidence)).to<tr_radian>().get();
+    float edge = tr_beam_degrees(fabsf(incidence) + cone_half_angle).to<tr_radian>().get();
+    if (edge >= 1.55f) return HUGE_VALF;
+    return reading * cosf(tilt) * (tanf(edge) - tanf(tilt));
+}
+
+float tr_beam_model::flat_wall_range(float perpendicular_distance, float incidence) const
+{
+    float incidence_rad = tr_beam_degrees(incidence).to<tr_radian>().get();
+    float incidence_sin = sinf(incidence_rad);
+    float incidence_cos = cosf(incidence_rad);
+
+    float strength_sum = 0;
+    float range_sum = 0;
+    for (int k = 0; k < cone_rays; k++)
+    {
+        float ray_incidence_cos = incidence_cos * ray_cos[k] - incidence_sin * ray_sin[k];
+        if (ray_incidence_cos <= 0.05f) continue;
+
+        float range = perpendicular_distance / ray_incidence_cos;
+        float strength = ray_weight[k] * ray_incidence_cos / (range * range);
+        strength_sum += strength;
+        range_sum += strength * range;
+    }
+    return strength_sum > 0 ? range_sum / strength_sum : perpendicular_distance;
+}
+
+float tr_beam_model::expected_range(tr_vector2 origin, float facing) const
+{
+    tr_beam_trace ideal = tr_trace_beam(origin, facing);
+    return ideal.range + corner_bias(origin, facing, ideal);
+}
+
+float tr_beam_model::corner_bias(tr_vector2 origin, float facing, const tr_beam_trace& ideal) const
+{
+    // Away from corners the whole cone lands on one wall and the sensor reads the ideal range by calibration.
+    if (ideal.corner_distance >= cone_reach(ideal.range, ideal.incidence)) return 0;
+
+    float rad = tr_beam_degrees(facing).to<tr_radian>().get();
+    float dir_sin = sinf(rad);
+    float dir_cos = cosf(rad);
+
+    float strength_sum = 0;
+    float range_sum = 0;
+    for (int k = 0; k < cone_rays; k++)
+    {
+        float dir_x = dir_sin * ray_cos[k] + dir_cos * ray_sin[k];
+        float dir_y = dir_cos * ray_cos[k] - dir_sin * ray_sin[k];
+
+        float to_x_wall = HUGE_VALF;
+        float to_y_wall = HUGE_VALF;
+        if (dir_x > 1e-6f) to_x_wall = (wall_coord - origin.x) / dir_x;
+        if (dir_x < -1e-6f) to_x_wall = (-wall_coord - origin.x) / dir_x;
+        if (dir_y > 1e-6f) to_y_wall = (wall_coord - origin.y) / dir_y;
+        if (dir_y < -1e-6f) to_y_wall = (-wall_coord - origin.y) / dir_y;
+
+        bool hits_x_wall = to_x_wall < to_y_wall;
+        float range = hits_x_wall ? to_x_wall : to_y_wall;
+        float incidence_cos = fabsf(hits_x_wall ? dir_x : dir_y);
+        if (range <= 0) continue;
+
+        float strength = ray_weight[k] * incidence_cos / (range * range);
+        strength_sum += strength;
+        range_sum += strength * range;
+    }
+    if (strength_sum <= 0) return 0;
+
+    // Measured against the same cone on a flat wall, so the calibration of the sensor cancels out.
+    float perpendicular_distance = ideal.range * cosf(tr_beam_degrees(ideal.incidence).to<tr_radian>().get());
+    return range_sum / strength_sum - flat_wall_range(perpendicular_distance, ideal.incidence);
+}
+
+tr_beam_quality tr_beam_model::evaluate(float reading, float confidence, float incidence, float corner_bias) const
+{
+    tr_beam_quality quality;
+    quality.variance = HUGE_VALF;
+    quality.confidence = confidence;
+
+    if (reading == err_reading_value) quality.validity = BEAM_NO_READING;
+    else if (reading < min_range) quality.validity = BEAM_TOO_CLOSE;
+    else if (reading > max_range) quality.validity = BEAM_TOO_FAR;
+    else if (fabsf(incidence) > max_incidence) quality.validity = BEAM_STEEP_INCIDENCE;
+    else if (fabsf(corner_bias) > max_corner_bias) quality.validity = BEAM_NEAR_CORNER;
+    else quality.validity = BEAM_VALID;
+
+    if (quality.validity != BEAM_VALID) return quality;
+
+    float sigma = fmaxf(near_sigma, far_sigma_ratio * reading);
+    float incidence_cos = cosf(tr_beam_degrees(incidence).to<tr_radian>().get());
+    float model_sigma = corner_model_error * corner_bias;
+    quality.variance = sigma * sigma / (incidence_cos * incidence_cos * fmaxf(confidence, min_confidence)) + model_sigma * model_sigma;
+    return quality;
+}
@@ -0,0 +1,55 @@
+#include "../../include/TitanReset/TRBeams.hpp"
+#include "../../include/TitanReset/TRUnits.hpp"
+#include <math.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define TR_BEAMS_NEON
+#elif defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define TR_BEAMS_SSE
+#endif
+
+void tr_fast_sincos(float rad, float& sin_out, float& cos_out)
+{
+    // Taylor series truncated after the x^7 and x^8 terms. At pi/4 the next terms are below 1e-6.
+    float x2 = rad * rad;
+    sin_out = rad * (1.0f + x2 * (-1.0f / 6.0f + x2 * (1.0f / 120.0f + x2 * (-1.0f / 5040.0f))));
+    cos_out = 1.0f + x2 * (-0.5f + x2 * (1.0f / 24.0f + x2 * (-1.0f / 720.0f + x2 * (1.0f / 40320.0f))));
+}
+
+void tr_beam_transform(float heading_error, const float readings[4], const float parallel[4], const float perpendicular[4], float out[4])
+{
+    float s;
+    float c;
+    tr_fast_sincos(tr_quantity<tr_degree, float>(heading_error).to<tr_radian>().get(), s, c);
+
+#if defined(TR_BEAMS_NEON)
+    float32x4_t along = vaddq_f32(vld1q_f32(readings), vld1q_f32(parallel));
+    float32x4_t result = vmulq_n_f32(along, c);
+    result = vmlsq_n_f32(result, vld1q_f32(perpendicular), s);
+    vst1q_f32(out, result);
+#elif defined(TR_BEAMS_SSE)
+    __m128 along = _mm_add_ps(_mm_loadu_ps(readings), _mm_loadu_ps(parallel));
+    __m128 result = _mm_sub_ps(_mm_mul_ps(along, _mm_set1_ps(c)), _mm_mul_ps(_mm_loadu_ps(perpendicular), _mm_set1_ps(s)));
+    _mm_storeu_ps(out, result);
+#else
+    for (int i = 0; i < 4; i++)
+    {
+        out[i] = c * (readings[i] + parallel[i]) - s * perpendicular[i];
+    }
+#endif
+}
+
+void tr_beam_transform_scalar(float heading_error, const float readings[4], const float parallel[4], const float perpendicular[4], float out[4])
+{
+    double heading_err_rad = tr_quantity<tr_degree, double>(heading_error).to<tr_radian>().get();
+
+    for (int i = 0; i < 4; i++)
+    {
+        float actual_reading = cos(heading_err_rad) * readings[i];
+        float parallel_offset = cos(heading_err_rad) * parallel[i];
+        float perpendicular_offset = sin(heading_err_rad) * perpendicular[i];
+        out[i] = actual_reading + parallel_offset - perpendicular_offset;
+    }
+}
@@ -0,0 +1,347 @@
+#include "../../include/TitanReset/TRCalibration.hpp"
+#include "../../include/TitanReset/TRChassis.hpp"
+#include "../../include/TitanReset/TRWalls.hpp"
+#include "../../include/TitanReset/TRCorrection.hpp"
+#include "../../include/TitanReset/TRUnits.hpp"
+#include "../../include/pros/rtos.hpp"
+#include <math.h>
+#include <stdio.h>
+
+/*
+* Solver limits. A mounting outside of these is treated as a failed fit rather than applied.
+*/
+static constexpr int solver_iterations = 100;
+static constexpr double max_yaw_rad = 15.0 * tr_degree::scale;
+static constexpr double max_rms = 1.0;
+static constexpr double outlier_sigma = 3.0;
+
+/*
+* Layout of the correction tables built from calibration samples, 0 to 1984 mm by 0 to 45 degrees.
+*/
+static constexpr int correction_range_bins = 32;
+static constexpr float correction_range_step_mm = 64;
+static constexpr int correction_angle_bins = 16;
+static constexpr float correction_angle_step_deg = 3;
+
+double tr_predict_reading(const tr_calibration_sample& sample, int mount, double parallel, double perpendicular, double yaw_rad, double* incidence_deg)
+{
+    // Nominal facing of the sensor, clockwise from +Y
+    double facing = tr_quantity<tr_degree, double>(sample.heading + 90.0 * mount).to<tr_radian>().get();
+    double facing_sin = sin(facing);
+    double facing_cos = cos(facing);
+
+    // Perpendicular offsets are to the right of the facing
+    double origin_x = sample.x + parallel * facing_sin + perpendicular * facing_cos;
+    double origin_y = sample.y + parallel * facing_cos - perpendicular * facing_sin;
+
+    double beam_x = sin(facing + yaw_rad);
+    double beam_y = cos(facing + yaw_rad);
+
+    double to_x_wall = HUGE_VAL;
+    double to_y_wall = HUGE_VAL;
+    if (beam_x > 1e-9) to_x_wall = (wall_coord - origin_x) / beam_x;
+    if (beam_x < -1e-9) to_x_wall = (-wall_coord - origin_x) / beam_x;
+    if (beam_y > 1e-9) to_y_wall = (wall_coord - origin_y) / beam_y;
+    if (beam_y < -1e-9) to_y_wall = (-wall_coord - origin_y) / beam_y;
+
+    bool hits_x_wall = to_x_wall < to_y_wall;
+    if (incidence_deg != nullptr)
+    {
+        double normal_component = fmin(1.0, fabs(hits_x_wall ? beam_x : beam_y));
+        *incidence_deg = tr_quantity<tr_radian, double>(acos(normal_component)).to<tr_degree>().get();
+    }
+    return hits_x_wall ? to_x_wall : to_y_wall;
+}
+
+/**
+ * @brief Solves a 3x3 linear system by Gaussian elimination with partial pivoting.
+ * @return Whether the system was solvable
+ */
+static bool solve_3x3(double a[3][3], double b[3], double x[3])
+{
+    for (int col = 0; col < 3; col++)
+    {
+        int pivot = col;
+        for (int row = col + 1; row < 3; row++)
+        {
+            if (fabs(a[row][col]) > fabs(a[pivot][col])) pivot = row;
+        }
+        if (fabs(a[pivot][col]) < 1e-12) return false;
+
+        for (int k = 0; k < 3; k++)
+        {
+            double swap = a[col][k];
+            a[col][k] = a[pivot][k];
+            a[pivot][k] = swap;
+        }
+        double swap = b[col];
+        b[col] = b[pivot];
+        b[pivot] = swap;
+
+        for (int row = col + 1; row < 3; row++)
+        {
+            double factor = a[row][col] / a[col][col];
+            for (int k = col; k < 3; k++) a[row][k] -= factor * a[col][k];
+            b[row] -= factor * b[col];
+        }
+    }
+
+    for (int row = 2; row >= 0; row--)
+    {
+        double sum = b[row];
+        for (int k = row + 1; k < 3; k++) sum -= a[row][k] * x[k];
+        x[row] = sum / a[row][row];
+    }
+    return true;
+}
+
+/**
+ * @brief Sum of squared residuals over the samples that are kept.
+ */
+static double calibration_cost(const tr_calibration_sample* samples, const bool* keep, int count, int mount, const double params[3])
+{
+    double cost = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (!keep[i]) continue;
+        double residual = samples[i].reading - tr_predict_reading(samples[i], mount, params[0], params[1], params[2]);
+        cost += residual * residual;
+    }
+    return cost;
+}
+
+/**
+ * @brief Levenberg-Marquardt fit of the mounting over the samples that are kept.
+ * @return Whether the normal equations stayed solvable
+ */
+static bool calibration_fit(const tr_calibration_sample* samples, const bool* keep, int count, int mount, double params[3])
+{
+    double lambda = 1e-3;
+    double cost = calibration_cost(samples, keep, count, mount, params);
+
+    for (int iteration = 0; iteration < solver_iterations; iteration++)
+    {
+        double jtj[3][3] = {};
+        double jtr[3] = {};
+
+        for (int i = 0; i < count; i++)
+        {
+            if (!keep[i]) continue;
+            double predicted = tr_predict_reading(samples[i], mount, params[0], params[1], params[2]);
+            double residual = samples[i].reading - predicted;
+
+            // Central differences, the wall intersection is piecewise so analytic derivatives buy little.
+            double jacobian[3];
+            for (int k = 0; k < 3; k++)
+            {
+                const double step = 1e-5;
+                double high[3] = {params[0], params[1], params[2]};
+                double low[3] = {params[0], params[1], params[2]};
+                high[k] += step;
+                low[k] -= step;
+                jacobian[k] = (tr_predict_reading(samples[i], mount, high[0], high[1], high[2]) -
+                               tr_predict_reading(samples[i], mount, low[0], low[1], low[2])) / (2 * step);
+            }
+
+            for (int r = 0; r < 3; r++)
+            {
+                jtr[r] += jacobian[r] * residual;
+                for (int c = 0; c < 3; c++) jtj[r][c] += jacobian[r] * jacobian[c];
+            }
+        }
+
+        bool improved = false;
+        while (!improved && lambda < 1e6)
+        {
+            double damped[3][3];
+            double rhs[3] = {jtr[0], jtr[1], jtr[2]};
+            double delta[3];
+            for (int r = 0; r < 3; r++)
+            {
+                for (int c = 0; c < 3; c++) damped[r][c] = jtj[r][c];
+                damped[r][r] += lambda * (jtj[r][r] + 1e-9);
+            }
+            if (!solve_3x3(damped, rhs, delta)) return false;
+
+            double trial[3] = {params[0] + delta[0], params[1] + delta[1], params[2] + delta[2]};
+            double trial_cost = calibration_cost(samples, keep, count, mount, trial);
+            if (trial_cost < cost)
+            {
+                bool converged = cost - trial_cost < 1e-12 * (1 + cost);
+                params[0] = trial[0];
+                params[1] = trial[1];
+                params[2] = trial[2];
+                cost = trial_cost;
+                lambda *= 0.3;
+                improved = true;
+                if (converged) return true;
+            }
+            else
+            {
+                lambda *= 10;
+            }
+        }
+        if (!improved) return true;
+    }
+    return true;
+}
+
+tr_sensor_calibration tr_solve_mounting(const tr_calibration_sample* samples, int count, int mount, tr_vector2 initial)
+{
+    tr_sensor_calibration result = {};
+    result.offset = initial;
+    if (count < tr_calibrator::min_samples || count > tr_calibrator::max_samples) return result;
+
+    bool keep[tr_calibrator::max_samples];
+    for (int i = 0; i < count; i++) keep[i] = true;
+
+    double params[3] = {initial.x, initial.y, 0.0};
+    if (!calibration_fit(samples, keep, count, mount, params)) return result;
+
+    // Drop readings far off the first fit, usually the beam clipping a corner or an object, then fit again.
+    double rms = sqrt(calibration_cost(samples, keep, count, mount, params) / count);
+    int kept = 0;
+    for (int i = 0; i < count; i++)
+    {
+        double residual = samples[i].reading - tr_predict_reading(samples[i], mount, params[0], params[1], params[2]);
+        keep[i] = fabs(residual) <= outlier_sigma * rms + 1e-6;
+        if (keep[i]) kept++;
+    }
+    if (kept < tr_calibrator::min_samples) return result;
+    if (!calibration_fit(samples, keep, count, mount, params)) return result;
+
+    rms = sqrt(calibration_cost(samples, keep, count, mount, params) / kept);
+
+    result.offset = tr_vector2(params[0], params[1]);
+    result.yaw = tr_quantity<tr_radian, double>(params[2]).to<tr_degree>().get();
+    result.rms = rms;
+    result.samples = kept;
+    result.valid = isfinite(rms) && rms <= max_rms && fabs(params[2]) <= max_yaw_rad;
+    return result;
+}
+
+tr_calibrator::tr_calibrator(tr_chassis* chassis) :
+            chassis(chassis),
+            use_known_position(false),
+            known_position(),
+            samples(),
+            sample_count()
+{}
+
+void tr_calibrator::set_known_position(tr_vector2 position)
+{
+    known_position = position;
+    use_known_position = true;
+}
+
+void tr_calibrator::clear_known_position()
+{
+    use_known_position = false;
+}
+
+void tr_calibrator::clear()
+{
+    for (int i = 0; i < 4; i++) sample_count[i] = 0;
+}
+
+int tr_calibrator::sample()
+{
+    tr_pose pose = chassis->chassis.get_pose();
+    if (use_known_position)
+    {
+        pose.x = known_position.x;
+        pose.y = known_position.y;
+    }
+
+    tr_sensor* sensors[4] = {chassis->north, chassis->east, chassis->south, chassis->west};
+    int sampled = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        if (sample_count[i] >= max_samples) continue;
+
+        float reading = sensors[i]->distance().get_value();
+        if (reading == err_reading_value) continue;
+
+        tr_calibration_sample& entry = samples[i][sample_count[i]++];
+        entry.x = pose.x;
+        entry.y = pose.y;
+        entry.heading = pose.theta;
+        entry.reading = reading;
+        sampled++;
+    }
+    return sampled;
+}
+
+int tr_calibrator::record(uint32_t duration, uint32_t period)
+{
+    int rounds = 0;
+    uint32_t start_time = pros::millis();
+    uint32_t last = start_time;
+    while (pros::millis() - start_time < duration)
+    {
+        if (sample() > 0) rounds++;
+        pros::c::task_delay_until(&last, period);
+    }
+    return rounds;
+}
+
+int tr_calibrator::get_sample_count(int sensor) const
+{
+    return sample_count[sensor & 3];
+}
+
+tr_sensor_calibration tr_calibrator::solve(int sensor) const
+{
+    tr_sensor* sensors[4] = {chassis->north, chassis->east, chassis->south, chassis->west};
+    sensor &= 3;
+    return tr_solve_mounting(samples[sensor], sample_count[sensor], tr_sensor_mounts[sensor], sensors[sensor]->get_offset());
+}
+
+bool tr_calibrator::save(const char* path)
+{
+    tr_sensor* sensors[4] = {chassis->north, chassis->east, chassis->south, chassis->west};
+    for (int i = 0; i < 4; i++)
+    {
+        tr_sensor_calibration calibration = solve(i);
+        if (calibration.valid) sensors[i]->set_calibration(calibration.offset, calibration.yaw);
+    }
+
+    FILE* file = fopen(path, "w");
+    if (file == nullptr) return false;
+
+    // Sensors that failed to solve keep their current mounting in the file.
+    bool ok = true;
+    for (tr_sensor* sensor : sensors)
+    {
+        tr_vector2 offset = sensor->get_offset();
+        ok = ok && fprintf(file, "%d %f %f %f\n", sensor->get_port(), (double)offset.x, (double)offset.y, (double)sensor->get_yaw()) > 0;
+    }
+    return fclose(file) == 0 && ok;
+}
+
+int tr_calibrator::save_corrections(const char* format)
+{
+    tr_sensor* sensors[4] = {chassis->north, chassis->east, chassis->south, chassis->west};
+    static tr_correction_sample corrections[max_samples];
+    int written = 0;
+
+    for (int i = 0; i < 4; i++)
+    {
+        tr_vector2 offset = sensors[i]->get_offset();
+        double yaw_rad = tr_quantity<tr_degree, double>(sensors[i]->get_yaw()).to<tr_radian>().get();
+
+        for (int k = 0; k < sample_count[i]; k++)
+        {
+            double incidence;
+            double expected = tr_predict_reading(samples[i][k], tr_sensor_mounts[i], offset.x, offset.y, yaw_rad, &incidence);
+            corrections[k].raw_mm = tr_quantity<tr_inch, float>(samples[i][k].reading).to<tr_millimetre>().get();
+            corrections[k].incidence_deg = incidence;
+            corrections[k].true_mm = tr_quantity<tr_inch, double>(expected).to<tr_millimetre>().get();
+        }
+
+        char path[64];
+        snprintf(path, sizeof(path), format, sensors[i]->get_port());
+        if (tr_correction_table::build(path, corrections, sample_count[i], correction_range_bins, 0, correction_range_step_mm, correction_angle_bins, correction_angle_step_deg)) written++;
+    }
+    return written;
+}
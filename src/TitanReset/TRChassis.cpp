@@ -1,68 +1,60 @@
 #include "../../include/TitanReset/TRChassis.hpp"
 #include "../../include/TitanReset/TRConstants.hpp"
+#include "../../include/TitanReset/TRAngle.hpp"
+#include "../../include/TitanReset/TRBeams.hpp"
+#include "../../include/TitanReset/TRWalls.hpp"
 #include "../../include/pros/imu.hpp"
 #include "../../include/pros/llemu.hpp"
 #include "../../include/EZ-Template/util.hpp"
 #include "../../include/EZ-Template/drive/drive.hpp"
-#include <fstream>
+#include "../../include/TitanReset/TRAllocGuard.hpp"
+#include "../../include/TitanReset/TRUnits.hpp"
+#include <math.h>
+#include <stdio.h>
+#include <mutex>
 
 /**
- * @brief Implemented version of the generic drivebase class to enable support with ez-template.
+ * Times the position is recalculated after taking the predicted corner bias out of the assigned beams.
  */
-class tr_ez_base : public tr_drivebase_generic
-{
-    public:
-    ez::Drive* chassis;
-
-    tr_ez_base(ez::Drive* chassis_ptr) : chassis(chassis_ptr) {}
-
-    tr_vector3 getPose() override
-    {
-        tr_vector3 vec_ret;
-        ez::pose current = chassis->odom_pose_get();
-
-        vec_ret.x = current.x;
-        vec_ret.y = current.y;
-        vec_ret.z = current.theta;
-
-        return vec_ret;
-    }
+static constexpr int corner_passes = 2;
 
-    void setPose(tr_vector3 new_pose) override
-    {
-        ez::pose set_pose(0,0,0);
+/*
+* Waypoint resets poll odometry at this period and keep enough history to look back over the latency of the distance sensors.
+* V5 Distance Sensor readings trail odometry by roughly 30 ms.
+*/
+static constexpr uint32_t waypoint_poll_period = 10;
+static constexpr int reading_latency_polls = 3;
 
-        set_pose.x = new_pose.x;
-        set_pose.y = new_pose.y;
-        set_pose.theta = new_pose.z;
+/**
+ * Largest heading error to the walls in degrees and turn rate in degrees per second a reset is taken on the move at.
+ */
+static constexpr float waypoint_max_heading_error = 15.0f;
+static constexpr float waypoint_max_turn_rate = 90.0f;
 
-        chassis->odom_pose_set(set_pose);
-    }
-};
+/**
+ * Largest heading error to the walls in degrees and turn rate in degrees per second the wall follower corrects at. Tighter than waypoint
+ * resets, as a skewed side beam slides along the wall as the robot drives.
+ */
+static constexpr float follow_max_heading_error = 5.0f;
+static constexpr float follow_max_turn_rate = 30.0f;
 
-static const tr_options default_options = {};
+/**
+ * Time in milliseconds the pose is held after rescaling odometry, two periods of the EZ-Template odometry task.
+ */
+static constexpr uint32_t scale_settle_time = 20;
 
 float tr_chassis::quadrant_recursive(float heading)
 {
-    if (heading < 0.0f)
-    {
-        return quadrant_recursive(heading + 360.0f);
-    }
-
-    if (heading > 360.0f)
-    {
-        return quadrant_recursive(heading - 360.0f);
-    }
-
-    return heading;
+    return tr_angle::from_degrees(heading).to_degrees();
 }
 
 bool tr_chassis::can_position_exist(tr_vector3 pose)
 {
+    (void)pose;
     return true;
 }
 
-std::string tr_chassis::get_quadrant_string(tr_quadrant quadr)
+const char* tr_chassis::get_quadrant_string(tr_quadrant quadr)
 {
     switch (quadr)
     {
@@ -84,334 +76,626 @@ void tr_chassis::set_active_sensors(int sensors)
     active_sensors |= sensors;
 }
 
-tr_chassis::tr_chassis(pros::Imu *inertial, ez::Drive* chas ,std::array<tr_sensor *,4> sensors) : options(default_options), active_sensors(0), b_display(false), location_task(nullptr)
+tr_chassis::tr_chassis(pros::Imu *inertial, tr_drivebase base, std::array<tr_sensor *,4> sensors, tr_options settings) : b_display(false), active_sensors(0), location_recorder(record_location, this), dsr_worker(execute_async_dsr, this), wall_follower(follow_wall, this), follow_reference(), follow_primed(false), beam_lengths(), beam_readings(), beam_model(), beam_quality(), gps(nullptr), imu_fusion(nullptr), chassis(base), options(settings), trust_policy(settings.sensor_trust, settings.max_correction, settings.max_residual, settings.max_variance), last_reset_from(), last_reset_to(), last_reset_sensors(0), last_reset_beams(), reset_count(0), event_detector(sample_events, this), event_reference(), event_reference_correction(), event_primed(false), correction_total(), odom_estimator(), anchor_rotation(0), anchor_valid(false), follow_correction()
 {
     north = sensors.at(0);
     east = sensors.at(1);
     south = sensors.at(2);
     west = sensors.at(3);
     imu = inertial;
-    chassis = new tr_ez_base(chas);
 }
 
-tr_chassis::tr_chassis(pros::Imu *inertial, tr_drivebase_generic* chas ,std::array<tr_sensor *,4> sensors) : options(default_options), active_sensors(0), b_display(false), location_task(nullptr)
+tr_chassis::tr_chassis(tr_imu_fusion* fusion, tr_drivebase base, std::array<tr_sensor*,4> sensors, tr_options settings) : tr_chassis(static_cast<pros::Imu*>(fusion), base, sensors, settings)
 {
-    north = sensors.at(0);
-    east = sensors.at(1);
-    south = sensors.at(2);
-    west = sensors.at(3);
-    imu = inertial;
-    chassis = chas;
+    imu_fusion = fusion;
+    fusion->set_drivebase(&chassis);
 }
 
 tr_chassis::~tr_chassis()
 {
-    delete chassis;
+    // The background tasks step through a pointer to the chassis until they exit, so they are waited for without a timeout.
+    wall_follower.stop(TIMEOUT_MAX);
+    event_detector.stop(TIMEOUT_MAX);
+    location_recorder.stop(TIMEOUT_MAX);
+
+    // The fusion outlives the chassis and would keep writing through its drivebase.
+    if (imu_fusion != nullptr) imu_fusion->set_drivebase(nullptr);
+
+    // The worker only touches the chassis under the lock, so once it is held the task can be deleted wherever it is.
+    std::lock_guard<pros::Mutex> lock(dsr_mutex);
+    dsr_worker.stop();
 }
 
 tr_quadrant tr_chassis::sensor_relevancy()
 {
-    float heading = quadrant_recursive(chassis->getPose().z);
+    return tr_angle::from_degrees(chassis.get_pose().theta).quadrant();
+}
+
+tr_quadrant tr_chassis::sensor_relevancy(float heading)
+{
+    return tr_angle::from_degrees(heading).quadrant();
+}
+
+tr_quadrant tr_chassis::get_quadrant()
+{
+    return chassis.get_mirror().quadrant(field_quadrant());
+}
+
+tr_quadrant tr_chassis::field_quadrant()
+{
+    tr_pose cur_pose = chassis.get_pose();
+    return tr_position_quadrant(cur_pose.x, cur_pose.y);
+}
+
+//n_p, n_p
+tr_conf_pair<tr_vector3> tr_chassis::get_position_calculation(tr_quadrant quadrant)
+{
+    std::lock_guard<pros::Mutex> lock(dsr_mutex);
+    return calculate_position(quadrant, chassis.get_pose().theta);
+}
+
+tr_conf_pair<tr_vector3> tr_chassis::get_position_calculation(tr_quadrant quadrant, float heading)
+{
+    std::lock_guard<pros::Mutex> lock(dsr_mutex);
+    return calculate_position(quadrant, heading);
+}
+
+tr_conf_pair<tr_vector3> tr_chassis::calculate_position(tr_quadrant quadrant, float heading)
+{
+    TR_NO_ALLOC("calculate_position");
+    float normal_heading = quadrant_recursive(heading);
+    tr_quadrant theta_quad = sensor_relevancy(normal_heading);
 
-    if ((heading >= 0 && heading <= 45) || (heading <= 360 && heading > 315))
+    tr_conf_pair<float> n_dist = north->distance();
+    tr_conf_pair<float> e_dist = east->distance();
+    tr_conf_pair<float> s_dist = south->distance();
+    tr_conf_pair<float> w_dist = west->distance();
+
+    // All four beams share the heading error, so they are transformed together in one pass.
+    tr_distance* beams[4] = {&n_dist, &e_dist, &s_dist, &w_dist};
+    tr_sensor* beam_sensors[4] = {north, east, south, west};
+    float heading_error = tr_sensor::relative_square(normal_heading);
+    float readings[4];
+    float along[4];
+    float parallel[4];
+    float perpendicular[4];
+    float transformed[4];
+    float beam_cos[4];
+    for (int i = 0; i < 4; i++)
     {
-        return tr_quadrant::POS_POS;
+        // Mounting yaw folds into the beam and perpendicular terms, so the batched transform stays unchanged.
+        float across;
+        readings[i] = beam_sensors[i]->correct(beams[i]->get_value(), heading_error);
+        beam_sensors[i]->beam_components(readings[i], along[i], across);
+        parallel[i] = beam_sensors[i]->get_offset().x;
+        perpendicular[i] = beam_sensors[i]->get_offset().y + across;
+
+        // Change of the transformed distance per inch of reading.
+        beam_cos[i] = cosf(tr_quantity<tr_degree, float>(heading_error + beam_sensors[i]->get_yaw()).to<tr_radian>().get());
     }
 
-    if (heading > 45 && heading <= 135)
+    tr_beam_transform(heading_error, along, parallel, perpendicular, transformed);
+
+    for (int i = 0; i < 4; i++)
     {
-        return tr_quadrant::NEG_POS;
+        if (readings[i] != err_reading_value) beams[i]->set_value(transformed[i]);
+        beam_lengths[i] = readings[i] != err_reading_value ? transformed[i] : -1.0f;
+        beam_readings[i] = readings[i];
     }
 
-    if (heading > 135 && heading <= 225)
+    tr_conf_pair<tr_vector3> ret = tr_conf_pair<tr_vector3>();
+
+    const int flags[4] = {NORTH, EAST, SOUTH, WEST};
+    const tr_wall_assignment& walls = tr_wall_table[quadrant & 3][theta_quad & 3];
+
+    x_beam = flags[walls.x_beam];
+    y_beam = flags[walls.y_beam];
+    ret.set_confidence(conf_avg(*beams[walls.x_beam], *beams[walls.y_beam]));
+    set_active_sensors(x_beam | y_beam);
+
+    beam_error = readings[walls.x_beam] == err_reading_value || readings[walls.y_beam] == err_reading_value;
+
+    // Near a corner the cone of an assigned beam catches the adjacent wall and reads short. The bias is predicted from the
+    // calculated position and taken out of the beam, then the position is calculated again with the corrected beam.
+    float bias[4] = {};
+    float x = 0;
+    float y = 0;
+    for (int pass = 0; pass <= corner_passes; pass++)
     {
-        return tr_quadrant::NEG_NEG;
+        x = walls.x_sign * (wall_coord - (beams[walls.x_beam]->get_value() - bias[walls.x_beam] * beam_cos[walls.x_beam]));
+        y = walls.y_sign * (wall_coord - (beams[walls.y_beam]->get_value() - bias[walls.y_beam] * beam_cos[walls.y_beam]));
+        if (beam_error || pass == corner_passes) break;
+
+        const int assigned[2] = {walls.x_beam, walls.y_beam};
+        for (int i : assigned)
+        {
+            float facing = normal_heading + 90.0f * tr_sensor_mounts[i];
+            tr_vector2 origin = beam_sensors[i]->get_origin(tr_vector2(x, y), facing);
+            facing += beam_sensors[i]->get_yaw();
+            bias[i] = beam_model.corner_bias(origin, facing, tr_trace_beam(origin, facing));
+        }
     }
 
-    if (heading > 225 && heading <= 315)
+    ret.set_value(tr_vector3(x, y, normal_heading));
+
+    // Rate every beam by tracing it from the calculated position. An assigned beam that lands on the other axis' wall is looking into a corner.
+    for (int i = 0; i < 4; i++)
     {
-        return tr_quadrant::POS_NEG;
+        float facing = normal_heading + 90.0f * tr_sensor_mounts[i];
+        tr_vector2 origin = beam_sensors[i]->get_origin(tr_vector2(x, y), facing);
+        facing += beam_sensors[i]->get_yaw();
+        tr_beam_trace trace = tr_trace_beam(origin, facing);
+        beam_quality[i] = beam_model.evaluate(readings[i], beams[i]->get_confidence(), trace.incidence, beam_model.corner_bias(origin, facing, trace));
+
+        bool wrong_wall = (i == walls.x_beam && !trace.hits_x_wall) || (i == walls.y_beam && trace.hits_x_wall);
+        if (beam_quality[i].is_valid() && wrong_wall) beam_quality[i].validity = BEAM_NEAR_CORNER;
     }
 
-    return tr_quadrant::NEG_NEG;
+    if (!can_position_exist(tr_vector3(x, y, normal_heading))) ret.set_confidence(0);
+
+    return ret;
 }
 
-tr_quadrant tr_chassis::sensor_relevancy(float heading)
+float tr_chassis::conf_avg(tr_distance one, tr_distance two)
 {
-    if ((heading >= 0 && heading <= 45) || (heading <= 360 && heading > 315))
+    return (one.get_confidence() + two.get_confidence()) / 2.0f;
+}
+
+tr_dsr_result tr_chassis::perform_dsr()
+{
+    std::lock_guard<pros::Mutex> lock(dsr_mutex);
+    return apply_dsr(field_quadrant(), true);
+}
+
+tr_dsr_result tr_chassis::perform_dsr_quad(tr_quadrant quadrant)
+{
+    std::lock_guard<pros::Mutex> lock(dsr_mutex);
+    return apply_dsr(chassis.get_mirror().quadrant(quadrant), true);
+}
+
+tr_dsr_handle tr_chassis::perform_dsr_async()
+{
+    return dsr_worker.submit(false, POS_POS);
+}
+
+tr_dsr_handle tr_chassis::perform_dsr_quad_async(tr_quadrant quadrant)
+{
+    return dsr_worker.submit(true, chassis.get_mirror().quadrant(quadrant));
+}
+
+tr_dsr_handle tr_chassis::perform_dsr_at_point(tr_vector2 point, uint32_t timeout)
+{
+    tr_pose pose = chassis.get_pose();
+    return dsr_worker.submit(false, POS_POS, {true, chassis.get_mirror().point(point), tr_vector2(pose.x, pose.y), timeout});
+}
+
+tr_dsr_handle tr_chassis::perform_dsr_at_index(const std::vector<ez::odom>& path, int index, uint32_t timeout)
+{
+    tr_pose pose = chassis.get_pose();
+    tr_vector2 from(pose.x, pose.y);
+
+    // An index outside of the path can never be passed, so it is rejected by the worker straight away.
+    if (index < 0 || index >= (int)path.size()) return dsr_worker.submit(false, POS_POS, {true, from, from, 0});
+
+    const tr_mirror& mirror = chassis.get_mirror();
+    tr_vector2 point = mirror.point(tr_vector2(path[index].target.x, path[index].target.y));
+    if (index > 0) from = mirror.point(tr_vector2(path[index - 1].target.x, path[index - 1].target.y));
+    return dsr_worker.submit(false, POS_POS, {true, point, from, timeout});
+}
+
+void tr_chassis::execute_async_dsr(void* param, tr_dsr_slot& slot)
+{
+    tr_chassis* self = static_cast<tr_chassis*>(param);
+    if (slot.trigger.enabled) slot.result = self->apply_dsr_at_waypoint(slot);
+
+    std::lock_guard<pros::Mutex> lock(self->dsr_mutex);
+    if (!slot.trigger.enabled) slot.result = self->apply_dsr(slot.use_quadrant ? slot.quadrant : self->field_quadrant(), true);
+    slot.pose = self->chassis.get_pose().to_vector();
+}
+
+tr_dsr_result tr_chassis::apply_dsr_at_waypoint(tr_dsr_slot& slot)
+{
+    slot.state = DSR_WAITING;
+
+    tr_dsr_result result = {};
+    result.rejection = REJECT_WAYPOINT_MISSED;
+
+    const tr_dsr_trigger& trigger = slot.trigger;
+    float approach_x = trigger.point.x - trigger.from.x;
+    float approach_y = trigger.point.y - trigger.from.y;
+
+    tr_pose history[reading_latency_polls + 1] = {};
+    int polls = 0;
+    bool passed = false;
+
+    uint32_t start_time = pros::millis();
+    uint32_t last = start_time;
+    while (pros::millis() - start_time < trigger.timeout)
     {
-        return tr_quadrant::POS_POS;
+        // The lock is only released while waiting, so the chassis can be destroyed in between polls.
+        std::unique_lock<pros::Mutex> lock(dsr_mutex);
+        tr_pose pose = chassis.get_pose();
+        float turn = (tr_angle::from_degrees(pose.theta) - tr_angle::from_degrees(history[(polls + reading_latency_polls) % (reading_latency_polls + 1)].theta)).to_signed_degrees();
+        history[polls % (reading_latency_polls + 1)] = pose;
+        polls++;
+
+        // Passed once the robot crosses the line through the point perpendicular to the approach, like pid_wait_until_point.
+        passed = passed || (pose.x - trigger.point.x) * approach_x + (pose.y - trigger.point.y) * approach_y >= 0;
+
+        bool square = fabsf(tr_sensor::relative_square(pose.theta)) <= waypoint_max_heading_error;
+        bool steady = polls > 1 && fabsf(turn) * 1000.0f / waypoint_poll_period <= waypoint_max_turn_rate;
+        if (passed && polls > reading_latency_polls && square && steady)
+        {
+            slot.state = DSR_RUNNING;
+
+            // The oldest pose in the history is the one the readings were taken at.
+            const tr_pose& reference = history[polls % (reading_latency_polls + 1)];
+            result = apply_dsr(slot.use_quadrant ? slot.quadrant : field_quadrant(), true, &reference);
+            if (result.applied) return result;
+
+            slot.state = DSR_WAITING;
+        }
+        lock.unlock();
+
+        pros::c::task_delay_until(&last, waypoint_poll_period);
     }
 
-    if (heading > 45 && heading <= 135)
+    // The last rejected attempt is kept for its readings, but the reset is reported as missed.
+    result.applied = false;
+    result.rejection = REJECT_WAYPOINT_MISSED;
+    return result;
+}
+
+tr_dsr_result tr_chassis::evaluate_dsr(tr_quadrant quadrant, float heading, tr_vector3 odom)
+{
+    tr_conf_pair<tr_vector3> coords = calculate_position(quadrant, heading);
+
+    tr_dsr_result result = {};
+    result.applied = false;
+    result.rejection = REJECT_NONE;
+    result.confidence = coords.get_confidence();
+    result.sensors_used = active_sensors;
+    result.correction = tr_vector2(coords.get_value().x - odom.x, coords.get_value().y - odom.y);
+
+    // Each assigned beam is checked against the reading odometry predicts for it, traced from the odometry pose with the cone model.
+    const int flags[4] = {NORTH, EAST, SOUTH, WEST};
+    tr_sensor* beam_sensors[4] = {north, east, south, west};
+    float normal_heading = coords.get_value().z;
+    bool invalid_beam = false;
+    for (int i = 0; i < 4; i++)
     {
-        return tr_quadrant::NEG_POS;
+        if ((flags[i] == x_beam || flags[i] == y_beam) && beam_readings[i] != err_reading_value)
+        {
+            float facing = normal_heading + 90.0f * tr_sensor_mounts[i];
+            tr_vector2 origin = beam_sensors[i]->get_origin(tr_vector2(odom.x, odom.y), facing);
+            result.residuals[i] = beam_readings[i] - beam_model.expected_range(origin, facing + beam_sensors[i]->get_yaw());
+        }
+        else result.residuals[i] = 0;
+
+        if (flags[i] == x_beam) result.variance.x = beam_quality[i].variance;
+        if (flags[i] == y_beam) result.variance.y = beam_quality[i].variance;
+        if (flags[i] == x_beam || flags[i] == y_beam) invalid_beam = invalid_beam || !beam_quality[i].is_valid();
     }
 
-    if (heading > 135 && heading <= 225)
+    if (beam_error) result.rejection = REJECT_NO_READING;
+    else if (invalid_beam) result.rejection = REJECT_INVALID_BEAM;
+    else if (!can_position_exist(coords.get_value())) result.rejection = REJECT_IMPOSSIBLE_POSITION;
+
+    return result;
+}
+
+tr_dsr_result tr_chassis::apply_dsr(tr_quadrant quadrant, bool use_policy, const tr_pose* reference)
+{
+    TR_NO_ALLOC("apply_dsr");
+    // The drivebase pose stays in double precision, only the correction is calculated in float.
+    tr_pose pose = chassis.get_pose();
+    tr_pose odom = reference != nullptr ? *reference : pose;
+    tr_dsr_result result = evaluate_dsr(quadrant, odom.theta, odom.to_vector());
+    tr_gps* reset_gps = gps;
+    tr_gps_outcome gps_outcome = reset_gps != nullptr ? fuse_gps(reset_gps, result, odom) : GPS_UNUSED;
+
+    if (result.rejection == REJECT_NONE && use_policy) result.rejection = trust_policy.evaluate(result);
+    if (result.rejection != REJECT_NONE) return result;
+    if (reset_gps != nullptr) reset_gps->record(gps_outcome);
+
+    last_reset_from = pose.to_vector();
+    pose.x += result.correction.x;
+    pose.y += result.correction.y;
+    chassis.set_pose(pose);
+    last_reset_to = pose.to_vector();
+    last_reset_sensors = result.sensors_used;
+    for (int i = 0; i < 4; i++) last_reset_beams[i] = beam_lengths[i];
+    reset_count++;
+    correction_total.x += result.correction.x;
+    correction_total.y += result.correction.y;
+    record_interval(odom, result, use_policy);
+
+    result.applied = true;
+    return result;
+}
+
+tr_gps_outcome tr_chassis::fuse_gps(tr_gps* fix_gps, tr_dsr_result& result, const tr_pose& odom)
+{
+    tr_gps_fix fix;
+    if (!fix_gps->measure(odom.theta, fix)) return GPS_UNUSED;
+    tr_vector2 correction(fix.position.x - odom.x, fix.position.y - odom.y);
+
+    // Mid-field the beams are out of range or too steep, which is where the GPS sees the most of the field code. Any other rejection, such as an
+    // impossible position, means something is wrong with the robot and stands.
+    bool beams_unusable = result.rejection == REJECT_NO_READING || result.rejection == REJECT_INVALID_BEAM;
+    if (result.rejection != REJECT_NONE && !beams_unusable) return GPS_UNUSED;
+    if (beams_unusable || result.confidence < trust_policy.get_min_confidence())
     {
-        return tr_quadrant::NEG_NEG;
+        result = {};
+        result.rejection = REJECT_NONE;
+        result.confidence = fix.confidence;
+        result.sensors_used = GPS_SENSOR;
+        result.correction = correction;
+        result.variance = tr_vector2(fix.variance, fix.variance);
+        return GPS_ALONE;
     }
 
-    if (heading > 225 && heading <= 315)
+    float dx = correction.x - result.correction.x;
+    float dy = correction.y - result.correction.y;
+    if (dx * dx / (fix.variance + result.variance.x) > tr_gps::gate_chi_square || dy * dy / (fix.variance + result.variance.y) > tr_gps::gate_chi_square)
     {
-        return tr_quadrant::POS_NEG;
+        return GPS_GATED;
     }
 
-    return tr_quadrant::NEG_NEG;
+    float weight_x = result.variance.x / (result.variance.x + fix.variance);
+    float weight_y = result.variance.y / (result.variance.y + fix.variance);
+    result.correction.x += weight_x * dx;
+    result.correction.y += weight_y * dy;
+    result.variance.x *= 1.0f - weight_x;
+    result.variance.y *= 1.0f - weight_y;
+    result.sensors_used |= GPS_SENSOR;
+    return GPS_FUSED;
 }
 
-tr_quadrant tr_chassis::get_quadrant()
+bool tr_chassis::start_wall_following()
 {
-    tr_vector3 cur_pose = chassis->getPose();
+    if (wall_follower.get_state() != FOLLOWER_RUNNING) follow_primed = false;
+    return wall_follower.start();
+}
 
-    if (cur_pose.x > 0 && cur_pose.y > 0)
-    {
-        return tr_quadrant::POS_POS;
-    }
+void tr_chassis::stop_wall_following()
+{
+    wall_follower.stop();
+}
+
+const tr_wall_follower& tr_chassis::get_wall_follower()
+{
+    return wall_follower;
+}
+
+tr_follow_outcome tr_chassis::follow_wall(void* param)
+{
+    tr_chassis* self = static_cast<tr_chassis*>(param);
+    tr_pose pose = self->chassis.get_pose();
+
+    // Readings trail odometry by about a period, so they are compared against the pose of the previous step.
+    tr_pose reference = self->follow_reference;
+    bool primed = self->follow_primed;
+    self->follow_reference = pose;
+    self->follow_primed = true;
 
-    if (cur_pose.x > 0 && cur_pose.y < 0)
+    if (!primed || !self->chassis.is_driving()) return FOLLOW_IDLE;
+
+    float turn = (tr_angle::from_degrees(pose.theta) - tr_angle::from_degrees(reference.theta)).to_signed_degrees();
+    bool parallel = fabsf(tr_sensor::relative_square(reference.theta)) <= follow_max_heading_error;
+    bool steady = fabsf(turn) * 1000.0f / tr_wall_follower::period <= follow_max_turn_rate;
+    if (!parallel || !steady) return FOLLOW_IDLE;
+
+    return self->apply_lateral_correction(reference);
+}
+
+tr_follow_outcome tr_chassis::apply_lateral_correction(const tr_pose& reference)
+{
+    TR_NO_ALLOC("apply_lateral_correction");
+    std::lock_guard<pros::Mutex> lock(dsr_mutex);
+    tr_dsr_result result = evaluate_dsr(field_quadrant(), reference.theta, reference.to_vector());
+    if (result.rejection == REJECT_IMPOSSIBLE_POSITION) return FOLLOW_REJECTED;
+
+    // Driving along Y when the heading is nearest 0 or 180 degrees, then the side beams measure X.
+    float heading_rad = tr_quantity<tr_degree, float>(reference.theta).to<tr_radian>().get();
+    bool lateral_x = fabsf(sinf(heading_rad)) < 0.70710678f;
+    int lateral_flag = lateral_x ? x_beam : y_beam;
+
+    // The beam along the direction of travel is left to odometry and is usually out of range, so only the side beam has to be valid, and its own
+    // confidence and axis are what the trust policy checks.
+    const int flags[4] = {NORTH, EAST, SOUTH, WEST};
+    for (int i = 0; i < 4; i++)
     {
-        return tr_quadrant::NEG_POS;
+        if (flags[i] == lateral_flag && !beam_quality[i].is_valid()) return FOLLOW_REJECTED;
+        if (flags[i] == lateral_flag) result.confidence = beam_quality[i].confidence;
+        else result.residuals[i] = 0;
     }
-
-    if (cur_pose.x < 0 && cur_pose.y < 0)
+    if (lateral_x)
     {
-        return tr_quadrant::NEG_NEG;
+        result.correction.y = 0;
+        result.variance.y = 0;
     }
-
-    if (cur_pose.x > 0 && cur_pose.y < 0)
+    else
     {
-        return tr_quadrant::POS_NEG;
+        result.correction.x = 0;
+        result.variance.x = 0;
     }
+    if (trust_policy.evaluate(result) != REJECT_NONE) return FOLLOW_REJECTED;
+
+    tr_pose pose = chassis.get_pose();
+    pose.x += options.follow_gain * result.correction.x;
+    pose.y += options.follow_gain * result.correction.y;
+    chassis.set_pose(pose);
+
+    follow_correction.x += options.follow_gain * result.correction.x;
+    follow_correction.y += options.follow_gain * result.correction.y;
+    correction_total.x += options.follow_gain * result.correction.x;
+    correction_total.y += options.follow_gain * result.correction.y;
+    return FOLLOW_APPLIED;
+}
 
-    return tr_quadrant::POS_POS;
+tr_dsr_result tr_chassis::perform_dsr_init(tr_quadrant quadrant, float heading)
+{
+    std::lock_guard<pros::Mutex> lock(dsr_mutex);
+    const tr_mirror& mirror = chassis.get_mirror();
+    float field_heading = tr_angle::from_degrees(mirror.heading(heading)).to_degrees();
+    imu->set_heading(field_heading);
+    chassis.set_pose({0, 0, field_heading});
+    event_detector.clear_history();
+
+    // The pose jumped, so the interval since the last reset is dropped even if this one is rejected.
+    anchor_valid = false;
+    return apply_dsr(mirror.quadrant(quadrant), false);
 }
-//n_p, n_p
-tr_conf_pair<tr_vector3> tr_chassis::get_position_calculation(tr_quadrant quadrant)
+
+void tr_chassis::set_gps(tr_gps* new_gps)
 {
-    return get_position_calculation(quadrant, chassis->getPose().z);
+    gps = new_gps;
 }
 
-tr_conf_pair<tr_vector3> tr_chassis::get_position_calculation(tr_quadrant quadrant, float heading)
+void tr_chassis::set_mirror(const tr_mirror& mirror)
 {
-    float normal_heading = quadrant_recursive(heading);
-    tr_quadrant theta_quad = sensor_relevancy(normal_heading);
+    chassis.set_mirror(mirror);
+}
 
-    tr_conf_pair<float> n_dist = north->distance(normal_heading);
-    tr_conf_pair<float> e_dist = east->distance(normal_heading);
-    tr_conf_pair<float> s_dist = south->distance(normal_heading);
-    tr_conf_pair<float> w_dist = west->distance(normal_heading);
+bool tr_chassis::sync_mirror()
+{
+    return chassis.sync_mirror();
+}
 
-    tr_conf_pair<tr_vector3> ret = tr_conf_pair<tr_vector3>();
+const tr_mirror& tr_chassis::get_mirror()
+{
+    return chassis.get_mirror();
+}
 
-    float x = 0;
-    float y = 0;
+bool tr_chassis::start_event_detection()
+{
+    if (event_detector.get_state() != DETECTOR_RUNNING) event_primed = false;
+    return event_detector.start();
+}
 
-    if (quadrant == POS_POS)
-    {
-        switch (theta_quad)
-        {
-            case POS_POS:
-            {
-                ret.set_confidence(conf_avg(e_dist, n_dist));
-                x = wall_coord - e_dist.get_value();
-                y = wall_coord - n_dist.get_value();
-                set_active_sensors(NORTH | EAST);
-                break;
-            }
-
-            case NEG_POS:
-            {
-                ret.set_confidence(conf_avg(n_dist, w_dist));
-                x = wall_coord - n_dist.get_value();
-                y = wall_coord - w_dist.get_value();
-                set_active_sensors(NORTH | WEST);
-                break;
-            }
-
-            case NEG_NEG:
-            {
-                ret.set_confidence(conf_avg(w_dist, s_dist));
-                x = wall_coord - w_dist.get_value();
-                y = wall_coord - s_dist.get_value();
-                set_active_sensors(WEST | SOUTH);
-                break;
-            }
-
-            case POS_NEG:
-            {
-                ret.set_confidence(conf_avg(s_dist, e_dist));
-                x = wall_coord - s_dist.get_value();
-                y = wall_coord - e_dist.get_value();
-                set_active_sensors(SOUTH | EAST);
-                break;
-            }
-        }
-    } else if (quadrant == NEG_POS)
-    {
-        switch (theta_quad)
-        {
-            case POS_POS:
-            {
-                ret.set_confidence(conf_avg(n_dist, w_dist));
-                x = -wall_coord + w_dist.get_value();
-                y = wall_coord - n_dist.get_value();
-                set_active_sensors(WEST | NORTH);
-                break;
-            }
-
-            case NEG_POS:
-            {
-                ret.set_confidence(conf_avg(s_dist, w_dist));
-                x = -wall_coord + s_dist.get_value();
-                y = wall_coord - w_dist.get_value();
-                set_active_sensors(SOUTH | WEST);
-                break;
-            }
-
-            case NEG_NEG:
-            {
-                ret.set_confidence(conf_avg(e_dist, s_dist));
-                x = -wall_coord + e_dist.get_value();
-                y = wall_coord - s_dist.get_value();
-                set_active_sensors(WEST | SOUTH);
-                break;
-            }
-
-            case POS_NEG:
-            {
-                ret.set_confidence(conf_avg(e_dist, n_dist));
-                x = -wall_coord + n_dist.get_value();
-                y = wall_coord - e_dist.get_value();
-                set_active_sensors(NORTH | EAST);
-                break;
-            }
-        }
-    } else if (quadrant == NEG_NEG)
-    {
-        switch (theta_quad)
-        {
-            case POS_POS:
-            {
-                ret.set_confidence(conf_avg(w_dist, s_dist));
-                x = -wall_coord + w_dist.get_value();
-                y = -wall_coord + s_dist.get_value();
-                set_active_sensors(WEST | SOUTH);
-                break;
-            }
-
-            case NEG_POS:
-            {
-                ret.set_confidence(conf_avg(s_dist, e_dist));
-                x = -wall_coord + s_dist.get_value();
-                y = -wall_coord + e_dist.get_value();
-                set_active_sensors(SOUTH | EAST);
-                break;
-            }
-
-            case NEG_NEG:
-            {
-                ret.set_confidence(conf_avg(e_dist, n_dist));
-                x = -wall_coord + e_dist.get_value();
-                y = -wall_coord + n_dist.get_value();
-                set_active_sensors(EAST | NORTH);
-                break;
-            }
-
-            case POS_NEG:
-            {
-                ret.set_confidence(conf_avg(n_dist, w_dist));
-                x = -wall_coord + n_dist.get_value();
-                y = -wall_coord + w_dist.get_value();
-                set_active_sensors(NORTH | WEST);
-                break;
-            }
-        }
-    } else if (quadrant == POS_NEG)
-    {
-        switch (theta_quad)
-        {
-            case POS_POS:
-            {
-                ret.set_confidence(conf_avg(e_dist, s_dist));
-                x = wall_coord - e_dist.get_value();
-                y = -wall_coord + s_dist.get_value();
-                set_active_sensors(EAST | SOUTH);
-                break;
-            }
-
-            case NEG_POS:
-            {
-                ret.set_confidence(conf_avg(n_dist, e_dist));
-                x = wall_coord - n_dist.get_value();
-                y = -wall_coord + e_dist.get_value();
-                set_active_sensors(NORTH | EAST);
-                break;
-            }
-
-            case NEG_NEG:
-            {
-                ret.set_confidence(conf_avg(w_dist, n_dist));
-                x = wall_coord - w_dist.get_value();
-                y = -wall_coord + n_dist.get_value();
-                set_active_sensors(WEST | NORTH);
-                break;
-            }
-
-            case POS_NEG:
-            {
-                ret.set_confidence(conf_avg(s_dist, w_dist));
-                x = wall_coord - s_dist.get_value();
-                y = -wall_coord + w_dist.get_value();
-                set_active_sensors(SOUTH | WEST);
-                break;
-            }
-        }
-    } else
+void tr_chassis::stop_event_detection()
+{
+    event_detector.stop();
+}
+
+tr_event_detector& tr_chassis::get_event_detector()
+{
+    return event_detector;
+}
+
+void tr_chassis::sample_events(void* param, tr_event_sample& sample)
+{
+    tr_chassis* self = static_cast<tr_chassis*>(param);
+    if (self->imu != nullptr)
     {
-        x = 0;
-        y = 0;
-        ret.set_confidence(0);
+        pros::imu_accel_s_t accel = self->imu->get_accel();
+        sample.accel = sqrtf(accel.x * accel.x + accel.y * accel.y);
     }
+    if (!sample.has_innovation) return;
+    std::lock_guard<pros::Mutex> lock(self->dsr_mutex);
+
+    // Readings trail odometry by about a sensor update, so they are compared against the pose and corrections of the previous innovation sample.
+    tr_pose pose = self->chassis.get_pose();
+    tr_pose reference = self->event_reference;
+    tr_vector2 reference_correction = self->event_reference_correction;
+    bool primed = self->event_primed;
+    self->event_reference = pose;
+    self->event_reference_correction = self->correction_total;
+    self->event_primed = true;
+
+    sample.has_innovation = primed;
+    if (!primed) return;
+
+    tr_dsr_result result = self->evaluate_dsr(self->field_quadrant(), reference.theta, reference.to_vector());
+    sample.reading_lost = result.rejection == REJECT_NO_READING;
+    sample.valid = result.rejection == REJECT_NONE && result.confidence >= self->trust_policy.get_min_confidence();
+    sample.innovation = tr_vector2(result.correction.x + reference_correction.x, result.correction.y + reference_correction.y);
+    sample.variance = result.variance;
+}
 
-    ret.set_value(tr_vector3(x, y, normal_heading));
+void tr_chassis::record_interval(const tr_pose& odom, const tr_dsr_result& result, bool add)
+{
+    tr_pose pose = chassis.get_pose();
+    float rotation = imu != nullptr ? imu->get_rotation() : pose.theta;
 
-    if (!can_position_exist(tr_vector3(x, y, normal_heading))) ret.set_confidence(0);
+    if (add && anchor_valid)
+    {
+        // Corrections the wall follower fused since the anchor are part of the error odometry made, not of its own displacement.
+        tr_vector2 displacement(odom.x - estimator_anchor.x - follow_correction.x, odom.y - estimator_anchor.y - follow_correction.y);
+        tr_vector2 correction(result.correction.x + follow_correction.x, result.correction.y + follow_correction.y);
+        float turned = rotation - anchor_rotation;
+        odom_estimator.add(displacement, turned, estimator_anchor.z + turned / 2.0f, correction, result.variance);
+    }
 
-    return ret;
+    estimator_anchor = pose.to_vector();
+    anchor_rotation = rotation;
+    anchor_valid = true;
+    follow_correction = tr_vector2();
 }
 
-float tr_chassis::conf_avg(tr_distance one, tr_distance two)
+const tr_odom_estimator& tr_chassis::get_odometry_estimator()
 {
-    return (one.get_confidence() + two.get_confidence()) / 2.0f;
+    return odom_estimator;
 }
 
-void tr_chassis::perform_dsr()
+float tr_chassis::apply_odometry_scale(const std::vector<ez::tracking_wheel*>& trackers, float max_step)
 {
-    return perform_dsr_quad(get_quadrant());
+    std::lock_guard<pros::Mutex> lock(dsr_mutex);
+    // Odometry keeps integrating while the pose is held, so any motion during the settle time would be thrown away.
+    if (!odom_estimator.is_scale_significant() || !chassis.is_stopped()) return 1.0f;
+
+    tr_pose pose = chassis.get_pose();
+    float factor = odom_estimator.take_scale_step(max_step);
+    if (trackers.empty()) chassis.scale_distance(factor);
+    for (ez::tracking_wheel* tracker : trackers)
+    {
+        tracker->wheel_diameter_set(tracker->wheel_diameter_get() * factor);
+    }
+
+    pros::delay(scale_settle_time);
+    chassis.set_pose(pose);
+    return factor;
 }
 
-void tr_chassis::perform_dsr_quad(tr_quadrant quadrant)
+tr_beam_quality tr_chassis::get_beam_quality(int beam) const
 {
-    tr_vector3 pose = chassis->getPose();
-    tr_conf_pair<tr_vector3> coords = get_position_calculation(quadrant);
+    std::lock_guard<pros::Mutex> lock(dsr_mutex);
+    return beam_quality[beam & 3];
+}
 
-    pose.x = coords.get_value().x;
-    pose.y = coords.get_value().y;
-    chassis->setPose(pose);
+const tr_beam_model& tr_chassis::get_beam_model() const
+{
+    return beam_model;
 }
 
-void tr_chassis::perform_dsr_init(tr_quadrant quadrant, float heading)
+const tr_trust_policy& tr_chassis::get_trust_policy()
 {
-    tr_vector3 pose = chassis->getPose();
-    imu->set_heading(heading);
-    chassis->setPose(tr_vector3(0,0,heading));
-    tr_conf_pair<tr_vector3> coords = get_position_calculation(quadrant, heading);
+    return trust_policy;
+}
 
-    pose.x = coords.get_value().x;
-    pose.y = coords.get_value().y;
-    chassis->setPose(pose);
+int tr_chassis::load_calibration(const char* path)
+{
+    int loaded = 0;
+    tr_sensor* sensors[4] = {north, east, south, west};
+    for (tr_sensor* sensor : sensors)
+    {
+        if (sensor->load_calibration(path)) loaded++;
+    }
+    return loaded;
+}
+
+int tr_chassis::load_corrections(const char* format)
+{
+    int loaded = 0;
+    char path[64];
+    tr_sensor* sensors[4] = {north, east, south, west};
+    for (tr_sensor* sensor : sensors)
+    {
+        snprintf(path, sizeof(path), format, sensor->get_port());
+        if (sensor->load_correction(path)) loaded++;
+    }
+    return loaded;
 }
 
 void tr_chassis::init_display()
@@ -421,6 +705,7 @@ void tr_chassis::init_display()
 
 void tr_chassis::update_display(tr_chassis* chassis)
 {
+    TR_NO_ALLOC("update_display");
     bool north = chassis->is_sensor_used(NORTH);
     bool east = chassis->is_sensor_used(EAST);
     bool south = chassis->is_sensor_used(SOUTH);
@@ -442,12 +727,12 @@ void tr_chassis::update_display(tr_chassis* chassis)
     bool use_pose = true;
     chassis->perform_dsr();
     tr_conf_pair<tr_vector3> position = chassis->get_position_calculation(tr_quadrant::NEG_POS);
-    std::string quads = chassis->get_quadrant_string(chassis->get_quadrant());
-    std::string squad = chassis->get_quadrant_string(chassis->sensor_relevancy());
+    const char* quads = chassis->get_quadrant_string(chassis->get_quadrant());
+    const char* squad = chassis->get_quadrant_string(chassis->sensor_relevancy());
 
-    tr_vector3 pose_lem = chassis->chassis->getPose();
+    tr_vector3 pose_lem = chassis->chassis.get_pose().to_vector();
 
-    pros::lcd::print(0, "SQ: %s, %s", quads.c_str(), squad.c_str());
+    pros::lcd::print(0, "SQ: %s, %s", quads, squad);
     pros::lcd::print(1, "SU: N %i, E %i, S %i, W %i", north, east, south, west);
     pros::lcd::print(2, "SR: N %.2f, E %.2f, S %.2f, W %.2f", dis_n, dis_e, dis_s, dis_w);
     pros::lcd::print(3, "SC: N %.2f, E %.2f, S %.2f, W %.2f", confidence_n, confidence_e, confidence_s, confidence_w);
@@ -461,39 +746,26 @@ void tr_chassis::shutdown_display()
     //pros::lcd::shutdown();
 }
 
-void tr_chassis::start_location_recording(std::string date, std::string time)
+void tr_chassis::record_location(void* param, tr_record& record)
 {
-    if (location_task != nullptr) location_task->suspend();
-    delete location_task;
-    location_task = new pros::Task([this, time, date]() -> void
-    {
-        std::ofstream output("odom_data.txt", std::ios::app);
-        std::ofstream output2("dist_data.txt", std::ios::app);
-
-        double mil = pros::millis();
-
-        output << "\n" << "Timestamp: " << date << " " << time << " " << mil << "\n";
-        output2 << "\n" << "Timestamp: " << date << " " << time << " " << mil << "\n";
+    tr_chassis* self = static_cast<tr_chassis*>(param);
+    record.odom = self->chassis.get_pose().to_vector();
+    record.dsr = self->get_position_calculation(self->field_quadrant()).get_value();
+}
 
-        while (true)
-        {
-            tr_vector3 pose = chassis->getPose();
-            tr_vector3 pose1 = get_position_calculation(get_quadrant()).get_value();
-            output << pose.x << ", " << pose.y << ", " << pose.z << "\n";
-            output2 << pose1.x << ", " << pose1.y << ", " << pose1.z << "\n";
-            pros::Task::delay(50);
-        }
-        output.close();
-    });
+void tr_chassis::start_location_recording(const char* date, const char* time)
+{
+    location_recorder.start(date, time);
 }
 
 void tr_chassis::stop_location_recording()
 {
-    if (location_task != nullptr)
-    {
-        location_task->suspend();
-        delete location_task;
-    }
+    location_recorder.stop();
+}
+
+const tr_recorder& tr_chassis::get_location_recorder()
+{
+    return location_recorder;
 }
 
 bool tr_chassis::is_sensor_used(int r_sensor)
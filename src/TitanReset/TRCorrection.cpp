@@ -0,0 +1,209 @@
+#include "../../include/TitanReset/TRCorrection.hpp"
+#include "../../include/TitanReset/TRUnits.hpp"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char correction_magic[4] = {'T', 'R', 'L', 'C'};
+
+/**
+ * Tenths of a millimetre per stored correction unit.
+ */
+static constexpr float correction_scale_mm = 0.1f;
+
+typedef tr_quantity<tr_millimetre, float> tr_correction_mm;
+
+tr_correction_table::tr_correction_table() :
+            table(),
+            range_bins(0),
+            angle_bins(0),
+            range_min(0),
+            range_inv_step(0),
+            angle_min(0),
+            angle_inv_step(0)
+{}
+
+bool tr_correction_table::is_loaded() const
+{
+    return range_bins > 0;
+}
+
+/**
+ * @brief Splits a coordinate into a node index and the fraction towards the next node, clamped to the table.
+ */
+static inline int correction_cell(float position, int bins, float& fraction)
+{
+    if (position <= 0)
+    {
+        fraction = 0;
+        return 0;
+    }
+    if (position >= bins - 1)
+    {
+        fraction = 1;
+        return bins - 2;
+    }
+    int index = (int)position;
+    fraction = position - index;
+    return index;
+}
+
+float tr_correction_table::lookup(float reading, float incidence) const
+{
+    if (range_bins == 0) return 0;
+
+    float range_fraction;
+    float angle_fraction;
+    int r = correction_cell((reading - range_min) * range_inv_step, range_bins, range_fraction);
+    int a = correction_cell((fabsf(incidence) - angle_min) * angle_inv_step, angle_bins, angle_fraction);
+
+    const float* row = &table[r * angle_bins + a];
+    float near_range = row[0] + (row[1] - row[0]) * angle_fraction;
+    float far_range = row[angle_bins] + (row[angle_bins + 1] - row[angle_bins]) * angle_fraction;
+    return near_range + (far_range - near_range) * range_fraction;
+}
+
+bool tr_correction_table::load(const char* path)
+{
+    range_bins = 0;
+
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr) return false;
+
+    tr_correction_header header;
+    int16_t raw[max_range_bins * max_angle_bins];
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 &&
+              memcmp(header.magic, correction_magic, sizeof(correction_magic)) == 0 &&
+              header.version == version &&
+              header.range_bins >= 2 && header.range_bins <= max_range_bins &&
+              header.angle_bins >= 2 && header.angle_bins <= max_angle_bins &&
+              header.range_step_mm > 0 && header.angle_step_deg > 0;
+
+    int count = ok ? header.range_bins * header.angle_bins : 0;
+    ok = ok && fread(raw, sizeof(int16_t), count, file) == (size_t)count;
+    fclose(file);
+    if (!ok) return false;
+
+    // Everything is converted to inches here so the lookup never converts.
+    for (int i = 0; i < count; i++)
+    {
+        table[i] = tr_correction_mm(raw[i] * correction_scale_mm).to<tr_inch>().get();
+    }
+    range_min = tr_correction_mm(header.range_min_mm).to<tr_inch>().get();
+    range_inv_step = 1.0f / tr_correction_mm(header.range_step_mm).to<tr_inch>().get();
+    angle_min = header.angle_min_deg;
+    angle_inv_step = 1.0f / header.angle_step_deg;
+    angle_bins = header.angle_bins;
+    range_bins = header.range_bins;
+    return true;
+}
+
+bool tr_correction_table::build(const char* path, const tr_correction_sample* samples, int count, int range_bins, float range_min_mm, float range_step_mm, int angle_bins, float angle_step_deg)
+{
+    if (range_bins < 2 || range_bins > max_range_bins || angle_bins < 2 || angle_bins > max_angle_bins) return false;
+    if (range_step_mm <= 0 || angle_step_deg <= 0) return false;
+
+    // Each sample is splatted onto its four surrounding nodes with bilinear weights.
+    double sum[max_range_bins][max_angle_bins] = {};
+    double weight[max_range_bins][max_angle_bins] = {};
+    for (int i = 0; i < count; i++)
+    {
+        float range_fraction;
+        float angle_fraction;
+        int r = correction_cell((samples[i].raw_mm - range_min_mm) / range_step_mm, range_bins, range_fraction);
+        int a = correction_cell(fabsf(samples[i].incidence_deg) / angle_step_deg, angle_bins, angle_fraction);
+        double error = samples[i].true_mm - samples[i].raw_mm;
+
+        double weights[2][2] = {
+            {(1 - range_fraction) * (1 - angle_fraction), (1 - range_fraction) * angle_fraction},
+            {range_fraction * (1 - angle_fraction), range_fraction * angle_fraction},
+        };
+        for (int dr = 0; dr < 2; dr++)
+        {
+            for (int da = 0; da < 2; da++)
+            {
+                sum[r + dr][a + da] += weights[dr][da] * error;
+                weight[r + dr][a + da] += weights[dr][da];
+            }
+        }
+    }
+
+    const double min_weight = 0.25;
+    float nodes[max_range_bins][max_angle_bins];
+    bool filled[max_range_bins][max_angle_bins];
+    bool any = false;
+    for (int r = 0; r < range_bins; r++)
+    {
+        for (int a = 0; a < angle_bins; a++)
+        {
+            filled[r][a] = weight[r][a] >= min_weight;
+            nodes[r][a] = filled[r][a] ? sum[r][a] / weight[r][a] : 0;
+            any = any || filled[r][a];
+        }
+    }
+    if (!any) return false;
+
+    // Empty nodes copy the nearest filled node at the same incidence, then columns without any samples copy the nearest column.
+    bool column_filled[max_angle_bins] = {};
+    for (int a = 0; a < angle_bins; a++)
+    {
+        for (int r = 0; r < range_bins; r++)
+        {
+            if (filled[r][a]) continue;
+            for (int distance = 1; distance < range_bins; distance++)
+            {
+                if (r - distance >= 0 && filled[r - distance][a])
+                {
+                    nodes[r][a] = nodes[r - distance][a];
+                    break;
+                }
+                if (r + distance < range_bins && filled[r + distance][a])
+                {
+                    nodes[r][a] = nodes[r + distance][a];
+                    break;
+                }
+            }
+        }
+        for (int r = 0; r < range_bins; r++) column_filled[a] = column_filled[a] || filled[r][a];
+    }
+    for (int a = 0; a < angle_bins; a++)
+    {
+        if (column_filled[a]) continue;
+        for (int distance = 1; distance < angle_bins; distance++)
+        {
+            int source = a - distance >= 0 && column_filled[a - distance] ? a - distance :
+                         a + distance < angle_bins && column_filled[a + distance] ? a + distance : -1;
+            if (source < 0) continue;
+            for (int r = 0; r < range_bins; r++) nodes[r][a] = nodes[r][source];
+            break;
+        }
+    }
+
+    tr_correction_header header = {};
+    memcpy(header.magic, correction_magic, sizeof(correction_magic));
+    header.version = version;
+    header.range_bins = range_bins;
+    header.angle_bins = angle_bins;
+    header.range_min_mm = range_min_mm;
+    header.range_step_mm = range_step_mm;
+    header.angle_min_deg = 0;
+    header.angle_step_deg = angle_step_deg;
+
+    int16_t raw[max_range_bins * max_angle_bins];
+    for (int r = 0; r < range_bins; r++)
+    {
+        for (int a = 0; a < angle_bins; a++)
+        {
+            float quantized = roundf(nodes[r][a] / correction_scale_mm);
+            if (quantized > INT16_MAX) quantized = INT16_MAX;
+            if (quantized < INT16_MIN) quantized = INT16_MIN;
+            raw[r * angle_bins + a] = (int16_t)quantized;
+        }
+    }
+
+    FILE* file = fopen(path, "wb");
+    if (file == nullptr) return false;
+    int total = range_bins * angle_bins;
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(raw, sizeof(int16_t), total, file) == (size_t)total;
+    return fclose(file) == 0 && ok;
+}
@@ -0,0 +1,233 @@
+#include "../../include/TitanReset/TRDrivebase.hpp"
+#include "../../include/EZ-Template/drive/drive.hpp"
+#include "../../include/okapi/api/chassis/controller/odomChassisController.hpp"
+#include "../../include/okapi/api/odometry/odometry.hpp"
+#include <stdlib.h>
+
+/**
+ * Fastest drive motor velocity in RPM the drivebase counts as stopped at.
+ */
+static constexpr int stopped_velocity = 2;
+
+/**
+ * @brief Converts an okapi state to a TitanReset pose.
+ *
+ * CARTESIAN matches the TitanReset frame. FRAME_TRANSFORMATION has +X forward and +Y right, so the axes are swapped. Heading is clockwise in both.
+ */
+static tr_pose tr_from_okapi(const okapi::OdomState& state, okapi::StateMode mode)
+{
+    double x = state.x.convert(okapi::inch);
+    double y = state.y.convert(okapi::inch);
+    double theta = state.theta.convert(okapi::degree);
+
+    if (mode == okapi::StateMode::FRAME_TRANSFORMATION) return {y, x, theta};
+    return {x, y, theta};
+}
+
+/**
+ * @brief Converts a TitanReset pose to an okapi state in the given mode.
+ */
+static okapi::OdomState tr_to_okapi(tr_pose pose, okapi::StateMode mode)
+{
+    if (mode == okapi::StateMode::FRAME_TRANSFORMATION) return {pose.y * okapi::inch, pose.x * okapi::inch, pose.theta * okapi::degree};
+    return {pose.x * okapi::inch, pose.y * okapi::inch, pose.theta * okapi::degree};
+}
+
+tr_pose tr_ez_drivebase::get_pose() const
+{
+    ez::pose current = drive->odom_pose_get();
+    return {current.x, current.y, current.theta};
+}
+
+void tr_ez_drivebase::set_pose(tr_pose pose) const
+{
+    drive->odom_pose_set(ez::pose{pose.x, pose.y, pose.theta});
+}
+
+tr_mirror tr_ez_drivebase::get_mirror() const
+{
+    return tr_mirror(drive->odom_x_direction_get(), drive->odom_y_direction_get(), drive->odom_theta_direction_get());
+}
+
+void tr_ez_drivebase::set_rotation(double rotation) const
+{
+    // EZ-Template multiplies what the IMU reads by its scaler.
+    drive->imu.set_rotation(rotation / drive->drive_imu_scaler_get());
+}
+
+double tr_ez_drivebase::get_rotation() const
+{
+    return drive->imu.get_rotation() * drive->drive_imu_scaler_get();
+}
+
+uint8_t tr_ez_drivebase::get_imu_port() const
+{
+    return drive->imu.get_port();
+}
+
+bool tr_ez_drivebase::is_driving() const
+{
+    ez::e_mode mode = drive->drive_mode_get();
+    return mode == ez::DRIVE || mode == ez::POINT_TO_POINT;
+}
+
+bool tr_ez_drivebase::is_stopped() const
+{
+    // Turns, swings, pure pursuit and driver control all run outside of DISABLE or move the wheels.
+    if (drive->drive_mode_get() != ez::DISABLE) return false;
+    return abs(drive->drive_velocity_left()) <= stopped_velocity && abs(drive->drive_velocity_right()) <= stopped_velocity;
+}
+
+void tr_ez_drivebase::scale_distance(double factor) const
+{
+    // Ticks per inch grow with the ratio, so distances shrink with it.
+    drive->drive_ratio_set(drive->drive_ratio_get() / factor);
+}
+
+tr_pose tr_okapi_drivebase::get_pose() const
+{
+    // Chassis controllers always report their state in frame transformation mode.
+    return tr_from_okapi(controller->getState(), okapi::StateMode::FRAME_TRANSFORMATION);
+}
+
+void tr_okapi_drivebase::set_pose(tr_pose pose) const
+{
+    controller->setState(tr_to_okapi(pose, okapi::StateMode::FRAME_TRANSFORMATION));
+}
+
+tr_pose tr_okapi_odometry_drivebase::get_pose() const
+{
+    return tr_from_okapi(odometry->getState(mode), mode);
+}
+
+void tr_okapi_odometry_drivebase::set_pose(tr_pose pose) const
+{
+    odometry->setState(tr_to_okapi(pose, mode), mode);
+}
+
+tr_drivebase::tr_drivebase(ez::Drive* drive) : kind(DRIVEBASE_EZ), ez_base{drive}
+{}
+
+tr_drivebase::tr_drivebase(okapi::OdomChassisController* controller) : kind(DRIVEBASE_OKAPI), okapi_base{controller}
+{}
+
+tr_drivebase::tr_drivebase(okapi::Odometry* odometry) : kind(DRIVEBASE_OKAPI_ODOMETRY), okapi_odometry_base{odometry, okapi::StateMode::FRAME_TRANSFORMATION}
+{}
+
+tr_drivebase::tr_drivebase(okapi::Odometry* odometry, okapi::StateMode mode) : kind(DRIVEBASE_OKAPI_ODOMETRY), okapi_odometry_base{odometry, mode}
+{}
+
+tr_drivebase::tr_drivebase(tr_pose* pose) : kind(DRIVEBASE_STRUCT), struct_base{pose}
+{}
+
+tr_drivebase::tr_drivebase(tr_drivebase_generic* base) : kind(DRIVEBASE_VIRTUAL), virtual_base{base}
+{}
+
+/**
+ * @brief Maps a pose through a mirror, either way.
+ */
+static tr_pose tr_mirror_pose(const tr_mirror& mirror, tr_pose pose)
+{
+    return {mirror.x_sign * pose.x, mirror.y_sign * pose.y, mirror.heading(pose.theta)};
+}
+
+tr_pose tr_drivebase::get_pose() const
+{
+    tr_pose pose = {0, 0, 0};
+    switch (kind)
+    {
+        case DRIVEBASE_EZ:
+            pose = ez_base.get_pose();
+            break;
+        case DRIVEBASE_OKAPI:
+            pose = okapi_base.get_pose();
+            break;
+        case DRIVEBASE_OKAPI_ODOMETRY:
+            pose = okapi_odometry_base.get_pose();
+            break;
+        case DRIVEBASE_STRUCT:
+            pose = struct_base.get_pose();
+            break;
+        case DRIVEBASE_VIRTUAL:
+            pose = virtual_base.get_pose();
+            break;
+        case DRIVEBASE_CUSTOM:
+            pose = custom_base.get_pose();
+            break;
+    }
+    return tr_mirror_pose(mirror, pose);
+}
+
+void tr_drivebase::set_pose(tr_pose pose) const
+{
+    pose = tr_mirror_pose(mirror, pose);
+    switch (kind)
+    {
+        case DRIVEBASE_EZ:
+            ez_base.set_pose(pose);
+            break;
+        case DRIVEBASE_OKAPI:
+            okapi_base.set_pose(pose);
+            break;
+        case DRIVEBASE_OKAPI_ODOMETRY:
+            okapi_odometry_base.set_pose(pose);
+            break;
+        case DRIVEBASE_STRUCT:
+            struct_base.set_pose(pose);
+            break;
+        case DRIVEBASE_VIRTUAL:
+            virtual_base.set_pose(pose);
+            break;
+        case DRIVEBASE_CUSTOM:
+            custom_base.set_pose(pose);
+            break;
+    }
+}
+
+void tr_drivebase::set_mirror(const tr_mirror& new_mirror)
+{
+    mirror = new_mirror;
+}
+
+bool tr_drivebase::sync_mirror()
+{
+    if (kind != DRIVEBASE_EZ) return false;
+    mirror = ez_base.get_mirror();
+    return true;
+}
+
+bool tr_drivebase::is_driving() const
+{
+    return kind == DRIVEBASE_EZ && ez_base.is_driving();
+}
+
+bool tr_drivebase::is_stopped() const
+{
+    return kind == DRIVEBASE_EZ && ez_base.is_stopped();
+}
+
+bool tr_drivebase::set_rotation(double rotation) const
+{
+    if (kind != DRIVEBASE_EZ) return false;
+    ez_base.set_rotation(rotation);
+    return true;
+}
+
+bool tr_drivebase::get_rotation(double& rotation) const
+{
+    if (kind != DRIVEBASE_EZ) return false;
+    rotation = ez_base.get_rotation();
+    return true;
+}
+
+uint8_t tr_drivebase::get_imu_port() const
+{
+    return kind == DRIVEBASE_EZ ? ez_base.get_imu_port() : 0;
+}
+
+bool tr_drivebase::scale_distance(double factor) const
+{
+    if (kind != DRIVEBASE_EZ) return false;
+    ez_base.scale_distance(factor);
+    return true;
+}
@@ -0,0 +1,218 @@
+#include "../../include/TitanReset/TREvents.hpp"
+#include "../../include/TitanReset/TRAllocGuard.hpp"
+#include <math.h>
+
+/**
+ * Smallest variance in square inches an innovation is gated with, so perfect beams do not make the gate infinitely tight.
+ */
+static constexpr float min_innovation_variance = 0.01f;
+
+static float tr_distance_between(tr_vector2 a, tr_vector2 b)
+{
+    return sqrtf((a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y));
+}
+
+tr_event_detector::tr_event_detector(tr_event_source source, void* context) :
+            source(source),
+            context(context),
+            state(DETECTOR_IDLE),
+            stop_requested(false),
+            clear_requested(false),
+            history(),
+            history_count(0),
+            history_head(0),
+            diverged_samples(0),
+            lost_samples(0),
+            latched(false),
+            spike_time(0),
+            spike_accel(0),
+            spiked(false),
+            queue(),
+            queue_head(0),
+            queue_tail(0),
+            counts(),
+            dropped(0)
+{}
+
+bool tr_event_detector::start()
+{
+    if (state.load() == DETECTOR_RUNNING) return true;
+
+    stop_requested = false;
+    clear_requested = true;
+    state = DETECTOR_RUNNING;
+
+    pros::task_t task = pros::c::task_create(task_body, this, TASK_PRIORITY_DEFAULT, TASK_STACK_DEPTH_DEFAULT, "TR Event Detector");
+    if (task == nullptr)
+    {
+        state = DETECTOR_STOPPED;
+        return false;
+    }
+    return true;
+}
+
+bool tr_event_detector::stop(uint32_t timeout)
+{
+    if (state.load() != DETECTOR_RUNNING) return true;
+
+    stop_requested = true;
+    uint32_t start_time = pros::millis();
+    while (state.load() != DETECTOR_STOPPED)
+    {
+        if (pros::millis() - start_time >= timeout) return false;
+        pros::delay(5);
+    }
+    return true;
+}
+
+tr_detector_state tr_event_detector::get_state() const
+{
+    return state.load();
+}
+
+void tr_event_detector::clear_history()
+{
+    clear_requested = true;
+}
+
+void tr_event_detector::update(const tr_event_sample& sample)
+{
+    if (clear_requested.exchange(false))
+    {
+        history_count = 0;
+        history_head = 0;
+        diverged_samples = 0;
+        lost_samples = 0;
+        latched = false;
+    }
+
+    if (sample.accel >= push_accel)
+    {
+        bool recent = spiked && sample.time - spike_time <= accel_window;
+        spike_accel = recent ? fmaxf(spike_accel, sample.accel) : sample.accel;
+        spike_time = sample.time;
+        spiked = true;
+    }
+
+    if (!sample.has_innovation) return;
+
+    if (sample.reading_lost)
+    {
+        lost_samples++;
+        if (lost_samples == fault_samples) emit(EVENT_SENSOR_FAULT, sample.time, tr_vector2());
+        return;
+    }
+    lost_samples = 0;
+
+    if (!sample.valid) return;
+
+    constexpr int capacity = window_samples + 1;
+    int newest = (history_head + capacity - 1) % capacity;
+
+    // A previous sample that jumped further than the robot can move and came straight back was a bad reading, not motion.
+    if (history_count >= 2)
+    {
+        tr_vector2 previous = history[newest];
+        tr_vector2 before = history[(newest + capacity - 1) % capacity];
+        if (tr_distance_between(previous, before) > max_jump && tr_distance_between(sample.innovation, before) <= max_jump)
+        {
+            emit(EVENT_SENSOR_FAULT, sample.time, tr_vector2(previous.x - before.x, previous.y - before.y));
+            history[newest] = sample.innovation;
+            diverged_samples = 0;
+            return;
+        }
+    }
+
+    history[history_head] = sample.innovation;
+    history_head = (history_head + 1) % capacity;
+    if (history_count < capacity) history_count++;
+    if (history_count < capacity) return;
+
+    // Once full the head is the oldest sample. Both ends of the difference are measurements, so its variance is doubled.
+    const tr_vector2& oldest = history[history_head];
+    tr_vector2 divergence(sample.innovation.x - oldest.x, sample.innovation.y - oldest.y);
+    float variance_x = 2.0f * fmaxf(sample.variance.x, min_innovation_variance);
+    float variance_y = 2.0f * fmaxf(sample.variance.y, min_innovation_variance);
+    float chi_square = divergence.x * divergence.x / variance_x + divergence.y * divergence.y / variance_y;
+
+    if (tr_distance_between(divergence, tr_vector2()) < min_divergence || chi_square < divergence_gate)
+    {
+        diverged_samples = 0;
+        latched = false;
+        return;
+    }
+
+    diverged_samples++;
+    if (diverged_samples < persist_samples || latched) return;
+
+    bool pushed = spiked && sample.time - spike_time <= accel_window;
+    emit(pushed ? EVENT_PUSH : EVENT_SLIP, sample.time, divergence);
+    latched = true;
+}
+
+void tr_event_detector::emit(tr_event_kind kind, uint32_t time, tr_vector2 divergence)
+{
+    counts[kind]++;
+
+    tr_event event;
+    event.kind = kind;
+    event.time = time;
+    event.divergence = divergence;
+    event.accel = spiked && time - spike_time <= accel_window ? spike_accel : 0;
+
+    int head = queue_head.load();
+    int next = (head + 1) % queue_size;
+    if (next == queue_tail.load())
+    {
+        dropped++;
+        return;
+    }
+    queue[head] = event;
+    queue_head.store(next);
+}
+
+bool tr_event_detector::poll(tr_event& event)
+{
+    int tail = queue_tail.load();
+    if (tail == queue_head.load()) return false;
+
+    event = queue[tail];
+    queue_tail.store((tail + 1) % queue_size);
+    return true;
+}
+
+uint32_t tr_event_detector::get_count(tr_event_kind kind) const
+{
+    return counts[kind].load();
+}
+
+uint32_t tr_event_detector::get_dropped() const
+{
+    return dropped.load();
+}
+
+void tr_event_detector::task_body(void* param)
+{
+    static_cast<tr_event_detector*>(param)->run();
+}
+
+void tr_event_detector::run()
+{
+    int tick = 0;
+    uint32_t last = pros::millis();
+    while (!stop_requested.load())
+    {
+        {
+            TR_NO_ALLOC("tr_event_detector::run");
+            tr_event_sample sample = {};
+            sample.time = pros::millis();
+            sample.has_innovation = tick % innovation_periods == 0;
+            source(context, sample);
+            update(sample);
+        }
+
+        tick++;
+        pros::c::task_delay_until(&last, period);
+    }
+    state = DETECTOR_STOPPED;
+}
@@ -0,0 +1,303 @@
+#include "../../include/TitanReset/TRFieldMap.hpp"
+#include "../../include/TitanReset/TRChassis.hpp"
+#include "../../include/TitanReset/TRConstants.hpp"
+#include "../../include/TitanReset/TRUnits.hpp"
+#include "../../include/TitanReset/TRAllocGuard.hpp"
+#include "../../include/liblvgl/lvgl.h"
+#include <math.h>
+#include <string.h>
+#include <mutex>
+
+static_assert(sizeof(lv_color_t) == sizeof(uint32_t), "The field map requires LV_COLOR_DEPTH 32");
+
+/*
+* Colors are stored as ARGB8888 to match lv_color_t at a color depth of 32.
+*/
+static constexpr uint32_t color_field = 0xFF303030;
+static constexpr uint32_t color_tile = 0xFF4A4A4A;
+static constexpr uint32_t color_wall = 0xFFC8C8C8;
+static constexpr uint32_t color_odom = 0xFF2F8FFF;
+static constexpr uint32_t color_dsr = 0xFF30E060;
+static constexpr uint32_t color_beam = 0xFFFFB020;
+static constexpr uint32_t color_trail = 0xFFE04040;
+
+/**
+ * Pixels per inch of the field map.
+ */
+static constexpr float px_per_inch = (tr_field_map::size - 1) / (wall_coord * 2.0f);
+
+/**
+ * Tile size of the field in inches.
+ */
+static constexpr float tile_size = 24.0f;
+
+tr_field_canvas::tr_field_canvas(uint32_t* buffer, int16_t width, int16_t height) :
+            buffer(buffer),
+            width(width),
+            height(height),
+            dirty(tr_rect_empty)
+{}
+
+void tr_field_canvas::fill(uint32_t color)
+{
+    for (int i = 0; i < width * height; i++) buffer[i] = color;
+    dirty.join({0, 0, (int16_t)(width - 1), (int16_t)(height - 1)});
+}
+
+void tr_field_canvas::set_px(int16_t x, int16_t y, uint32_t color)
+{
+    if (x < 0 || y < 0 || x >= width || y >= height) return;
+    buffer[y * width + x] = color;
+    dirty.join({x, y, x, y});
+}
+
+void tr_field_canvas::draw_line(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint32_t color)
+{
+    int dx = abs(x1 - x0);
+    int dy = -abs(y1 - y0);
+    int sx = x0 < x1 ? 1 : -1;
+    int sy = y0 < y1 ? 1 : -1;
+    int err = dx + dy;
+
+    while (true)
+    {
+        set_px(x0, y0, color);
+        if (x0 == x1 && y0 == y1) break;
+        int e2 = 2 * err;
+        if (e2 >= dy)
+        {
+            err += dy;
+            x0 += sx;
+        }
+        if (e2 <= dx)
+        {
+            err += dx;
+            y0 += sy;
+        }
+    }
+}
+
+void tr_field_canvas::draw_dot(int16_t x, int16_t y, int16_t radius, uint32_t color)
+{
+    for (int16_t py = y - radius; py <= y + radius; py++)
+    {
+        for (int16_t px = x - radius; px <= x + radius; px++)
+        {
+            set_px(px, py, color);
+        }
+    }
+}
+
+void tr_field_canvas::restore(const uint32_t* source, tr_rect area)
+{
+    area = clip(area);
+    if (area.empty()) return;
+
+    int row_width = area.x2 - area.x1 + 1;
+    for (int y = area.y1; y <= area.y2; y++)
+    {
+        memcpy(&buffer[y * width + area.x1], &source[y * width + area.x1], row_width * sizeof(uint32_t));
+    }
+    dirty.join(area);
+}
+
+tr_rect tr_field_canvas::take_dirty()
+{
+    tr_rect ret = clip(dirty);
+    dirty = tr_rect_empty;
+    return ret;
+}
+
+tr_rect tr_field_canvas::clip(tr_rect area) const
+{
+    if (area.empty()) return tr_rect_empty;
+    if (area.x1 < 0) area.x1 = 0;
+    if (area.y1 < 0) area.y1 = 0;
+    if (area.x2 >= width) area.x2 = width - 1;
+    if (area.y2 >= height) area.y2 = height - 1;
+    return area;
+}
+
+tr_field_map::tr_field_map(tr_vector2 robot_size) :
+            canvas(pixels, size, size),
+            robot_size(robot_size),
+            lv_canvas(nullptr),
+            last_overlay(tr_rect_empty),
+            trail(),
+            trail_head(0),
+            trail_count(0),
+            seen_resets(0)
+{
+    draw_background();
+}
+
+/**
+ * @brief Rounds a pixel coordinate and clamps it to one canvas width beyond each edge.
+ *
+ * Lines to a pose far off the field would otherwise overflow int16_t and make the rasterizer walk thousands of pixels outside
+ * the canvas. fmaxf returns the bound for NaN, so a broken pose is clamped too.
+ */
+static int16_t tr_clamp_px(float px)
+{
+    return (int16_t)fminf(fmaxf(px + 0.5f, -tr_field_map::size), 2 * tr_field_map::size);
+}
+
+int16_t tr_field_map::to_px_x(float x)
+{
+    return tr_clamp_px((x + wall_coord) * px_per_inch);
+}
+
+int16_t tr_field_map::to_px_y(float y)
+{
+    return tr_clamp_px((wall_coord - y) * px_per_inch);
+}
+
+void tr_field_map::draw_background()
+{
+    tr_field_canvas back(background, size, size);
+    back.fill(color_field);
+
+    for (float coord = -wall_coord + tile_size; coord < wall_coord; coord += tile_size)
+    {
+        back.draw_line(to_px_x(coord), 0, to_px_x(coord), size - 1, color_tile);
+        back.draw_line(0, to_px_y(coord), size - 1, to_px_y(coord), color_tile);
+    }
+
+    back.draw_line(0, 0, size - 1, 0, color_wall);
+    back.draw_line(0, size - 1, size - 1, size - 1, color_wall);
+    back.draw_line(0, 0, 0, size - 1, color_wall);
+    back.draw_line(size - 1, 0, size - 1, size - 1, color_wall);
+
+    for (int i = 0; i < trail_count; i++)
+    {
+        const auto& correction = trail[(trail_head + i) % trail_length];
+        back.draw_line(to_px_x(correction.first.x), to_px_y(correction.first.y), to_px_x(correction.second.x), to_px_y(correction.second.y), color_trail);
+        back.set_px(to_px_x(correction.second.x), to_px_y(correction.second.y), color_dsr);
+    }
+
+    // The whole background changed so everything has to be redrawn on the next frame.
+    canvas.restore(background, {0, 0, size - 1, size - 1});
+}
+
+void tr_field_map::draw_robot(tr_vector3 pose, uint32_t color)
+{
+    float heading_rad = tr_quantity<tr_degree, float>(pose.z).to<tr_radian>().get();
+    float s = sin(heading_rad);
+    float c = cos(heading_rad);
+
+    // Forward is (sin, cos) and right is (cos, -sin) with heading measured clockwise from +Y.
+    float half_w = robot_size.x / 2.0f;
+    float half_l = robot_size.y / 2.0f;
+    float corners_x[4];
+    float corners_y[4];
+    const float signs[4][2] = {{1, 1}, {1, -1}, {-1, -1}, {-1, 1}};
+
+    for (int i = 0; i < 4; i++)
+    {
+        float right = signs[i][0] * half_w;
+        float fwd = signs[i][1] * half_l;
+        corners_x[i] = pose.x + fwd * s + right * c;
+        corners_y[i] = pose.y + fwd * c - right * s;
+    }
+
+    for (int i = 0; i < 4; i++)
+    {
+        int n = (i + 1) % 4;
+        canvas.draw_line(to_px_x(corners_x[i]), to_px_y(corners_y[i]), to_px_x(corners_x[n]), to_px_y(corners_y[n]), color);
+    }
+
+    canvas.draw_line(to_px_x(pose.x), to_px_y(pose.y), to_px_x(pose.x + half_l * s), to_px_y(pose.y + half_l * c), color);
+}
+
+tr_rect tr_field_map::render(const tr_field_frame& frame)
+{
+    canvas.restore(background, last_overlay);
+    tr_rect changed = canvas.take_dirty();
+
+    const int flags[4] = {NORTH, EAST, SOUTH, WEST};
+    for (int i = 0; i < 4; i++)
+    {
+        if (!(frame.active_sensors & flags[i]) || frame.beam_lengths[i] < 0) continue;
+
+        float beam_rad = tr_quantity<tr_degree, float>(frame.dsr_pose.z + 90.0f * i).to<tr_radian>().get();
+        float end_x = frame.dsr_pose.x + sin(beam_rad) * frame.beam_lengths[i];
+        float end_y = frame.dsr_pose.y + cos(beam_rad) * frame.beam_lengths[i];
+        canvas.draw_line(to_px_x(frame.dsr_pose.x), to_px_y(frame.dsr_pose.y), to_px_x(end_x), to_px_y(end_y), color_beam);
+    }
+
+    draw_robot(frame.odom_pose, color_odom);
+    canvas.draw_dot(to_px_x(frame.dsr_pose.x), to_px_y(frame.dsr_pose.y), 2, color_dsr);
+
+    last_overlay = canvas.take_dirty();
+    changed.join(last_overlay);
+    return changed;
+}
+
+void tr_field_map::push_correction(tr_vector3 from, tr_vector3 to)
+{
+    if (trail_count < trail_length)
+    {
+        trail[(trail_head + trail_count) % trail_length] = {from, to};
+        trail_count++;
+
+        tr_field_canvas back(background, size, size);
+        back.draw_line(to_px_x(from.x), to_px_y(from.y), to_px_x(to.x), to_px_y(to.y), color_trail);
+        back.set_px(to_px_x(to.x), to_px_y(to.y), color_dsr);
+        canvas.restore(background, back.take_dirty());
+        return;
+    }
+
+    // Dropping the oldest correction requires the background to be redrawn without it.
+    trail[trail_head] = {from, to};
+    trail_head = (trail_head + 1) % trail_length;
+    draw_background();
+}
+
+void tr_field_map::create(lv_obj_t* parent, int16_t x, int16_t y)
+{
+    lv_canvas = lv_canvas_create(parent);
+    lv_canvas_set_buffer(lv_canvas, pixels, size, size, LV_IMG_CF_TRUE_COLOR);
+    lv_obj_set_pos(lv_canvas, x, y);
+    lv_obj_invalidate(lv_canvas);
+}
+
+void tr_field_map::update(const tr_field_frame& frame)
+{
+    tr_rect changed = render(frame);
+    if (lv_canvas == nullptr || changed.empty()) return;
+
+    // lv_canvas_set_px invalidates the whole canvas per call, so pixels are written directly and only the changed area is invalidated.
+    lv_area_t coords;
+    lv_obj_get_coords(lv_canvas, &coords);
+
+    lv_area_t area;
+    area.x1 = coords.x1 + changed.x1;
+    area.y1 = coords.y1 + changed.y1;
+    area.x2 = coords.x1 + changed.x2;
+    area.y2 = coords.y1 + changed.y2;
+    lv_obj_invalidate_area(lv_canvas, &area);
+}
+
+void tr_field_map::update(tr_chassis* chassis)
+{
+    TR_NO_ALLOC("tr_field_map::update");
+    tr_field_frame frame;
+    frame.odom_pose = chassis->chassis.get_pose().to_vector();
+
+    // The last applied reset is drawn rather than a fresh calculation, which would overwrite the state of a reset running on another task.
+    bool new_reset;
+    tr_vector3 reset_from;
+    {
+        std::lock_guard<pros::Mutex> lock(chassis->dsr_mutex);
+        frame.dsr_pose = chassis->reset_count != 0 ? chassis->last_reset_to : frame.odom_pose;
+        frame.active_sensors = chassis->reset_count != 0 ? chassis->last_reset_sensors : 0;
+        for (int i = 0; i < 4; i++) frame.beam_lengths[i] = chassis->last_reset_beams[i];
+
+        new_reset = chassis->reset_count != seen_resets;
+        seen_resets = chassis->reset_count;
+        reset_from = chassis->last_reset_from;
+    }
+
+    if (new_reset) push_correction(reset_from, frame.dsr_pose);
+    update(frame);
+}
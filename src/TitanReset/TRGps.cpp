@@ -0,0 +1,117 @@
+#include "../../include/TitanReset/TRGps.hpp"
+#include "../../include/TitanReset/TRAngle.hpp"
+#include "../../include/TitanReset/TRUnits.hpp"
+#include "../../include/TitanReset/TRWalls.hpp"
+#include "../../include/pros/gps.h"
+#include <math.h>
+
+/**
+ * @brief Position of a point offset from the center of the robot, with X to the right of the robot and Y ahead of it.
+ */
+static tr_vector2 tr_mount_point(tr_vector2 center, tr_vector2 offset, float heading)
+{
+    float heading_rad = tr_quantity<tr_degree, float>(heading).to<tr_radian>().get();
+    float heading_sin = sinf(heading_rad);
+    float heading_cos = cosf(heading_rad);
+    return tr_vector2(center.x + offset.x * heading_cos + offset.y * heading_sin, center.y - offset.x * heading_sin + offset.y * heading_cos);
+}
+
+tr_gps::tr_gps(uint8_t port, tr_vector2 offset, float yaw, int field_rotation) : tr_gps(read_device, this, offset, yaw, field_rotation)
+{
+    this->port = port;
+}
+
+tr_gps::tr_gps(tr_gps_read_fn read, void* param, tr_vector2 offset, float yaw, int field_rotation) :
+            read_fn(read),
+            read_param(param),
+            port(0),
+            offset(offset),
+            yaw(yaw),
+            field_rotation((field_rotation % 4 + 4) % 4),
+            fused(0),
+            alone(0),
+            gated(0)
+{}
+
+bool tr_gps::initialize()
+{
+    if (port == 0) return true;
+    return pros::c::gps_set_offset(port, 0, 0) == 1;
+}
+
+tr_gps_reading tr_gps::read() const
+{
+    return read_fn(read_param);
+}
+
+bool tr_gps::measure(float heading, tr_gps_fix& fix) const
+{
+    tr_gps_reading reading = read();
+    if (!reading.valid || !(reading.error <= max_error)) return false;
+
+    tr_vector2d sensor = tr_turn_quarters(reading.position.x, reading.position.y, field_rotation);
+    tr_vector2 mount = tr_mount_point(tr_vector2(), offset, heading);
+    fix.position = tr_vector2(sensor.x - mount.x, sensor.y - mount.y);
+    fix.heading = tr_angle::from_degrees(reading.heading + 90.0f * field_rotation - yaw).to_degrees();
+
+    float error = fmaxf(reading.error, min_error);
+    fix.variance = error * error;
+    fix.confidence = min_error / error;
+    return true;
+}
+
+tr_vector2 tr_gps::get_offset() const
+{
+    return offset;
+}
+
+float tr_gps::get_yaw() const
+{
+    return yaw;
+}
+
+uint8_t tr_gps::get_port() const
+{
+    return port;
+}
+
+uint32_t tr_gps::get_fused() const
+{
+    return fused.load();
+}
+
+uint32_t tr_gps::get_alone() const
+{
+    return alone.load();
+}
+
+uint32_t tr_gps::get_gated() const
+{
+    return gated.load();
+}
+
+void tr_gps::record(tr_gps_outcome outcome)
+{
+    if (outcome == GPS_FUSED) fused++;
+    else if (outcome == GPS_ALONE) alone++;
+    else if (outcome == GPS_GATED) gated++;
+}
+
+tr_gps_reading tr_gps::read_device(void* param)
+{
+    uint8_t port = static_cast<tr_gps*>(param)->port;
+
+    // Every call returns PROS_ERR_F, which is infinite, while the sensor is unplugged or calibrating.
+    pros::gps_position_s_t position = pros::c::gps_get_position(port);
+    double heading = pros::c::gps_get_heading(port);
+    double error = pros::c::gps_get_error(port);
+
+    tr_gps_reading reading = {};
+    reading.valid = isfinite(position.x) && isfinite(position.y) && isfinite(heading) && isfinite(error);
+    if (!reading.valid) return reading;
+
+    reading.position = tr_vector2(tr_quantity<tr_metre>(position.x).to<tr_inch>().get(), tr_quantity<tr_metre>(position.y).to<tr_inch>().get());
+    reading.heading = heading;
+    reading.error = tr_quantity<tr_metre>(error).to<tr_inch>().get();
+    return reading;
+}
@@ -0,0 +1,440 @@
+#include "../../include/TitanReset/TRImuFusion.hpp"
+#include "../../include/TitanReset/TRDrivebase.hpp"
+#include "../../include/TitanReset/TRAllocGuard.hpp"
+#include "../../include/pros/imu.h"
+#include "../../include/pros/error.h"
+#include <math.h>
+#include <mutex>
+
+/**
+ * @brief Median of the fused rates.
+ */
+static float tr_median_rate(const float rates[tr_imu_fusion::max_imus], const bool fused[tr_imu_fusion::max_imus])
+{
+    float sorted[tr_imu_fusion::max_imus];
+    int count = 0;
+    for (int i = 0; i < tr_imu_fusion::max_imus; i++)
+    {
+        if (!fused[i]) continue;
+
+        int j = count++;
+        for (; j > 0 && sorted[j - 1] > rates[i]; j--) sorted[j] = sorted[j - 1];
+        sorted[j] = rates[i];
+    }
+    if (count == 0) return 0;
+    return count % 2 ? sorted[count / 2] : 0.5f * (sorted[count / 2 - 1] + sorted[count / 2]);
+}
+
+tr_imu_fusion::tr_imu_fusion(const std::vector<uint8_t>& ports) :
+            pros::Imu(ports.empty() ? 1 : ports[0]),
+            units(),
+            unit_count(0),
+            drivebase(nullptr),
+            drivebase_mutex(),
+            written_rotation(0),
+            rotation_written(false),
+            rotation(0),
+            still_elapsed(0),
+            published_rotation(0),
+            requested_rotation(0),
+            rotation_requested(false),
+            healthy_mask(0),
+            still(false),
+            readmit_requested(false),
+            state(FUSION_IDLE),
+            stop_requested(false)
+{
+    for (uint8_t port : ports) add_unit(port);
+}
+
+tr_imu_fusion::~tr_imu_fusion()
+{
+    stop(TIMEOUT_MAX);
+}
+
+bool tr_imu_fusion::add_unit(uint8_t port)
+{
+    if (unit_count >= max_imus) return false;
+    for (int i = 0; i < unit_count; i++)
+    {
+        if (units[i].port == port) return false;
+    }
+
+    tr_imu_unit& unit = units[unit_count];
+    unit.port = port;
+    unit.health = IMU_DISCONNECTED;
+    unit.last_rotation = 0;
+    unit.primed = false;
+    unit.bias = 0;
+    unit.bias_variance = initial_bias_sigma * initial_bias_sigma;
+    unit.scale = 1;
+    unit.scale_xy = 0;
+    unit.scale_xx = 0;
+    unit.divergence = 0;
+    unit_count++;
+    return true;
+}
+
+int tr_imu_fusion::add_all_devices()
+{
+    for (const pros::Imu& imu : pros::Imu::get_all_devices()) add_unit(imu.get_port());
+    return unit_count;
+}
+
+void tr_imu_fusion::set_drivebase(const tr_drivebase* new_drivebase)
+{
+    std::lock_guard<pros::Mutex> lock(drivebase_mutex);
+    drivebase = new_drivebase;
+    rotation_written = false;
+}
+
+bool tr_imu_fusion::start()
+{
+    if (state.load() == FUSION_RUNNING) return true;
+
+    stop_requested = false;
+    state = FUSION_RUNNING;
+
+    pros::task_t task = pros::c::task_create(task_body, this, TASK_PRIORITY_DEFAULT + 1, TASK_STACK_DEPTH_DEFAULT, "TR IMU Fusion");
+    if (task == nullptr)
+    {
+        state = FUSION_STOPPED;
+        return false;
+    }
+    return true;
+}
+
+bool tr_imu_fusion::stop(uint32_t timeout)
+{
+    if (state.load() != FUSION_RUNNING) return true;
+
+    stop_requested = true;
+    uint32_t start_time = pros::millis();
+    while (state.load() != FUSION_STOPPED)
+    {
+        if (pros::millis() - start_time >= timeout) return false;
+        pros::delay(5);
+    }
+    return true;
+}
+
+tr_fusion_state tr_imu_fusion::get_state() const
+{
+    return state.load();
+}
+
+void tr_imu_fusion::update(uint32_t elapsed)
+{
+    std::lock_guard<pros::Mutex> lock(drivebase_mutex);
+    if (rotation_requested.exchange(false)) rotation = requested_rotation.load();
+    bool readmit = readmit_requested.exchange(false);
+
+    float dt = elapsed / 1000.0f;
+    float raw_rates[max_imus] = {};
+    float rates[max_imus] = {};
+    bool fused[max_imus] = {};
+    int fused_count = 0;
+    bool all_still = true;
+    uint8_t drive_port = drivebase != nullptr ? drivebase->get_imu_port() : 0;
+    int drive_unit = -1;
+
+    for (int i = 0; i < unit_count; i++)
+    {
+        tr_imu_unit& unit = units[i];
+        if (readmit && unit.health == IMU_DISAGREEING)
+        {
+            unit.health = IMU_CALIBRATING;
+            unit.primed = false;
+            unit.divergence = 0;
+        }
+
+        pros::imu_status_e_t status = pros::c::imu_get_status(unit.port);
+        double reading = pros::c::imu_get_rotation(unit.port);
+        if (status == pros::E_IMU_STATUS_ERROR || !isfinite(reading))
+        {
+            if (unit.health != IMU_DISAGREEING) unit.health = IMU_DISCONNECTED;
+            unit.primed = false;
+            continue;
+        }
+        if (status & pros::E_IMU_STATUS_CALIBRATING)
+        {
+            if (unit.health != IMU_DISAGREEING) unit.health = IMU_CALIBRATING;
+            unit.primed = false;
+            continue;
+        }
+
+        // The first reading after connecting or calibrating only gives the next change something to start from.
+        double change = reading - unit.last_rotation;
+        unit.last_rotation = reading;
+        bool primed = unit.primed;
+        unit.primed = true;
+        if (unit.health == IMU_DISAGREEING) continue;
+        unit.health = IMU_HEALTHY;
+        if (!primed || elapsed == 0) continue;
+
+        raw_rates[i] = change / dt;
+        rates[i] = (raw_rates[i] - unit.bias) / unit.scale;
+        fused[i] = true;
+        fused_count++;
+        if (unit.port == drive_port) drive_unit = i;
+        all_still = all_still && fabsf(raw_rates[i] - unit.bias) < still_rate;
+    }
+
+    // A write into the drivebase IMU by anything else shows as its reading moving from the rotation written last period by more than the
+    // other units turned. Its jump is left out of the fusion and the fused rotation continues from the reading.
+    double drive_rotation = 0;
+    bool external_write = false;
+    if (rotation_written && drivebase->get_rotation(drive_rotation))
+    {
+        bool others[max_imus] = {};
+        int other_count = 0;
+        for (int i = 0; i < unit_count; i++)
+        {
+            others[i] = fused[i] && i != drive_unit;
+            other_count += others[i];
+        }
+
+        double turned = other_count > 0 ? tr_median_rate(rates, others) * dt : 0;
+        float tolerance = other_count > 0 ? max_divergence : max_rate * dt + max_divergence;
+        external_write = fabs(drive_rotation - (written_rotation + turned)) > tolerance;
+        if (external_write && drive_unit >= 0)
+        {
+            fused[drive_unit] = false;
+            fused_count--;
+        }
+    }
+
+    // Divergence is measured against the median, which one unit jumping cannot drag along with it.
+    if (fused_count >= 3)
+    {
+        float median = tr_median_rate(rates, fused);
+        float leak = fminf(1.0f, (float)elapsed / divergence_leak);
+        for (int i = 0; i < unit_count; i++)
+        {
+            if (!fused[i]) continue;
+
+            tr_imu_unit& unit = units[i];
+            unit.divergence = unit.divergence * (1.0f - leak) + (rates[i] - median) * dt;
+            if (fabsf(unit.divergence) <= max_divergence) continue;
+
+            unit.health = IMU_DISAGREEING;
+            fused[i] = false;
+            fused_count--;
+        }
+    }
+
+    still_elapsed = fused_count > 0 && all_still ? still_elapsed + elapsed : 0;
+    bool is_still_now = still_elapsed >= still_time;
+
+    // Weighted by how certain each bias is, so a unit still learning its bias counts for less.
+    float weight_sum = 0;
+    float rate_sum = 0;
+    for (int i = 0; i < unit_count; i++)
+    {
+        if (!fused[i]) continue;
+        float weight = 1.0f / (units[i].bias_variance + rate_noise * rate_noise);
+        weight_sum += weight;
+        rate_sum += weight * rates[i];
+    }
+    float fused_rate = weight_sum > 0 ? rate_sum / weight_sum : 0;
+    if (is_still_now) fused_rate = 0;
+
+    float process_noise = bias_random_walk * dt;
+    for (int i = 0; i < unit_count; i++)
+    {
+        tr_imu_unit& unit = units[i];
+        if (!fused[i]) continue;
+
+        // While still every unit should read zero, so what it reads is its bias.
+        unit.bias_variance += process_noise;
+        if (is_still_now)
+        {
+            float gain = unit.bias_variance / (unit.bias_variance + rate_noise * rate_noise);
+            unit.bias += gain * (raw_rates[i] - unit.bias);
+            unit.bias_variance *= 1.0f - gain;
+        }
+
+        // Each scale is regressed against the others, which share none of its own scale error.
+        if (fused_count < 2) continue;
+        float reference = 0;
+        for (int j = 0; j < unit_count; j++)
+        {
+            if (fused[j] && j != i) reference += rates[j];
+        }
+        reference /= fused_count - 1;
+
+        // A sample far from the reference is a glitch rather than scale, and would drag the regression off.
+        float corrected = raw_rates[i] - unit.bias;
+        if (fabsf(reference) < min_scale_rate || fabsf(corrected - reference) > max_scale_error * fabsf(reference)) continue;
+        unit.scale_xy += reference * corrected;
+        unit.scale_xx += reference * reference;
+    }
+
+    // Scales are only known relative to each other, so they are normalized to average to one.
+    float scale_sum = 0;
+    int scale_count = 0;
+    for (int i = 0; i < unit_count; i++)
+    {
+        if (units[i].scale_xx <= 0) continue;
+        units[i].scale = units[i].scale_xy / units[i].scale_xx;
+        scale_sum += units[i].scale;
+        scale_count++;
+    }
+    if (scale_count >= 2)
+    {
+        for (int i = 0; i < unit_count; i++)
+        {
+            if (units[i].scale_xx > 0) units[i].scale *= scale_count / scale_sum;
+        }
+    }
+
+    rotation += fused_rate * dt;
+    if (external_write) rotation = drive_rotation;
+    published_rotation = rotation;
+
+    uint8_t mask = 0;
+    for (int i = 0; i < unit_count; i++)
+    {
+        if (fused[i] && units[i].health == IMU_HEALTHY) mask |= 1 << i;
+    }
+    healthy_mask = mask;
+    still = is_still_now;
+
+    // Writing into a fused unit moves its reading, so the next change is taken from after the write.
+    rotation_written = drivebase != nullptr && drivebase->set_rotation(rotation);
+    written_rotation = rotation;
+    if (rotation_written)
+    {
+        uint8_t port = drivebase->get_imu_port();
+        for (int i = 0; i < unit_count; i++)
+        {
+            if (units[i].port == port && units[i].primed) units[i].last_rotation = pros::c::imu_get_rotation(port);
+        }
+    }
+}
+
+const tr_imu_unit& tr_imu_fusion::get_unit(int index) const
+{
+    return units[index];
+}
+
+int tr_imu_fusion::get_unit_count() const
+{
+    return unit_count;
+}
+
+int tr_imu_fusion::get_healthy_count() const
+{
+    uint8_t mask = healthy_mask.load();
+    int count = 0;
+    for (int i = 0; i < max_imus; i++) count += (mask >> i) & 1;
+    return count;
+}
+
+bool tr_imu_fusion::is_still() const
+{
+    return still.load();
+}
+
+double tr_imu_fusion::get_rotation() const
+{
+    return published_rotation.load();
+}
+
+double tr_imu_fusion::get_heading() const
+{
+    double heading = fmod(published_rotation.load(), 360.0);
+    return heading < 0 ? heading + 360.0 : heading;
+}
+
+std::int32_t tr_imu_fusion::set_rotation(const double target) const
+{
+    requested_rotation = target;
+    rotation_requested = true;
+    published_rotation = target;
+    return 1;
+}
+
+std::int32_t tr_imu_fusion::set_heading(const double target) const
+{
+    return set_rotation(get_rotation() - get_heading() + target);
+}
+
+std::int32_t tr_imu_fusion::tare_rotation() const
+{
+    return set_rotation(0);
+}
+
+std::int32_t tr_imu_fusion::tare_heading() const
+{
+    return set_heading(0);
+}
+
+std::int32_t tr_imu_fusion::tare() const
+{
+    return set_rotation(0);
+}
+
+std::int32_t tr_imu_fusion::reset(bool blocking) const
+{
+    std::int32_t result = 1;
+    for (int i = 0; i < unit_count; i++)
+    {
+        if (pros::c::imu_reset(units[i].port) != 1) result = PROS_ERR;
+    }
+    readmit_requested = true;
+
+    while (blocking && is_calibrating()) pros::delay(period);
+    return result;
+}
+
+bool tr_imu_fusion::is_calibrating() const
+{
+    for (int i = 0; i < unit_count; i++)
+    {
+        pros::imu_status_e_t status = pros::c::imu_get_status(units[i].port);
+        if (status != pros::E_IMU_STATUS_ERROR && (status & pros::E_IMU_STATUS_CALIBRATING)) return true;
+    }
+    return false;
+}
+
+pros::imu_accel_s_t tr_imu_fusion::get_accel() const
+{
+    pros::imu_accel_s_t sum = {0, 0, 0};
+    uint8_t mask = healthy_mask.load();
+    int count = 0;
+    for (int i = 0; i < unit_count; i++)
+    {
+        if (!((mask >> i) & 1)) continue;
+        pros::imu_accel_s_t accel = pros::c::imu_get_accel(units[i].port);
+        sum.x += accel.x;
+        sum.y += accel.y;
+        sum.z += accel.z;
+        count++;
+    }
+    if (count == 0) return sum;
+    return {sum.x / count, sum.y / count, sum.z / count};
+}
+
+void tr_imu_fusion::task_body(void* param)
+{
+    static_cast<tr_imu_fusion*>(param)->run();
+}
+
+void tr_imu_fusion::run()
+{
+    uint32_t last = pros::millis();
+    uint32_t previous = last;
+    while (!stop_requested.load())
+    {
+        {
+            TR_NO_ALLOC("tr_imu_fusion::run");
+            uint32_t now = pros::millis();
+            update(now - previous);
+            previous = now;
+        }
+
+        pros::c::task_delay_until(&last, period);
+    }
+    state = FUSION_STOPPED;
+}
@@ -0,0 +1,93 @@
+#include "../../include/TitanReset/TROdomEstimator.hpp"
+#include "../../include/TitanReset/TRUnits.hpp"
+#include <math.h>
+
+/**
+ * Smallest variance in square inches a reset is weighted with, so a perfect reset does not dominate the regression.
+ */
+static constexpr float min_reset_variance = 0.01f;
+
+tr_odom_estimator::tr_odom_estimator(float scale_prior, float turn_prior) : scale_prior(scale_prior), turn_prior(turn_prior)
+{
+    reset();
+}
+
+void tr_odom_estimator::reset()
+{
+    info_scale = 1.0f / (scale_prior * scale_prior);
+    info_cross = 0;
+    info_turn = 1.0f / (turn_prior * turn_prior);
+    vector_scale = 0;
+    vector_turn = 0;
+    observations = 0;
+}
+
+void tr_odom_estimator::add(tr_vector2 displacement, float turned, float mid_heading, tr_vector2 correction, tr_vector2 variance)
+{
+    float travelled = sqrtf(displacement.x * displacement.x + displacement.y * displacement.y);
+    float turned_rad = tr_quantity<tr_degree, float>(turned).to<tr_radian>().get();
+    float heading_rad = tr_quantity<tr_degree, float>(mid_heading).to<tr_radian>().get();
+
+    // Each axis of the correction is one row of the regression.
+    const float rows[2][3] = {
+        {static_cast<float>(displacement.x), turned_rad * sinf(heading_rad), static_cast<float>(correction.x)},
+        {static_cast<float>(displacement.y), turned_rad * cosf(heading_rad), static_cast<float>(correction.y)},
+    };
+    const float row_variance[2] = {static_cast<float>(variance.x), static_cast<float>(variance.y)};
+
+    for (int i = 0; i < 2; i++)
+    {
+        float weight = 1.0f / (fmaxf(row_variance[i], min_reset_variance) + odometry_noise * travelled);
+        info_scale += weight * rows[i][0] * rows[i][0];
+        info_cross += weight * rows[i][0] * rows[i][1];
+        info_turn += weight * rows[i][1] * rows[i][1];
+        vector_scale += weight * rows[i][0] * rows[i][2];
+        vector_turn += weight * rows[i][1] * rows[i][2];
+    }
+    observations++;
+}
+
+float tr_odom_estimator::determinant() const
+{
+    return info_scale * info_turn - info_cross * info_cross;
+}
+
+float tr_odom_estimator::get_scale() const
+{
+    return 1.0f + (info_turn * vector_scale - info_cross * vector_turn) / determinant();
+}
+
+float tr_odom_estimator::get_scale_sigma() const
+{
+    return sqrtf(info_turn / determinant());
+}
+
+float tr_odom_estimator::get_turn_error() const
+{
+    return (info_scale * vector_turn - info_cross * vector_scale) / determinant();
+}
+
+float tr_odom_estimator::get_turn_sigma() const
+{
+    return sqrtf(info_scale / determinant());
+}
+
+int tr_odom_estimator::get_observations() const
+{
+    return observations;
+}
+
+bool tr_odom_estimator::is_scale_significant(int min_observations) const
+{
+    return observations >= min_observations && fabsf(get_scale() - 1.0f) >= 2.0f * get_scale_sigma();
+}
+
+float tr_odom_estimator::take_scale_step(float max_step)
+{
+    float step = fmaxf(-max_step, fminf(max_step, get_scale() - 1.0f));
+
+    // Shifting the information vector by the information times the step moves the estimate by exactly the step.
+    vector_scale -= info_scale * step;
+    vector_turn -= info_cross * step;
+    return 1.0f + step;
+}
@@ -0,0 +1,236 @@
+#include "../../include/TitanReset/TRPoseTracker.hpp"
+#include "../../include/TitanReset/TRChassis.hpp"
+#include "../../include/TitanReset/TRAngle.hpp"
+#include "../../include/TitanReset/TRWalls.hpp"
+#include "../../include/TitanReset/TRUnits.hpp"
+#include "../../include/TitanReset/TRAllocGuard.hpp"
+#include <math.h>
+#include <mutex>
+
+tr_pose_tracker::tr_pose_tracker(tr_chassis* chassis) : chassis(chassis), hypotheses(), last_odom(), elements(), element_count(0)
+{}
+
+bool tr_pose_tracker::add_element(tr_vector2 from, tr_vector2 to)
+{
+    if (element_count >= max_elements) return false;
+
+    elements[element_count].from = from;
+    elements[element_count].to = to;
+    element_count++;
+    return true;
+}
+
+void tr_pose_tracker::reset(float heading_sigma)
+{
+    last_odom = chassis->chassis.get_pose();
+    for (int k = 0; k < max_hypotheses; k++)
+    {
+        tr_vector2d position = tr_turn_quarters(last_odom.x, last_odom.y, k);
+        hypotheses[k].pose = {position.x, position.y, tr_angle::from_degrees(last_odom.theta + 90.0f * k).to_degrees()};
+        hypotheses[k].log_likelihood = 0;
+        hypotheses[k].active = true;
+    }
+
+    if (heading_sigma > 0) observe_heading(last_odom.theta, heading_sigma);
+}
+
+float tr_pose_tracker::trace_elements(tr_vector2 origin, float facing, float& incidence) const
+{
+    float facing_rad = tr_quantity<tr_degree, float>(facing).to<tr_radian>().get();
+    float dx = sinf(facing_rad);
+    float dy = cosf(facing_rad);
+
+    float nearest = HUGE_VALF;
+    for (int e = 0; e < element_count; e++)
+    {
+        float ex = elements[e].to.x - elements[e].from.x;
+        float ey = elements[e].to.y - elements[e].from.y;
+        float denominator = dx * ey - dy * ex;
+        if (fabsf(denominator) < 1e-6f) continue;
+
+        // Solve origin + range * direction = from + along * (to - from).
+        float ox = elements[e].from.x - origin.x;
+        float oy = elements[e].from.y - origin.y;
+        float range = (ox * ey - oy * ex) / denominator;
+        float along = (ox * dy - oy * dx) / denominator;
+        if (range <= 0 || along < 0 || along > 1 || range >= nearest) continue;
+
+        nearest = range;
+        float length = sqrtf(ex * ex + ey * ey);
+        incidence = tr_quantity<tr_radian, float>(acosf(fminf(1.0f, fabsf(denominator) / length))).to<tr_degree>().get();
+    }
+    return nearest;
+}
+
+float tr_pose_tracker::weigh(tr_hypothesis& hypothesis, const float readings[4])
+{
+    const tr_sensor* sensors[4] = {chassis->north, chassis->east, chassis->south, chassis->west};
+    const tr_beam_model& model = chassis->beam_model;
+    tr_vector2 position(hypothesis.pose.x, hypothesis.pose.y);
+    float heading = hypothesis.pose.theta;
+    float heading_error = tr_sensor::relative_square(heading);
+
+    float chi_square = 0;
+    tr_vector2 correction;
+    for (int i = 0; i < 4; i++)
+    {
+        float facing = heading + 90.0f * tr_sensor_mounts[i];
+        tr_vector2 origin = sensors[i]->get_origin(position, facing);
+        facing += sensors[i]->get_yaw();
+
+        tr_beam_trace trace = tr_trace_beam(origin, facing);
+        float bias = model.corner_bias(origin, facing, trace);
+        float expected = trace.range + bias;
+        float incidence = trace.incidence;
+
+        float element_incidence = 0;
+        float element_range = trace_elements(origin, facing, element_incidence);
+        bool hits_wall = element_range >= expected;
+        if (!hits_wall)
+        {
+            expected = element_range;
+            incidence = element_incidence;
+            bias = 0;
+        }
+
+        tr_beam_quality quality = model.evaluate(expected, 1.0f, incidence, bias);
+        if (!quality.is_valid()) continue;
+
+        if (readings[i] == err_reading_value)
+        {
+            chi_square += missing_reading_chi_square;
+            continue;
+        }
+
+        float error = sensors[i]->correct(readings[i], heading_error) - expected;
+        chi_square += fminf(error * error / quality.variance, max_beam_chi_square);
+
+        // A beam reading short of a wall means the robot is closer to it than the hypothesis.
+        if (!hits_wall || fabsf(error) > max_correction) continue;
+        float facing_rad = tr_quantity<tr_degree, float>(facing).to<tr_radian>().get();
+        if (trace.hits_x_wall) correction.x = sinf(facing_rad) > 0 ? -error : error;
+        else correction.y = cosf(facing_rad) > 0 ? -error : error;
+    }
+
+    hypothesis.pose.x += correction.x;
+    hypothesis.pose.y += correction.y;
+    return -0.5f * chi_square;
+}
+
+void tr_pose_tracker::update()
+{
+    TR_NO_ALLOC("tr_pose_tracker::update");
+    tr_sensor* sensors[4] = {chassis->north, chassis->east, chassis->south, chassis->west};
+    float readings[4];
+    for (int i = 0; i < 4; i++) readings[i] = sensors[i]->distance().get_value();
+
+    tr_pose odom = chassis->chassis.get_pose();
+    double dx = odom.x - last_odom.x;
+    double dy = odom.y - last_odom.y;
+    last_odom = odom;
+
+    for (int k = 0; k < max_hypotheses; k++)
+    {
+        tr_hypothesis& hypothesis = hypotheses[k];
+        if (!hypothesis.active) continue;
+
+        tr_vector2d displacement = tr_turn_quarters(dx, dy, k);
+        hypothesis.pose.x += displacement.x;
+        hypothesis.pose.y += displacement.y;
+        hypothesis.pose.theta = tr_angle::from_degrees(odom.theta + 90.0f * k).to_degrees();
+        hypothesis.log_likelihood += weigh(hypothesis, readings);
+    }
+    normalize();
+}
+
+void tr_pose_tracker::observe_heading(float heading, float sigma)
+{
+    for (int k = 0; k < max_hypotheses; k++)
+    {
+        if (!hypotheses[k].active) continue;
+
+        float error = (tr_angle::from_degrees(hypotheses[k].pose.theta) - tr_angle::from_degrees(heading)).to_signed_degrees();
+        hypotheses[k].log_likelihood -= 0.5f * error * error / (sigma * sigma);
+    }
+    normalize();
+}
+
+void tr_pose_tracker::normalize()
+{
+    float best = -HUGE_VALF;
+    for (int k = 0; k < max_hypotheses; k++)
+    {
+        if (hypotheses[k].active) best = fmaxf(best, hypotheses[k].log_likelihood);
+    }
+
+    float prune_log = logf(prune_ratio);
+    for (int k = 0; k < max_hypotheses; k++)
+    {
+        if (!hypotheses[k].active) continue;
+
+        hypotheses[k].log_likelihood -= best;
+        if (hypotheses[k].log_likelihood < -prune_log) hypotheses[k].active = false;
+    }
+}
+
+float tr_pose_tracker::get_likelihood_ratio() const
+{
+    // The best hypothesis sits at 0, so the next best log likelihood is the negative log ratio.
+    bool found_best = false;
+    float second = -HUGE_VALF;
+    for (int k = 0; k < max_hypotheses; k++)
+    {
+        if (!hypotheses[k].active) continue;
+
+        if (!found_best && hypotheses[k].log_likelihood == 0) found_best = true;
+        else second = fmaxf(second, hypotheses[k].log_likelihood);
+    }
+    return expf(-second);
+}
+
+int tr_pose_tracker::get_committed() const
+{
+    if (get_likelihood_ratio() < commit_ratio) return -1;
+
+    for (int k = 0; k < max_hypotheses; k++)
+    {
+        if (hypotheses[k].active && hypotheses[k].log_likelihood == 0) return k;
+    }
+    return -1;
+}
+
+const tr_hypothesis& tr_pose_tracker::get_hypothesis(int index) const
+{
+    return hypotheses[index];
+}
+
+int tr_pose_tracker::get_active_count() const
+{
+    int count = 0;
+    for (int k = 0; k < max_hypotheses; k++) count += hypotheses[k].active;
+    return count;
+}
+
+bool tr_pose_tracker::apply()
+{
+    int committed = get_committed();
+    if (committed < 0) return false;
+
+    // Any reset running on another task would write its correction on top of the old pose.
+    std::lock_guard<pros::Mutex> lock(chassis->dsr_mutex);
+    const tr_pose& pose = hypotheses[committed].pose;
+    if (committed != 0 && chassis->imu != nullptr) chassis->imu->set_heading(pose.theta);
+    chassis->chassis.set_pose(pose);
+    last_odom = pose;
+
+    // The pose jumped, so nothing measured against the old one carries over.
+    chassis->event_detector.clear_history();
+    chassis->follow_primed = false;
+    chassis->anchor_valid = false;
+
+    // Relative to the committed pose, the old hypothesis committed + k is k quarter turns away.
+    tr_hypothesis renumbered[max_hypotheses];
+    for (int k = 0; k < max_hypotheses; k++) renumbered[k] = hypotheses[(committed + k) % max_hypotheses];
+    for (int k = 0; k < max_hypotheses; k++) hypotheses[k] = renumbered[k];
+    return true;
+}
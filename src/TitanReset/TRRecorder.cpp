@@ -0,0 +1,167 @@
+#include "../../include/TitanReset/TRRecorder.hpp"
+#include "../../include/TitanReset/TRAllocGuard.hpp"
+#include <string.h>
+
+/*
+* Static stdio buffers keep the recording loop off of the heap. Only one recording runs at a time.
+*/
+static char odom_buffer[512];
+static char dist_buffer[512];
+
+tr_recorder::tr_recorder(tr_record_source source, void* context) :
+            source(source),
+            context(context),
+            state(RECORDER_IDLE),
+            stop_requested(false),
+            dropped(0),
+            written(0),
+            batch(),
+            batch_count(0),
+            date(),
+            time()
+{}
+
+tr_recorder::~tr_recorder()
+{
+    stop(TIMEOUT_MAX);
+}
+
+bool tr_recorder::start(const char* r_date, const char* r_time)
+{
+    tr_recorder_state current = state.load();
+    if ((current == RECORDER_RUNNING || current == RECORDER_DRAINING) && !stop()) return false;
+
+    strncpy(date, r_date, sizeof(date) - 1);
+    date[sizeof(date) - 1] = '\0';
+    strncpy(time, r_time, sizeof(time) - 1);
+    time[sizeof(time) - 1] = '\0';
+
+    batch_count = 0;
+    dropped = 0;
+    written = 0;
+    stop_requested = false;
+    state = RECORDER_RUNNING;
+
+    pros::task_t task = pros::c::task_create(task_body, this, TASK_PRIORITY_DEFAULT, TASK_STACK_DEPTH_DEFAULT, "TR Recorder");
+    if (task == nullptr)
+    {
+        state = RECORDER_STOPPED;
+        return false;
+    }
+    return true;
+}
+
+bool tr_recorder::stop(uint32_t timeout)
+{
+    tr_recorder_state current = state.load();
+    if (current == RECORDER_IDLE || current == RECORDER_STOPPED) return true;
+
+    stop_requested = true;
+    tr_recorder_state expected = RECORDER_RUNNING;
+    state.compare_exchange_strong(expected, RECORDER_DRAINING);
+
+    uint32_t start_time = pros::millis();
+    while (state.load() != RECORDER_STOPPED)
+    {
+        if (pros::millis() - start_time >= timeout) return false;
+        pros::delay(5);
+    }
+    return true;
+}
+
+tr_recorder_state tr_recorder::get_state() const
+{
+    return state.load();
+}
+
+uint32_t tr_recorder::get_dropped() const
+{
+    return dropped.load();
+}
+
+uint32_t tr_recorder::get_written() const
+{
+    return written.load();
+}
+
+void tr_recorder::task_body(void* param)
+{
+    static_cast<tr_recorder*>(param)->run();
+}
+
+void tr_recorder::write_batch(FILE* odom_file, FILE* dist_file)
+{
+    char line[96];
+
+    for (int i = 0; i < batch_count; i++)
+    {
+        const tr_record& record = batch[i];
+        bool ok = true;
+
+        // Lines are formatted fully before writing so a truncated record never reaches the file.
+        int len = snprintf(line, sizeof(line), "%g, %g, %g\n", record.odom.x, record.odom.y, record.odom.z);
+        ok = ok && len > 0 && len < (int)sizeof(line) && fwrite(line, 1, len, odom_file) == (size_t)len;
+
+        len = snprintf(line, sizeof(line), "%g, %g, %g\n", record.dsr.x, record.dsr.y, record.dsr.z);
+        ok = ok && len > 0 && len < (int)sizeof(line) && fwrite(line, 1, len, dist_file) == (size_t)len;
+
+        if (ok) written++;
+        else dropped++;
+    }
+
+    fflush(odom_file);
+    fflush(dist_file);
+    batch_count = 0;
+}
+
+void tr_recorder::run()
+{
+    FILE* odom_file = fopen("odom_data.txt", "a");
+    FILE* dist_file = fopen("dist_data.txt", "a");
+
+    if (odom_file == nullptr || dist_file == nullptr)
+    {
+        if (odom_file != nullptr) fclose(odom_file);
+        if (dist_file != nullptr) fclose(dist_file);
+        state = RECORDER_STOPPED;
+        return;
+    }
+
+    setvbuf(odom_file, odom_buffer, _IOFBF, sizeof(odom_buffer));
+    setvbuf(dist_file, dist_buffer, _IOFBF, sizeof(dist_buffer));
+
+    uint32_t now = pros::millis();
+    fprintf(odom_file, "\nTimestamp: %s %s %lu\n", date, time, (unsigned long)now);
+    fprintf(dist_file, "\nTimestamp: %s %s %lu\n", date, time, (unsigned long)now);
+    fflush(odom_file);
+    fflush(dist_file);
+
+    uint32_t last = now;
+    while (!stop_requested.load())
+    {
+        {
+            TR_NO_ALLOC("tr_recorder::run");
+            tr_record& record = batch[batch_count++];
+            source(context, record);
+            record.time = pros::millis();
+
+            if (batch_count == batch_size) write_batch(odom_file, dist_file);
+        }
+
+        // Count every period that was skipped because sampling or writing overran it.
+        now = pros::millis();
+        if (now - last >= 2 * period)
+        {
+            uint32_t missed = (now - last) / period - 1;
+            dropped += missed;
+            last += missed * period;
+        }
+        pros::c::task_delay_until(&last, period);
+    }
+
+    state = RECORDER_DRAINING;
+    write_batch(odom_file, dist_file);
+    fclose(odom_file);
+    fclose(dist_file);
+    state = RECORDER_STOPPED;
+}
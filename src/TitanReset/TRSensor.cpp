@@ -1,20 +1,30 @@
 #include "../../include/TitanReset/TRSensor.hpp"
 #include "../../include/TitanReset/TRConstants.hpp"
+#include "../../include/TitanReset/TRAngle.hpp"
+#include "../../include/TitanReset/TRBeams.hpp"
+#include "../../include/TitanReset/TRUnits.hpp"
+#include <math.h>
+#include <stdio.h>
+
+/*
+* Sensor readings stay in float, a millimetre count has far less precision than a float carries.
+*/
+typedef tr_quantity<tr_millimetre, float> tr_sensor_reading;
 
 tr_sensor::tr_sensor(tr_vector2 offset, int port) :
             offset(offset),
+            yaw(0),
+            yaw_sin(0),
+            yaw_cos(1),
+            correction(),
             sensor(port)
 {}
 
 float tr_sensor::relative_square(float heading)
 {
-    float wrapped = fmod(heading, 360.0f);
-    if (wrapped < 0) wrapped += 360.0f;
-
     // Find distance to the nearest 90-degree increment
     // This gives you how "un-square" the robot is to the wall
-    float relative = fmod(wrapped + 45.0f, 90.0f) - 45.0f;
-    return relative;
+    return tr_angle::from_degrees(heading).square_error_degrees();
 }
 
 tr_conf_pair<float> tr_sensor::distance()
@@ -23,7 +33,7 @@ tr_conf_pair<float> tr_sensor::distance()
     float sensor_confidence = (sensor.get_confidence() / confidence_domain);
     if (sensor_reading == err_reading_value) return tr_conf_pair<float>(err_reading_value, 0.0);
 
-    return tr_conf_pair<float>(sensor_reading * mm_inch_conversion_factor, sensor_confidence);
+    return tr_conf_pair<float>(tr_sensor_reading(sensor_reading).to<tr_inch>().get(), sensor_confidence);
 }
 
 tr_conf_pair<float> tr_sensor::distance(float heading)
@@ -32,15 +42,101 @@ tr_conf_pair<float> tr_sensor::distance(float heading)
     float sensor_confidence = (sensor.get_confidence() / confidence_domain);
     if (sensor_reading == err_reading_value) return tr_conf_pair<float>(err_reading_value, 0.0);
 
-    auto reading = sensor_reading * mm_inch_conversion_factor;
+    tr_quantity<tr_degree, float> heading_err(tr_sensor::relative_square(heading));
+
+    float reading = correct(tr_sensor_reading(sensor_reading).to<tr_inch>().get(), heading_err.get());
 
-    heading = tr_sensor::relative_square(heading);
+    float heading_err_rad = heading_err.to<tr_radian>().get();
+    float heading_sin;
+    float heading_cos;
+    tr_fast_sincos(heading_err_rad, heading_sin, heading_cos);
 
-    float heading_err_rad = heading * deg_rad_conversion_factor;
+    float along;
+    float across;
+    beam_components(reading, along, across);
 
-    float actual_reading = cos(heading_err_rad) * reading;
-    float parallel_offset = cos(heading_err_rad) * offset.x;
-    float perpendicular_offset = sin(heading_err_rad) * offset.y;
+    float actual_reading = heading_cos * along;
+    float parallel_offset = heading_cos * offset.x;
+    float perpendicular_offset = heading_sin * (offset.y + across);
 
     return tr_conf_pair<float>(actual_reading + parallel_offset - perpendicular_offset, sensor_confidence);
-}
\ No newline at end of file
+}
+
+tr_vector2 tr_sensor::get_offset() const
+{
+    return offset;
+}
+
+float tr_sensor::get_yaw() const
+{
+    return yaw;
+}
+
+int tr_sensor::get_port() const
+{
+    return sensor.get_port();
+}
+
+void tr_sensor::set_calibration(tr_vector2 off, float mount_yaw)
+{
+    offset = off;
+    yaw = mount_yaw;
+
+    tr_quantity<tr_degree, float> yaw_deg(mount_yaw);
+    float yaw_rad = yaw_deg.to<tr_radian>().get();
+    yaw_sin = sinf(yaw_rad);
+    yaw_cos = cosf(yaw_rad);
+}
+
+bool tr_sensor::load_calibration(const char* path)
+{
+    FILE* file = fopen(path, "r");
+    if (file == nullptr) return false;
+
+    // One line per sensor: port parallel perpendicular yaw
+    int entry_port;
+    float parallel;
+    float perpendicular;
+    float mount_yaw;
+    bool found = false;
+    while (fscanf(file, "%d %f %f %f", &entry_port, &parallel, &perpendicular, &mount_yaw) == 4)
+    {
+        if (entry_port == get_port())
+        {
+            set_calibration(tr_vector2(parallel, perpendicular), mount_yaw);
+            found = true;
+        }
+    }
+
+    fclose(file);
+    return found;
+}
+
+void tr_sensor::beam_components(float reading, float& along, float& across) const
+{
+    along = reading * yaw_cos;
+    across = reading * yaw_sin;
+}
+
+tr_vector2 tr_sensor::get_origin(tr_vector2 robot, float facing) const
+{
+    float facing_rad = tr_quantity<tr_degree, float>(facing).to<tr_radian>().get();
+    float facing_sin = sinf(facing_rad);
+    float facing_cos = cosf(facing_rad);
+
+    // Perpendicular offsets are to the right of the facing.
+    return tr_vector2(robot.x + offset.x * facing_sin + offset.y * facing_cos, robot.y + offset.x * facing_cos - offset.y * facing_sin);
+}
+
+bool tr_sensor::load_correction(const char* path)
+{
+    return correction.load(path);
+}
+
+float tr_sensor::correct(float reading, float heading_error) const
+{
+    if (reading == err_reading_value) return reading;
+
+    // The beam meets the wall at the heading error plus the mounting yaw.
+    return reading + correction.lookup(reading, heading_error + yaw);
+}
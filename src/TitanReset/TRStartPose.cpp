@@ -0,0 +1,204 @@
+#include "../../include/TitanReset/TRStartPose.hpp"
+#include "../../include/TitanReset/TRChassis.hpp"
+#include "../../include/TitanReset/TRAngle.hpp"
+#include "../../include/TitanReset/TRWalls.hpp"
+#include "../../include/EZ-Template/sdcard.hpp"
+#include <math.h>
+#include <string.h>
+
+/**
+ * Least amount of beams a start pose has to be compared on to be scored.
+ */
+static constexpr int min_compared_beams = 2;
+
+/**
+ * Difference in inches counted for a beam that should read at a start pose but did not.
+ */
+static constexpr float missing_reading_error = 6.0f;
+
+tr_start_detector::tr_start_detector(tr_chassis* chassis) : chassis(chassis), starts(), start_rms(), start_count(0)
+{
+    last_match.index = -1;
+    last_match.rms = HUGE_VALF;
+    last_match.skew = 0;
+    last_match.stable = false;
+    last_match.unique = false;
+}
+
+bool tr_start_detector::add(const char* name, tr_vector2 position, float heading)
+{
+    if (start_count >= max_starts) return false;
+
+    starts[start_count].name = name;
+    starts[start_count].position = position;
+    starts[start_count].heading = heading;
+    start_rms[start_count] = HUGE_VALF;
+    start_count++;
+    return true;
+}
+
+float tr_start_detector::fit(const float readings[4], tr_vector2 position, float heading) const
+{
+    const tr_sensor* sensors[4] = {chassis->north, chassis->east, chassis->south, chassis->west};
+    const tr_beam_model& model = chassis->beam_model;
+    float heading_error = tr_sensor::relative_square(heading);
+
+    float error_sum = 0;
+    int compared = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        float facing = heading + 90.0f * tr_sensor_mounts[i];
+        tr_vector2 origin = sensors[i]->get_origin(position, facing);
+        facing += sensors[i]->get_yaw();
+
+        tr_beam_trace trace = tr_trace_beam(origin, facing);
+        float bias = model.corner_bias(origin, facing, trace);
+        float expected = trace.range + bias;
+        if (!model.evaluate(expected, 1.0f, trace.incidence, bias).is_valid()) continue;
+
+        float error = missing_reading_error;
+        if (readings[i] != err_reading_value) error = sensors[i]->correct(readings[i], heading_error) - expected;
+        error_sum += error * error;
+        compared++;
+    }
+
+    if (compared < min_compared_beams) return HUGE_VALF;
+    return sqrtf(error_sum / compared);
+}
+
+tr_start_match tr_start_detector::detect(int samples, uint32_t period)
+{
+    tr_sensor* sensors[4] = {chassis->north, chassis->east, chassis->south, chassis->west};
+    float sums[4] = {};
+    int counts[4] = {};
+
+    float first_rotation = chassis->imu != nullptr ? chassis->imu->get_rotation() : 0;
+    float max_turn = 0;
+    for (int sample = 0; sample < samples; sample++)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            float reading = sensors[i]->distance().get_value();
+            if (reading == err_reading_value) continue;
+            sums[i] += reading;
+            counts[i]++;
+        }
+
+        if (chassis->imu != nullptr) max_turn = fmaxf(max_turn, fabsf(chassis->imu->get_rotation() - first_rotation));
+        if (sample + 1 < samples) pros::delay(period);
+    }
+
+    // A sensor that missed most of its samples is looking at nothing it can measure.
+    float readings[4];
+    for (int i = 0; i < 4; i++)
+    {
+        readings[i] = counts[i] * 2 >= samples && counts[i] > 0 ? sums[i] / counts[i] : err_reading_value;
+    }
+
+    tr_start_match match;
+    match.index = -1;
+    match.rms = HUGE_VALF;
+    match.skew = 0;
+    match.stable = max_turn <= max_rotation;
+    match.unique = false;
+
+    // Start poses are in the frame of odometry, the beam model in the field frame.
+    const tr_mirror& mirror = chassis->chassis.get_mirror();
+
+    int best = -1;
+    float skews[max_starts];
+    for (int k = 0; k < start_count; k++)
+    {
+        start_rms[k] = HUGE_VALF;
+        skews[k] = 0;
+        tr_vector2 position = mirror.point(starts[k].position);
+        float heading = mirror.heading(starts[k].heading);
+        for (float skew = -max_skew; skew <= max_skew + 1e-3f; skew += skew_step)
+        {
+            float rms = fit(readings, position, heading + skew);
+            if (rms < start_rms[k])
+            {
+                start_rms[k] = rms;
+                skews[k] = skew;
+            }
+        }
+        if (best < 0 || start_rms[k] < start_rms[best]) best = k;
+    }
+    if (best < 0) return last_match = match;
+
+    match.rms = start_rms[best];
+    match.skew = skews[best];
+    if (match.stable && match.rms <= max_rms) match.index = best;
+
+    // Routines sharing a start pose do not make a match ambiguous, only poses at another place or heading do.
+    match.unique = match.index >= 0;
+    for (int k = 0; k < start_count && match.unique; k++)
+    {
+        float dx = starts[k].position.x - starts[best].position.x;
+        float dy = starts[k].position.y - starts[best].position.y;
+        float turn = (tr_angle::from_degrees(starts[k].heading) - tr_angle::from_degrees(starts[best].heading)).to_signed_degrees();
+        bool same_pose = dx * dx + dy * dy <= 1.0f && fabsf(turn) <= 1.0f;
+        if (!same_pose && start_rms[k] < match.rms + ambiguity_margin) match.unique = false;
+    }
+
+    return last_match = match;
+}
+
+tr_start_check tr_start_detector::confirm_selection(const tr_start_match& match)
+{
+    ez::AutonSelector& selector = ez::as::auton_selector;
+    int selected = selector.auton_page_current;
+    if (!match.stable || selected < 0 || selected >= (int)selector.Autons.size()) return START_UNKNOWN;
+
+    const char* selected_name = selector.Autons[selected].Name.c_str();
+    for (int k = 0; k < start_count; k++)
+    {
+        if (strcmp(starts[k].name, selected_name) == 0 && start_rms[k] <= max_rms) return START_CONFIRMED;
+    }
+
+    if (match.index < 0 || !match.unique) return START_UNKNOWN;
+
+    for (int j = 0; j < (int)selector.Autons.size(); j++)
+    {
+        if (strcmp(starts[match.index].name, selector.Autons[j].Name.c_str()) != 0) continue;
+
+        selector.auton_page_current = j;
+        selector.selected_auton_print();
+        return START_CORRECTED;
+    }
+    return START_UNKNOWN;
+}
+
+tr_dsr_result tr_start_detector::apply(const tr_start_match& match)
+{
+    // An ambiguous placement is left to the routine, which knows which of the starts it is run from.
+    if (match.index < 0 || match.index >= start_count || !match.unique)
+    {
+        tr_dsr_result result = {};
+        result.rejection = REJECT_START_UNKNOWN;
+        return result;
+    }
+
+    const tr_start_pose& start = starts[match.index];
+    return chassis->perform_dsr_init(tr_position_quadrant(start.position.x, start.position.y), tr_angle::from_degrees(start.heading).to_degrees());
+}
+
+const tr_start_match& tr_start_detector::get_last_match() const
+{
+    return last_match;
+}
+
+const tr_start_pose& tr_start_detector::get_start(int index) const
+{
+    return starts[index];
+}
+
+float tr_start_detector::get_start_rms(int index) const
+{
+    return start_rms[index];
+}
+
+int tr_start_detector::get_start_count() const
+{
+    return start_count;
+}
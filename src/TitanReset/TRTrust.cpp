@@ -0,0 +1,34 @@
+#include "../../include/TitanReset/TRTrust.hpp"
+
+tr_trust_policy::tr_trust_policy(float sensor_trust, float max_correction, float max_residual, float max_variance) :
+            min_confidence(1.0f - sensor_trust),
+            max_correction(max_correction),
+            max_residual(max_residual),
+            max_variance(max_variance)
+{}
+
+tr_rejection_reason tr_trust_policy::evaluate(const tr_dsr_result& result) const
+{
+    if (result.confidence < min_confidence) return REJECT_LOW_CONFIDENCE;
+
+    if (max_correction > 0)
+    {
+        float correction_sq = result.correction.x * result.correction.x + result.correction.y * result.correction.y;
+        if (correction_sq > max_correction * max_correction) return REJECT_CORRECTION_TOO_LARGE;
+    }
+
+    if (max_residual > 0)
+    {
+        for (float residual : result.residuals)
+        {
+            if (fabs(residual) > max_residual) return REJECT_RESIDUAL_TOO_LARGE;
+        }
+    }
+
+    if (max_variance > 0)
+    {
+        if (result.variance.x > max_variance || result.variance.y > max_variance) return REJECT_VARIANCE_TOO_LARGE;
+    }
+
+    return REJECT_NONE;
+}
@@ -0,0 +1,82 @@
+#include "../../include/TitanReset/TRWallFollow.hpp"
+#include "../../include/TitanReset/TRAllocGuard.hpp"
+
+tr_wall_follower::tr_wall_follower(tr_follow_step step, void* context) :
+            step(step),
+            context(context),
+            state(FOLLOWER_IDLE),
+            stop_requested(false),
+            applied(0),
+            rejected(0)
+{}
+
+bool tr_wall_follower::start()
+{
+    if (state.load() == FOLLOWER_RUNNING) return true;
+
+    applied = 0;
+    rejected = 0;
+    stop_requested = false;
+    state = FOLLOWER_RUNNING;
+
+    pros::task_t task = pros::c::task_create(task_body, this, TASK_PRIORITY_DEFAULT, TASK_STACK_DEPTH_DEFAULT, "TR Wall Follower");
+    if (task == nullptr)
+    {
+        state = FOLLOWER_STOPPED;
+        return false;
+    }
+    return true;
+}
+
+bool tr_wall_follower::stop(uint32_t timeout)
+{
+    if (state.load() != FOLLOWER_RUNNING) return true;
+
+    stop_requested = true;
+    uint32_t start_time = pros::millis();
+    while (state.load() != FOLLOWER_STOPPED)
+    {
+        if (pros::millis() - start_time >= timeout) return false;
+        pros::delay(5);
+    }
+    return true;
+}
+
+tr_follower_state tr_wall_follower::get_state() const
+{
+    return state.load();
+}
+
+uint32_t tr_wall_follower::get_applied() const
+{
+    return applied.load();
+}
+
+uint32_t tr_wall_follower::get_rejected() const
+{
+    return rejected.load();
+}
+
+void tr_wall_follower::task_body(void* param)
+{
+    static_cast<tr_wall_follower*>(param)->run();
+}
+
+void tr_wall_follower::run()
+{
+    uint32_t last = pros::millis();
+    while (!stop_requested.load())
+    {
+        tr_follow_outcome outcome;
+        {
+            TR_NO_ALLOC("tr_wall_follower::run");
+            outcome = step(context);
+        }
+
+        if (outcome == FOLLOW_APPLIED) applied++;
+        if (outcome == FOLLOW_REJECTED) rejected++;
+
+        pros::c::task_delay_until(&last, period);
+    }
+    state = FOLLOWER_STOPPED;
+}
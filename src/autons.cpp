@@ -10,6 +10,19 @@ const int DRIVE_SPEED = 110;
 const int TURN_SPEED = 90;
 const int SWING_SPEED = 110;
 
+///
+// Start pose fallback
+///
+void dsr_init_fallback(tr_quadrant quadrant, float heading) {
+  /*
+  * autonomous() already placed the robot from its detected start pose. Only when that was rejected, or the routine runs outside of
+  * autonomous, is the robot told where it starts. The detected start is used up here, so a later run of any routine initializes again.
+  */
+  bool placed = start_reset.applied;
+  start_reset = {};
+  if (!placed) dsr_system.perform_dsr_init(quadrant, heading);
+}
+
 ///
 // DSR Example
 ///
@@ -20,9 +33,9 @@ void distance_sensor_reset_example() {
   // for slew, only enable it when the drive distance is greater than the slew distance + a few inches
 
   /*
-  * Initalize your autons position by telling the robot it is in NEG NEG quadrant anmd facing 0 degrees.
+  * If the start pose was not detected, initalize your autons position by telling the robot it is in NEG NEG quadrant and facing 0 degrees.
   */
-  dsr_system.perform_dsr_init(tr_quadrant::NEG_NEG, 0);
+  dsr_init_fallback(tr_quadrant::NEG_NEG, 0);
 
   chassis.pid_drive_set(24_in, DRIVE_SPEED, true);
   chassis.pid_wait();
@@ -39,6 +52,97 @@ void distance_sensor_reset_example() {
   chassis.pid_wait();
 }
 
+///
+// DSR at waypoints example
+///
+void distance_sensor_reset_waypoint_example() {
+  dsr_init_fallback(tr_quadrant::NEG_NEG, 0);
+
+  std::vector<ez::odom> path = {
+      {{-48, -24}, fwd, DRIVE_SPEED},
+      {{-24, -24}, fwd, DRIVE_SPEED},
+      {{-24, 0}, fwd, DRIVE_SPEED},
+  };
+
+  /*
+  * Schedule a reset for when the robot passes the second point. The reading is taken on the fly, so the motion never stops for it.
+  */
+  tr_dsr_handle reset = dsr_system.perform_dsr_at_index(path, 1);
+
+  chassis.pid_odom_set(path, true);
+  chassis.pid_wait();
+
+  /*
+  * The handle reports whether the reset was applied, or why it was rejected.
+  */
+  if (reset.get_rejection() != REJECT_NONE) printf("Waypoint reset rejected: %d\n", reset.get_rejection());
+}
+
+///
+// Distance Sensor Wall Following Example
+///
+void distance_sensor_wall_following_example() {
+  dsr_init_fallback(tr_quadrant::NEG_NEG, 0);
+
+  /*
+  * While the robot drives along the wall, the side sensor keeps correcting its distance to the wall. Distance along the wall comes from odometry.
+  */
+  dsr_system.start_wall_following();
+
+  chassis.pid_drive_set(72_in, DRIVE_SPEED, true);
+  chassis.pid_wait();
+
+  dsr_system.stop_wall_following();
+  printf("Wall following corrections: %lu\n", (unsigned long)dsr_system.get_wall_follower().get_applied());
+}
+
+///
+// Distance Sensor Event Detection Example
+///
+void distance_sensor_event_example() {
+  dsr_init_fallback(tr_quadrant::NEG_NEG, 0);
+  dsr_system.start_event_detection();
+
+  chassis.pid_drive_set(48_in, DRIVE_SPEED, true);
+  chassis.pid_wait();
+
+  /*
+  * If the robot was pushed or its wheels slipped during the motion, re-localize before continuing the route.
+  */
+  tr_event event;
+  bool diverged = false;
+  while (dsr_system.get_event_detector().poll(event)) {
+    if (event.kind == EVENT_PUSH || event.kind == EVENT_SLIP) diverged = true;
+  }
+  if (diverged) dsr_system.perform_dsr();
+
+  chassis.pid_turn_set(90_deg, TURN_SPEED);
+  chassis.pid_wait();
+
+  dsr_system.stop_event_detection();
+}
+
+///
+// Mirrored DSR Example
+///
+void distance_sensor_mirrored_example() {
+  /*
+  * Mirror odometry across the Y axis and tell TitanReset, so the routine written for the left side of the field runs on the right side unchanged.
+  */
+  chassis.odom_x_flip();
+  chassis.odom_theta_flip();
+  dsr_system.sync_mirror();
+
+  distance_sensor_reset_example();
+
+  /*
+  * Restore the frame for the next routine.
+  */
+  chassis.odom_x_flip(false);
+  chassis.odom_theta_flip(false);
+  dsr_system.sync_mirror();
+}
+
 ///
 // Constants
 ///
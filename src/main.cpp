@@ -56,6 +56,29 @@ tr_sensor west({7, 2}, 13);
  */
 tr_chassis dsr_system(&chassis.imu, &chassis, {&north, &east, &south, &west});
 
+// With more than one IMU, fuse them and pass the fusion instead, then call imu_fusion.start() in initialize()
+// - `7`, `15` and `16` are smart ports, including the one EZ-Template's drive was given
+// tr_imu_fusion imu_fusion({7, 15, 16});
+// tr_chassis dsr_system(&imu_fusion, &chassis, {&north, &east, &south, &west});
+
+// With a GPS sensor, fuse it into every reset, then call gps.initialize() and dsr_system.set_gps(&gps) in initialize()
+// - `14` is the smart port
+// - `{0, -6}` is the offset in inches, to the right of and ahead of the center of the robot
+// - `180` is the mounting yaw, here facing backwards
+// tr_gps gps(14, {0, -6}, 180);
+
+/**
+ * Start pose detector
+ * Matches where the robot was placed against the start pose registered for each autonomous routine.
+ */
+tr_start_detector start_detector(&dsr_system);
+
+/**
+ * Result of applying the detected start pose at the start of autonomous
+ * Routines only initialize their own start pose when it was rejected, and clear it once they have read it.
+ */
+tr_dsr_result start_reset = {};
+
 // Uncomment the trackers you're using here!
 // - `8` and `9` are smart ports (making these negative will reverse the sensor)
 //  - you should get positive values on the encoders going FORWARD and RIGHT
@@ -99,9 +122,24 @@ void initialize() {
 
   // Autonomous Selector using LLEMU
   ez::as::auton_selector.autons_add({
-      {"Example with distance sensor reset", distance_sensor_reset_example}
+      {"Example with distance sensor reset", distance_sensor_reset_example},
+      {"Example with distance sensor resets at waypoints", distance_sensor_reset_waypoint_example},
+      {"Example with distance sensor wall following", distance_sensor_wall_following_example},
+      {"Example with distance sensor event detection", distance_sensor_event_example},
+      {"Example with distance sensor reset, mirrored", distance_sensor_mirrored_example}
   });
 
+  // Register where each routine starts, so the placement of the robot can be checked against the selected routine before the match
+  start_detector.add("Example with distance sensor reset", {-36, -60}, 0);
+  start_detector.add("Example with distance sensor resets at waypoints", {-48, -48}, 0);
+  start_detector.add("Example with distance sensor wall following", {-60, -36}, 0);
+  start_detector.add("Example with distance sensor event detection", {-36, -60}, 0);
+  start_detector.add("Example with distance sensor reset, mirrored", {36, -60}, 0);  // Mirrored inside the routine, so registered where it starts on the field
+
+  // Load sensor mountings solved by tr_calibrator, sensors without one keep the offsets above
+  dsr_system.load_calibration();
+  dsr_system.load_corrections();
+
   // Initialize chassis and auton selector
   chassis.initialize();
   ez::as::initialize();
@@ -127,7 +165,14 @@ void disabled() {
  * starts.
  */
 void competition_initialize() {
-  // . . .
+  // Check the placement of the robot against the selected routine until the match starts, rumbling when it changes to a mismatch
+  tr_start_check last_check = START_CONFIRMED;
+  while (true) {
+    tr_start_check check = start_detector.confirm_selection(start_detector.detect());
+    if (check != START_CONFIRMED && check != last_check) master.rumble("-");
+    last_check = check;
+    pros::delay(500);
+  }
 }
 
 /**
@@ -147,6 +192,7 @@ void autonomous() {
   chassis.drive_sensor_reset();               // Reset drive sensors to 0
   chassis.odom_xyt_set(0_in, 0_in, 0_deg);    // Set the current position, you can start at a specific position with this
   chassis.drive_brake_set(MOTOR_BRAKE_HOLD);  // Set motors to hold.  This helps autonomous consistency
+  start_reset = start_detector.apply(start_detector.get_last_match());  // Set the heading and position from the start pose detected before the match
 
   /*
   Odometry and Pure Pursuit are not magic
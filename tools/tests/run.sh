@@ -0,0 +1,37 @@
+#!/bin/sh
+#
+# Builds TitanReset for the host against the simulation in tr_host.cpp and runs every host test.
+#
+# Run from the project root:
+#   sh tools/tests/run.sh [test...]
+#
+# Tests are the tr_test_*.cpp and tr_bench_*.cpp files next to this script, run in that order, or the named ones.
+# Objects and test binaries go to $TR_HOST_BUILD, by default a titanreset_host directory in the temporary directory.
+#
+# Everything is built with -Wall -Wextra -Werror. include is searched as a system directory, so the PROS, LVGL, okapi and EZ-Template
+# headers written for the V5 toolchain are not held to it. The library includes its own headers by relative path, which keeps them warned on.
+
+set -e
+
+build="${TR_HOST_BUILD:-${TMPDIR:-/tmp}/titanreset_host}"
+flags="-std=gnu++20 -O2 -g -Wall -Wextra -Werror -isystem include -Itools/tests -D_POSIX_THREADS -D_UNIX98_THREAD_MUTEX_ATTRIBUTES"
+mkdir -p "$build"
+
+# Only the objects a test uses are linked out of the archive, so tests without a screen never need LVGL.
+rm -f "$build/libtitanreset.a"
+for source in src/TitanReset/*.cpp tools/tests/tr_host.cpp tools/tests/tr_simulated_gps.cpp; do
+    object="$build/$(basename "$source" .cpp).o"
+    g++ $flags -c "$source" -o "$object"
+    ar rc "$build/libtitanreset.a" "$object"
+done
+
+if [ $# -eq 0 ]; then
+    set -- $(ls tools/tests/tr_test_*.cpp tools/tests/tr_bench_*.cpp 2>/dev/null | xargs -n 1 basename | sed 's/\.cpp$//')
+fi
+
+failed=0
+for test in "$@"; do
+    g++ $flags "tools/tests/$test.cpp" "$build/libtitanreset.a" -o "$build/$test"
+    "$build/$test" || failed=1
+done
+exit $failed
@@ -0,0 +1,98 @@
+/*
+* Accuracy and throughput of the batched beam transform.
+*
+* tr_beam_transform is compared against the double precision scalar reference over the whole +-45 degree domain of the heading
+* error and a spread of readings and offsets, then both are timed over the same inputs. The vector path this host builds is
+* printed with the timings, so running it on an ARM host covers the NEON path the V5 uses.
+*
+* Built and run by tools/tests/run.sh.
+*/
+
+#include "tr_host.hpp"
+#include "TitanReset/TRBeams.hpp"
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+
+/**
+ * Largest difference in inches the batched transform may have from the reference anywhere in its domain.
+ */
+static constexpr float tolerance = 1e-4f;
+
+/**
+ * Heading errors in the accuracy sweep, evenly spread from -45 to 45 degrees.
+ */
+static constexpr int error_steps = 9001;
+
+/**
+ * Transforms timed per implementation.
+ */
+static constexpr int timed_runs = 2000000;
+
+static const float parallel[4] = {6, 4, 4, 7};
+static const float perpendicular[4] = {3, 1.5, 1, 2};
+
+/**
+ * Written with every result so the timed transforms are not optimized away.
+ */
+static volatile float sink;
+
+template<typename Transform>
+static double time_transform(Transform transform)
+{
+    float readings[4] = {12, 40, 30, 8};
+    float out[4];
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < timed_runs; i++)
+    {
+        // The heading changes every run so nothing is hoisted out of the loop.
+        transform(-45.0f + (i % 9001) * 0.01f, readings, parallel, perpendicular, out);
+        sink = out[i & 3];
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / timed_runs;
+}
+
+int main()
+{
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    const char* path = "NEON";
+#elif defined(__SSE__) || defined(_M_X64)
+    const char* path = "SSE";
+#else
+    const char* path = "scalar";
+#endif
+
+    float worst = 0;
+    float worst_error = 0;
+    for (int step = 0; step < error_steps; step++)
+    {
+        float heading_error = -45.0f + 90.0f * step / (error_steps - 1);
+        for (float reading : {0.0f, 2.5f, 17.0f, 60.0f, 140.0f})
+        {
+            float readings[4] = {reading, reading * 0.5f, reading + 3, 140 - reading};
+            float fast[4];
+            float reference[4];
+            tr_beam_transform(heading_error, readings, parallel, perpendicular, fast);
+            tr_beam_transform_scalar(heading_error, readings, parallel, perpendicular, reference);
+            for (int i = 0; i < 4; i++)
+            {
+                float difference = fabsf(fast[i] - reference[i]);
+                if (difference > worst)
+                {
+                    worst = difference;
+                    worst_error = heading_error;
+                }
+            }
+        }
+    }
+
+    char message[96];
+    snprintf(message, sizeof(message), "batched transform within %g in of the reference, worst %g in at %.2f degrees", tolerance, worst, worst_error);
+    tr_host_check(worst < tolerance, message);
+
+    double batched = time_transform(tr_beam_transform);
+    double scalar = time_transform(tr_beam_transform_scalar);
+    printf("tr_bench_beams: %s path, worst error %.2g in, batched %.1f ns, scalar %.1f ns, %.1fx\n", path, worst, batched, scalar, scalar / batched);
+
+    return tr_host_report("tr_bench_beams");
+}
@@ -0,0 +1,72 @@
+/*
+* Cost and accuracy of the unit tagged quantities.
+*
+* A conversion through tr_quantity has to fold to one constant multiply, so it is timed against the bare multiply it replaces
+* and has to give the same bits. Its scale is compared against the truncated conversion constants in TRConstants.hpp, which
+* the quantities replace, over headings and distances the V5 sees.
+*
+* Built and run by tools/tests/run.sh.
+*/
+
+#include "tr_host.hpp"
+#include "TitanReset/TRUnits.hpp"
+#include "TitanReset/TRConstants.hpp"
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+
+// Conversions are folded at compile time.
+static_assert(tr_quantity<tr_degree, double>(180).to<tr_radian>().get() == 3.14159265358979323846, "degrees to radians folds");
+static_assert(tr_quantity<tr_metre, double>(1).to<tr_millimetre>().get() > 999.999, "metres to millimetres folds");
+
+/**
+ * Conversions timed per variant.
+ */
+static constexpr int timed_runs = 20000000;
+
+/**
+ * Written with every result so the timed conversions are not optimized away.
+ */
+static volatile float sink;
+
+template<typename Convert>
+static double time_convert(Convert convert)
+{
+    auto start = std::chrono::steady_clock::now();
+    float sum = 0;
+    for (int i = 0; i < timed_runs; i++) sum += convert((float)(i & 1023));
+    sink = sum;
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / timed_runs;
+}
+
+int main()
+{
+    // The quantity has to give exactly what a multiply by the exact constant gives.
+    constexpr float exact_deg_rad = (float)(3.14159265358979323846 / 180.0);
+    bool same_bits = true;
+    float worst_heading = 0;
+    for (int step = -36000; step <= 36000; step++)
+    {
+        float degrees = step * 0.01f;
+        float converted = tr_quantity<tr_degree, float>(degrees).to<tr_radian>().get();
+        same_bits = same_bits && converted == degrees * exact_deg_rad;
+        worst_heading = fmaxf(worst_heading, fabsf(degrees * deg_rad_conversion_factor - converted));
+    }
+    tr_host_check(same_bits, "degrees to radians is one multiply by the exact scale");
+
+    float worst_distance = 0;
+    for (int mm = 0; mm <= 2000; mm++)
+    {
+        float converted = tr_quantity<tr_millimetre, float>((float)mm).to<tr_inch>().get();
+        worst_distance = fmaxf(worst_distance, fabsf(mm * mm_inch_conversion_factor - converted));
+    }
+    tr_host_check(worst_distance < 1e-3f, "millimetres to inches matches the old constant");
+
+    double bare = time_convert([](float degrees) { return degrees * exact_deg_rad; });
+    double quantity = time_convert([](float degrees) { return tr_quantity<tr_degree, float>(degrees).to<tr_radian>().get(); });
+    tr_host_check(quantity < bare * 1.5 + 0.2, "quantity conversion costs no more than a bare multiply");
+
+    printf("tr_bench_units: bare %.2f ns, quantity %.2f ns, old degree constant off by up to %.2g rad over +-360 degrees, old mm constant by up to %.2g in\n",
+           bare, quantity, worst_heading, worst_distance);
+    return tr_host_report("tr_bench_units");
+}
@@ -0,0 +1,260 @@
+#include "tr_host.hpp"
+#include "TitanReset/TRBeamModel.hpp"
+#include "TitanReset/TRUnits.hpp"
+#include "EZ-Template/sdcard.hpp"
+#include "EZ-Template/auton_selector.hpp"
+#include "EZ-Template/tracking_wheel.hpp"
+#include "okapi/api/util/logging.hpp"
+#include "pros/distance.hpp"
+#include "pros/imu.hpp"
+#include "pros/imu.h"
+#include "pros/gps.h"
+#include "pros/rtos.hpp"
+#include <chrono>
+#include <math.h>
+#include <mutex>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+
+tr_pose tr_host_truth = {0, 0, 0};
+tr_pose tr_host_odom = {0, 0, 0};
+bool tr_host_flip_x = false;
+bool tr_host_flip_y = false;
+bool tr_host_flip_theta = false;
+ez::e_mode tr_host_drive_mode = ez::DISABLE;
+int tr_host_wheel_velocity = 0;
+double tr_host_drive_ratio = 1;
+double tr_host_imu_rotation[22] = {};
+bool tr_host_imu_connected[22] = {true, true, true, true, true, true, true, true, true, true, true,
+                                  true, true, true, true, true, true, true, true, true, true, true};
+uint32_t tr_host_time = 0;
+
+static int check_count = 0;
+static int failure_count = 0;
+
+/**
+ * Offsets of the distance sensors on ports 10 to 13, along the beam and to its right, matching tr_host_sensors.
+ */
+static const tr_vector2 distance_offsets[4] = {tr_vector2(6, 3), tr_vector2(4, 1.5), tr_vector2(4, 1), tr_vector2(7, 2)};
+
+/**
+ * Storage of the simulated drivebase. Its constructor needs motors, so only the IMU member is ever constructed.
+ */
+alignas(ez::Drive) static unsigned char drive_storage[sizeof(ez::Drive)];
+
+ez::Drive* tr_host_drive()
+{
+    static ez::Drive* drive = nullptr;
+    if (drive == nullptr)
+    {
+        drive = reinterpret_cast<ez::Drive*>(drive_storage);
+        new (&drive->imu) pros::Imu(1);
+    }
+    return drive;
+}
+
+void tr_host_place(tr_pose truth, double odom_x, double odom_y)
+{
+    tr_host_truth = truth;
+    tr_host_odom = {truth.x + odom_x, truth.y + odom_y, truth.theta};
+}
+
+bool tr_host_check(bool passed, const char* what)
+{
+    check_count++;
+    if (!passed)
+    {
+        failure_count++;
+        printf("FAIL %s\n", what);
+    }
+    return passed;
+}
+
+int tr_host_report(const char* test)
+{
+    printf("%s: %d checks, %d failures\n", test, check_count, failure_count);
+    return failure_count == 0 ? 0 : 1;
+}
+
+static ez::pose flip(ez::pose pose)
+{
+    return {tr_host_flip_x ? -pose.x : pose.x, tr_host_flip_y ? -pose.y : pose.y, tr_host_flip_theta ? -pose.theta : pose.theta};
+}
+
+/*
+* EZ-Template
+*/
+
+ez::pose ez::Drive::odom_pose_get()
+{
+    return flip({tr_host_odom.x, tr_host_odom.y, tr_host_odom.theta});
+}
+
+void ez::Drive::odom_pose_set(ez::pose pose)
+{
+    pose = flip(pose);
+    tr_host_odom = {pose.x, pose.y, pose.theta};
+}
+
+ez::e_mode ez::Drive::drive_mode_get() { return tr_host_drive_mode; }
+int ez::Drive::drive_velocity_left() { return tr_host_wheel_velocity; }
+int ez::Drive::drive_velocity_right() { return tr_host_wheel_velocity; }
+double ez::Drive::drive_imu_scaler_get() { return 1; }
+double ez::Drive::drive_ratio_get() { return tr_host_drive_ratio; }
+void ez::Drive::drive_ratio_set(double ratio) { tr_host_drive_ratio = ratio; }
+bool ez::Drive::odom_x_direction_get() { return tr_host_flip_x; }
+bool ez::Drive::odom_y_direction_get() { return tr_host_flip_y; }
+bool ez::Drive::odom_theta_direction_get() { return tr_host_flip_theta; }
+
+void ez::tracking_wheel::wheel_diameter_set(double) {}
+double ez::tracking_wheel::wheel_diameter_get() { return 0; }
+
+ez::AutonSelector ez::as::auton_selector;
+ez::AutonSelector::AutonSelector() {}
+ez::Auton::Auton(std::string name, std::function<void()> callback) : Name(name), auton_call(callback) {}
+void ez::AutonSelector::selected_auton_print() {}
+
+/*
+* okapi. Starting the count at one keeps okapi from ever constructing its default logger, so only the symbols it names are defined.
+*/
+
+namespace okapi
+{
+    std::shared_ptr<Logger> defaultLogger;
+    int DefaultLoggerInitializer::count = 1;
+}
+
+extern "C"
+{
+    void _ZN5okapi5TimerC1Ev() {}
+    void _ZN5okapi6LoggerC1ESt10unique_ptrINS_13AbstractTimerESt14default_deleteIS2_EESt17basic_string_viewIcSt11char_traitsIcEERKNS0_8LogLevelE() {}
+    void _ZN5okapi6LoggerD1Ev() {}
+}
+
+/*
+* PROS devices
+*/
+
+namespace pros
+{
+    namespace usd
+    {
+        std::int32_t is_installed() { return 0; }
+    }
+}
+
+pros::v5::Device::Device(std::uint8_t port) : _port(port) {}
+std::uint8_t pros::v5::Device::get_port() const { return _port; }
+bool pros::v5::Device::is_installed() { return true; }
+
+pros::v5::Distance::Distance(std::uint8_t port) : Device(port) {}
+
+std::int32_t pros::v5::Distance::get_distance()
+{
+    int mount = _port - 10;
+    if (mount < 0 || mount > 3) return PROS_ERR;
+
+    float facing = tr_host_truth.theta + 90.0f * mount;
+    float facing_rad = tr_quantity<tr_degree, float>(facing).to<tr_radian>().get();
+    const tr_vector2& offset = distance_offsets[mount];
+    tr_vector2 origin(tr_host_truth.x + offset.x * sinf(facing_rad) + offset.y * cosf(facing_rad),
+                      tr_host_truth.y + offset.x * cosf(facing_rad) - offset.y * sinf(facing_rad));
+    return (std::int32_t)lroundf(tr_quantity<tr_inch, float>(tr_trace_beam(origin, facing).range).to<tr_millimetre>().get());
+}
+
+std::int32_t pros::v5::Distance::get_confidence() { return 63; }
+std::int32_t pros::v5::Distance::get() { return get_distance(); }
+std::int32_t pros::v5::Distance::get_object_size() { return 0; }
+double pros::v5::Distance::get_object_velocity() { return 0; }
+
+std::vector<pros::v5::Imu> pros::v5::Imu::get_all_devices() { return {}; }
+double pros::v5::Imu::get_rotation() const { return tr_host_imu_rotation[_port]; }
+double pros::v5::Imu::get_heading() const { return fmod(fmod(tr_host_imu_rotation[_port], 360.0) + 360.0, 360.0); }
+std::int32_t pros::v5::Imu::set_rotation(const double target) const { tr_host_imu_rotation[_port] = target; return 1; }
+std::int32_t pros::v5::Imu::set_heading(const double target) const { tr_host_imu_rotation[_port] = target; return 1; }
+pros::imu_accel_s_t pros::v5::Imu::get_accel() const { return {0, 0, 1}; }
+std::int32_t pros::v5::Imu::reset(bool) const { return 1; }
+std::int32_t pros::v5::Imu::set_data_rate(std::uint32_t) const { return 1; }
+pros::quaternion_s_t pros::v5::Imu::get_quaternion() const { return {}; }
+pros::euler_s_t pros::v5::Imu::get_euler() const { return {}; }
+double pros::v5::Imu::get_pitch() const { return 0; }
+double pros::v5::Imu::get_roll() const { return 0; }
+double pros::v5::Imu::get_yaw() const { return 0; }
+pros::imu_gyro_s_t pros::v5::Imu::get_gyro_rate() const { return {}; }
+std::int32_t pros::v5::Imu::tare_rotation() const { return set_rotation(0); }
+std::int32_t pros::v5::Imu::tare_heading() const { return set_heading(0); }
+std::int32_t pros::v5::Imu::tare_pitch() const { return 1; }
+std::int32_t pros::v5::Imu::tare_yaw() const { return 1; }
+std::int32_t pros::v5::Imu::tare_roll() const { return 1; }
+std::int32_t pros::v5::Imu::tare() const { return 1; }
+std::int32_t pros::v5::Imu::tare_euler() const { return 1; }
+std::int32_t pros::v5::Imu::set_yaw(const double) const { return 1; }
+std::int32_t pros::v5::Imu::set_pitch(const double) const { return 1; }
+std::int32_t pros::v5::Imu::set_roll(const double) const { return 1; }
+std::int32_t pros::v5::Imu::set_euler(const pros::euler_s_t) const { return 1; }
+pros::ImuStatus pros::v5::Imu::get_status() const { return pros::ImuStatus::ready; }
+bool pros::v5::Imu::is_calibrating() const { return false; }
+pros::imu_orientation_e_t pros::v5::Imu::get_physical_orientation() const { return {}; }
+
+extern "C"
+{
+    double pros::c::imu_get_rotation(uint8_t port) { return tr_host_imu_connected[port] ? tr_host_imu_rotation[port] : PROS_ERR_F; }
+    pros::imu_status_e_t pros::c::imu_get_status(uint8_t port) { return tr_host_imu_connected[port] ? pros::E_IMU_STATUS_READY : pros::E_IMU_STATUS_ERROR; }
+    int32_t pros::c::imu_reset(uint8_t) { return 1; }
+    pros::imu_accel_s_t pros::c::imu_get_accel(uint8_t) { return {0, 0, 1}; }
+
+    // No GPS sensor is plugged in. Tests read GPS fixes from tr_simulated_gps instead.
+    int32_t pros::c::gps_set_offset(uint8_t, double, double) { return 1; }
+    pros::gps_position_s_t pros::c::gps_get_position(uint8_t) { return {PROS_ERR_F, PROS_ERR_F}; }
+    double pros::c::gps_get_heading(uint8_t) { return PROS_ERR_F; }
+    double pros::c::gps_get_error(uint8_t) { return PROS_ERR_F; }
+}
+
+/*
+* PROS RTOS. Tasks are never created and a mutex that is still held after two seconds is reported as a deadlock.
+*/
+
+extern "C"
+{
+    std::uint32_t millis() { return tr_host_time; }
+    void delay(std::uint32_t milliseconds) { tr_host_time += milliseconds; }
+
+    void task_delay_until(std::uint32_t* previous, std::uint32_t period)
+    {
+        *previous += period;
+        if ((int32_t)(*previous - tr_host_time) > 0) tr_host_time = *previous;
+    }
+
+    pros::task_t task_create(pros::task_fn_t, void*, std::uint32_t, std::uint16_t, const char*) { return nullptr; }
+    void task_delete(pros::task_t) {}
+    std::uint32_t task_notify(pros::task_t) { return 0; }
+    std::uint32_t task_notify_take(bool, std::uint32_t) { return 0; }
+}
+
+pros::rtos::Mutex::Mutex() : mutex(new std::timed_mutex, [](void* held) { delete static_cast<std::timed_mutex*>(held); })
+{}
+
+void pros::rtos::Mutex::lock()
+{
+    if (static_cast<std::timed_mutex*>(mutex.get())->try_lock_for(std::chrono::seconds(2))) return;
+    printf("FAIL mutex deadlocked\n");
+    abort();
+}
+
+void pros::rtos::Mutex::unlock()
+{
+    static_cast<std::timed_mutex*>(mutex.get())->unlock();
+}
+
+bool pros::rtos::Mutex::take()
+{
+    lock();
+    return true;
+}
+
+bool pros::rtos::Mutex::give()
+{
+    unlock();
+    return true;
+}
@@ -0,0 +1,87 @@
+/*
+* Host simulation the TitanReset host tests run against.
+*
+* tr_host.cpp stands in for the PROS, EZ-Template and okapi symbols the library links against, so TitanReset runs unchanged
+* on a host. The field is empty apart from its walls. Distance sensors on ports 10 to 13 trace their beams from the true pose
+* of the robot, IMUs read the rotation set for their port, and EZ-Template odometry holds its own pose, which it reports
+* through the flips it is set to. No task is ever created, and time only moves when the library delays.
+*
+* Build and run every test from the project root with tools/tests/run.sh.
+*/
+
+#pragma once
+
+#include "TitanReset/TRSensor.hpp"
+#include "TitanReset/TRDrivebase.hpp"
+#include "EZ-Template/drive/drive.hpp"
+#include <array>
+#include <stdint.h>
+
+/**
+ * Pose of the robot on the field the sensors read, clockwise in degrees from +Y.
+ */
+extern tr_pose tr_host_truth;
+
+/**
+ * Pose EZ-Template odometry holds, in the field frame. odom_pose_get and odom_pose_set pass it through the flips below.
+ */
+extern tr_pose tr_host_odom;
+extern bool tr_host_flip_x;
+extern bool tr_host_flip_y;
+extern bool tr_host_flip_theta;
+
+/**
+ * Motion EZ-Template reports, the velocity of both drive sides in RPM, and its drive ratio.
+ */
+extern ez::e_mode tr_host_drive_mode;
+extern int tr_host_wheel_velocity;
+extern double tr_host_drive_ratio;
+
+/**
+ * Rotation in degrees every IMU port reads, set through either API, and whether the IMU on the port answers.
+ */
+extern double tr_host_imu_rotation[22];
+extern bool tr_host_imu_connected[22];
+
+/**
+ * Time in milliseconds millis reports. Delays move it forward.
+ */
+extern uint32_t tr_host_time;
+
+/**
+ * @brief Distance sensors on the ports and offsets the simulator traces them from, facing north, east, south and west of the robot.
+ */
+struct tr_host_sensors
+{
+    tr_sensor north{tr_vector2(6, 3), 10};
+    tr_sensor east{tr_vector2(4, 1.5), 11};
+    tr_sensor south{tr_vector2(4, 1), 12};
+    tr_sensor west{tr_vector2(7, 2), 13};
+
+    std::array<tr_sensor*, 4> all()
+    {
+        return {&north, &east, &south, &west};
+    }
+};
+
+/**
+ * @brief Gets the EZ-Template drivebase odometry is simulated for. Only its IMU is constructed, on port 1.
+ */
+ez::Drive* tr_host_drive();
+
+/**
+ * @brief Places the robot on the field and odometry at an offset from it, both in the field frame.
+ */
+void tr_host_place(tr_pose truth, double odom_x = 0, double odom_y = 0);
+
+/**
+ * @brief Counts a check and prints it if it failed.
+ * @return Whether the check passed
+ */
+bool tr_host_check(bool passed, const char* what);
+
+/**
+ * @brief Prints the amount of checks and failures.
+ * @return Exit code of the test, 0 if every check passed
+ */
+int tr_host_report(const char* test);
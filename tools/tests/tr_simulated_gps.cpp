@@ -0,0 +1,74 @@
+#include "tr_simulated_gps.hpp"
+#include "TitanReset/TRAngle.hpp"
+#include "TitanReset/TRUnits.hpp"
+#include "TitanReset/TRWalls.hpp"
+#include <math.h>
+
+/**
+ * @brief Position of a point offset from the center of the robot, with X to the right of the robot and Y ahead of it. The same as tr_gps takes the mounting out with.
+ */
+static tr_vector2 tr_mount_point(tr_vector2 center, tr_vector2 offset, float heading)
+{
+    float heading_rad = tr_quantity<tr_degree, float>(heading).to<tr_radian>().get();
+    float heading_sin = sinf(heading_rad);
+    float heading_cos = cosf(heading_rad);
+    return tr_vector2(center.x + offset.x * heading_cos + offset.y * heading_sin, center.y - offset.x * heading_sin + offset.y * heading_cos);
+}
+
+tr_simulated_gps::tr_simulated_gps(tr_vector2 offset, float yaw, int field_rotation, uint32_t seed) :
+            offset(offset),
+            yaw(yaw),
+            field_rotation((field_rotation % 4 + 4) % 4),
+            pose(),
+            error(0),
+            reported(0),
+            connected(true),
+            noise_state(seed != 0 ? seed : 1)
+{}
+
+void tr_simulated_gps::set_pose(tr_vector3 new_pose)
+{
+    pose = new_pose;
+}
+
+void tr_simulated_gps::set_error(float new_error, float new_reported)
+{
+    error = new_error;
+    reported = new_reported;
+}
+
+void tr_simulated_gps::set_connected(bool new_connected)
+{
+    connected = new_connected;
+}
+
+tr_gps_reading tr_simulated_gps::read(void* param)
+{
+    tr_simulated_gps* self = static_cast<tr_simulated_gps*>(param);
+
+    tr_gps_reading reading = {};
+    reading.valid = self->connected;
+    if (!reading.valid) return reading;
+
+    // The field code frame is the field frame turned back by the field rotation.
+    tr_vector2 sensor = tr_mount_point(tr_vector2(self->pose.x, self->pose.y), self->offset, self->pose.z);
+    tr_vector2d code = tr_turn_quarters(sensor.x, sensor.y, (4 - self->field_rotation) % 4);
+    reading.position = tr_vector2(code.x + self->error * self->gaussian(), code.y + self->error * self->gaussian());
+    reading.heading = tr_angle::from_degrees(self->pose.z + self->yaw - 90.0f * self->field_rotation).to_degrees();
+    reading.error = self->reported;
+    return reading;
+}
+
+float tr_simulated_gps::gaussian()
+{
+    // Xorshift for the uniform samples and Box-Muller for the normal one, so the noise is the same on every host.
+    float uniform[2];
+    for (float& sample : uniform)
+    {
+        noise_state ^= noise_state << 13;
+        noise_state ^= noise_state >> 17;
+        noise_state ^= noise_state << 5;
+        sample = ((noise_state >> 8) + 0.5f) / 16777216.0f;
+    }
+    return sqrtf(-2.0f * logf(uniform[0])) * cosf(2.0f * (float)M_PI * uniform[1]);
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "TitanReset/TRGps.hpp"
+#include <stdint.h>
+
+/**
+ * @brief GPS backend reporting from a pose set by a test, so the GPS fusion can be run on a host without a V5 brain.
+ *
+ * The reading is what a sensor with the given mounting would report at the pose, with gaussian noise of the given error on each axis.
+ * Pass read with the simulator as the parameter to tr_gps.
+ */
+class tr_simulated_gps
+{
+public:
+
+    /**
+     * @param offset offset of the simulated sensor, with X to the right of the robot and Y ahead of it
+     * @param yaw mounting yaw in degrees
+     * @param field_rotation quarter turns clockwise from the frame of the field code to the field frame
+     * @param seed seed of the noise
+     */
+    tr_simulated_gps(tr_vector2 offset, float yaw = 0, int field_rotation = 0, uint32_t seed = 1);
+
+    /**
+     * @brief Sets the pose of the robot in the field frame the next readings are taken at.
+     */
+    void set_pose(tr_vector3 pose);
+
+    /**
+     * @brief Sets the error of the readings.
+     * @param error standard deviation of the noise on each axis in inches
+     * @param reported error the readings report in inches, which a real sensor does not always get right
+     */
+    void set_error(float error, float reported);
+
+    /**
+     * @brief Sets whether the sensor answers.
+     */
+    void set_connected(bool connected);
+
+    static tr_gps_reading read(void* param);
+
+private:
+
+    /**
+     * @brief Draws a standard normal sample.
+     */
+    float gaussian();
+
+    tr_vector2 offset;
+    float yaw;
+    int field_rotation;
+
+    tr_vector3 pose;
+    float error;
+    float reported;
+    bool connected;
+
+    uint32_t noise_state;
+};
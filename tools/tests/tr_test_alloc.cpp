@@ -0,0 +1,148 @@
+/*
+* Heap use of the paths marked TR_NO_ALLOC.
+*
+* The global operator new is replaced with a counting one, which the Linux linker lets a program do, and every hot path the
+* V5 runs in a loop is called repeatedly from a steady state. None of them may allocate: resets with and without the trust policy,
+* position calculations, the batched and scalar beam transforms, the pose tracker, the event detector, the IMU fusion and the
+* field map.
+*
+* Built and run by tools/tests/run.sh.
+*/
+
+#include "tr_host.hpp"
+#include "TitanReset/TRChassis.hpp"
+#include "TitanReset/TRBeams.hpp"
+#include "TitanReset/TRPoseTracker.hpp"
+#include "TitanReset/TRFieldMap.hpp"
+#include "liblvgl/lvgl.h"
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+
+static uint32_t allocation_count = 0;
+
+void* operator new(size_t size)
+{
+    allocation_count++;
+    void* ptr = malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+// Kept out of line, so the compiler pairs the replaced operators with each other rather than seeing free called on memory from operator new.
+__attribute__((noinline)) void operator delete(void* ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    operator delete(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    operator delete(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept
+{
+    operator delete[](ptr);
+}
+
+/*
+* The field map is only rendered off-screen, so its LVGL calls are never made.
+*/
+extern "C"
+{
+    lv_obj_t* lv_canvas_create(lv_obj_t*) { return nullptr; }
+    void lv_canvas_set_buffer(lv_obj_t*, void*, lv_coord_t, lv_coord_t, lv_img_cf_t) {}
+    void lv_obj_set_pos(lv_obj_t*, lv_coord_t, lv_coord_t) {}
+    void lv_obj_invalidate(const lv_obj_t*) {}
+    void lv_obj_invalidate_area(const lv_obj_t*, const lv_area_t*) {}
+    void lv_obj_get_coords(const lv_obj_t*, lv_area_t*) {}
+}
+
+/**
+ * Times each path is run. The first run may set up statics, so the path is run once before counting.
+ */
+static constexpr int runs = 100;
+
+template<typename Path>
+static void check_no_alloc(const char* name, Path path)
+{
+    path();
+    uint32_t start = allocation_count;
+    for (int i = 0; i < runs; i++) path();
+
+    char message[96];
+    snprintf(message, sizeof(message), "%s made %u allocation(s)", name, (unsigned)(allocation_count - start));
+    tr_host_check(allocation_count == start, message);
+}
+
+int main()
+{
+    // The counting operator new has to be the one the library calls.
+    uint32_t before = allocation_count;
+    delete new int(1);
+    if (!tr_host_check(allocation_count == before + 1, "operator new hooked")) return tr_host_report("tr_test_alloc");
+
+    tr_host_sensors sensors;
+    ez::Drive* drive = tr_host_drive();
+    tr_chassis chassis(&drive->imu, drive, sensors.all(), {1.0, 12.0});
+    tr_host_place({-60, -40, 10}, 2, -1);
+
+    check_no_alloc("perform_dsr", [&] {
+        tr_host_odom.x = tr_host_truth.x + 2;
+        chassis.perform_dsr();
+    });
+    check_no_alloc("perform_dsr_quad", [&] { chassis.perform_dsr_quad(NEG_NEG); });
+    check_no_alloc("perform_dsr_init", [&] { chassis.perform_dsr_init(NEG_NEG, 10); });
+    check_no_alloc("get_position_calculation", [&] { chassis.get_position_calculation(NEG_NEG, 10); });
+
+    // A rejected reset returns early, which has to be just as free.
+    check_no_alloc("rejected perform_dsr", [&] {
+        tr_host_odom.x = tr_host_truth.x + 30;
+        chassis.perform_dsr();
+    });
+
+    float readings[4] = {12, 40, 30, 8};
+    float parallel[4] = {6, 4, 4, 7};
+    float perpendicular[4] = {3, 1.5, 1, 2};
+    float out[4];
+    check_no_alloc("tr_beam_transform", [&] { tr_beam_transform(3.5f, readings, parallel, perpendicular, out); });
+    check_no_alloc("tr_beam_transform_scalar", [&] { tr_beam_transform_scalar(3.5f, readings, parallel, perpendicular, out); });
+
+    tr_pose_tracker tracker(&chassis);
+    tracker.reset(5);
+    check_no_alloc("tr_pose_tracker::update", [&] { tracker.update(); });
+
+    tr_event_detector& detector = chassis.get_event_detector();
+    tr_event_sample sample = {};
+    sample.has_innovation = true;
+    sample.valid = true;
+    sample.variance = tr_vector2(0.25, 0.25);
+    check_no_alloc("tr_event_detector::update", [&] {
+        sample.time += 10;
+        detector.update(sample);
+    });
+
+    tr_imu_fusion fusion({1, 2, 3});
+    check_no_alloc("tr_imu_fusion::update", [&] {
+        for (int port = 1; port <= 3; port++) tr_host_imu_rotation[port] += 0.5;
+        fusion.update();
+    });
+
+    static tr_field_map map(tr_vector2(18, 18));
+    check_no_alloc("tr_field_map::update", [&] {
+        chassis.perform_dsr();
+        map.update(&chassis);
+    });
+
+    return tr_host_report("tr_test_alloc");
+}
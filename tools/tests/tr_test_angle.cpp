@@ -0,0 +1,116 @@
+/*
+* Wrapping of the binary angle.
+*
+* Every raw angle is converted to degrees and back, wound up by whole turns in both directions and compared against the same
+* conversion done in double precision. The signed degrees, the error to the nearest square heading and the quadrant are checked
+* for every raw angle, and NaN, infinite and huge headings have to give a defined angle.
+*
+* Built and run by tools/tests/run.sh.
+*/
+
+#include "tr_host.hpp"
+#include "TitanReset/TRAngle.hpp"
+#include <math.h>
+#include <stdio.h>
+
+/**
+ * Whole turns of wind-up each raw angle is checked at, in both directions.
+ */
+static constexpr int wind_up_turns = 64;
+
+/**
+ * @brief Distance between two raw angles in units, across the wrap.
+ */
+static int raw_distance(uint16_t a, uint16_t b)
+{
+    return abs((int16_t)(uint16_t)(a - b));
+}
+
+/**
+ * @brief The raw angle a heading should give, worked out in double precision from the float that was actually passed.
+ */
+static uint16_t expected_raw(float degrees)
+{
+    return (uint16_t)llrint(fmod((double)degrees, 360.0) * (tr_angle::turn / 360.0));
+}
+
+/**
+ * @brief Checks a run of conversions and reports the first failure only, so an off by one does not print a million lines.
+ */
+static bool check_all(bool& passed, bool condition, const char* what, int raw, float degrees)
+{
+    if (passed && !condition)
+    {
+        char message[128];
+        snprintf(message, sizeof(message), "%s, raw %d, degrees %.6f", what, raw, degrees);
+        tr_host_check(false, message);
+        passed = false;
+    }
+    return condition;
+}
+
+int main()
+{
+    bool round_trip = true;
+    bool wound = true;
+    bool signed_degrees = true;
+    bool square = true;
+    bool quadrant = true;
+
+    for (int raw = 0; raw < tr_angle::turn; raw++)
+    {
+        tr_angle angle = tr_angle::from_raw((uint16_t)raw);
+        float degrees = angle.to_degrees();
+        check_all(round_trip, degrees >= 0 && degrees < 360 && tr_angle::from_degrees(degrees) == angle, "degrees round trip", raw, degrees);
+
+        // Wound up headings are compared against double precision, which is only off by the rounding of the float product.
+        for (int turns = -wind_up_turns; turns <= wind_up_turns; turns++)
+        {
+            float heading = degrees + 360.0f * turns;
+            check_all(wound, raw_distance(tr_angle::from_degrees(heading).get_raw(), expected_raw(heading)) <= 1, "wound up heading", raw, heading);
+        }
+
+        float signed_value = angle.to_signed_degrees();
+        float signed_expected = raw < tr_angle::turn / 2 ? degrees : degrees - 360.0f;
+        check_all(signed_degrees, signed_value == signed_expected && tr_angle::from_degrees(signed_value) == angle, "signed degrees", raw, signed_value);
+
+        // The error is to the nearest multiple of 90 degrees, so taking it off has to land on a square heading.
+        int error = angle.square_error();
+        uint16_t squared = (uint16_t)(raw - error);
+        check_all(square, error >= -tr_angle::eighth && error < tr_angle::eighth && squared % tr_angle::quarter == 0, "square error", raw, degrees);
+        check_all(square, fabsf(angle.square_error_degrees() - error * (360.0f / tr_angle::turn)) < 1e-4f, "square error degrees", raw, degrees);
+
+        // Boundaries belong to the lower quadrant.
+        int expected_quadrant = raw == 0 ? 0 : ((raw - 1 + tr_angle::eighth) % tr_angle::turn) / tr_angle::quarter;
+        check_all(quadrant, (int)angle.quadrant() == expected_quadrant, "quadrant", raw, degrees);
+    }
+
+    tr_host_check(tr_angle::from_degrees(45).quadrant() == POS_POS && tr_angle::from_degrees(45.01f).quadrant() == NEG_POS, "45 degrees belongs to POS_POS");
+    tr_host_check(tr_angle::from_degrees(135).quadrant() == NEG_POS && tr_angle::from_degrees(-45).quadrant() == POS_NEG, "quadrant boundaries");
+
+    // Large multiples of a turn have to land on the heading the float holds, where multiplying first lost it.
+    tr_host_check(tr_angle::from_degrees(360.0f * 1000000) == tr_angle(), "a million turns");
+    tr_host_check(tr_angle::from_degrees(-360.0f * 4096 + 90) == tr_angle::from_raw(tr_angle::quarter), "4096 turns back and a quarter");
+    tr_host_check(tr_angle::from_degrees(360.0f * 4096 + 180) == tr_angle::from_raw(tr_angle::turn / 2), "4096 turns and a half");
+    tr_host_check(raw_distance(tr_angle::from_degrees(1e30f).get_raw(), expected_raw(1e30f)) <= 1, "huge heading");
+    tr_host_check(raw_distance(tr_angle::from_degrees(-1e30f).get_raw(), expected_raw(-1e30f)) <= 1, "huge negative heading");
+    tr_host_check(tr_angle::from_degrees(3.4e38f).get_raw() == expected_raw(3.4e38f), "largest float heading");
+
+    // Headings that are not numbers give 0 instead of an undefined conversion.
+    tr_host_check(tr_angle::from_degrees(NAN) == tr_angle(), "NaN heading");
+    tr_host_check(tr_angle::from_degrees(INFINITY) == tr_angle(), "infinite heading");
+    tr_host_check(tr_angle::from_degrees(-INFINITY) == tr_angle(), "negative infinite heading");
+
+    // Differences wrap across zero both ways.
+    bool differences = true;
+    for (int raw = 0; raw < tr_angle::turn; raw += 7)
+    {
+        tr_angle angle = tr_angle::from_raw((uint16_t)raw);
+        tr_angle step = tr_angle::from_degrees(10);
+        check_all(differences, (angle + step) - step == angle && (angle - step) + step == angle, "sum and difference wrap", raw, angle.to_degrees());
+        check_all(differences, fabsf(((angle + step) - angle).to_signed_degrees() - 10) < 0.01f, "difference across the wrap", raw, angle.to_degrees());
+    }
+
+    tr_host_check(round_trip && wound && signed_degrees && square && quadrant && differences, "every raw angle");
+    return tr_host_report("tr_test_angle");
+}
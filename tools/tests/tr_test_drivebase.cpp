@@ -0,0 +1,121 @@
+/*
+* Drivebase adapters.
+*
+* Poses have to round trip through every adapter tr_drivebase holds, with and without a mirror, in double precision. An adapter
+* written outside of TitanReset is held inline and has to drive a full reset of a tr_chassis.
+*
+* Built and run by tools/tests/run.sh.
+*/
+
+#include "tr_host.hpp"
+#include "TitanReset/TRChassis.hpp"
+#include "TitanReset/TRDrivebase.hpp"
+#include <math.h>
+#include <stdio.h>
+
+/**
+ * Pose odometry keeps in centimetres with a counterclockwise heading in radians, as a team's own odometry might.
+ */
+struct metric_pose
+{
+    double x_cm;
+    double y_cm;
+    double heading_rad;
+};
+
+/**
+ * Adapter for metric_pose written the way a team would, outside of TitanReset.
+ */
+struct metric_drivebase
+{
+    metric_pose* pose;
+
+    tr_pose get_pose() const
+    {
+        return {pose->x_cm / 2.54, pose->y_cm / 2.54, -pose->heading_rad * 180.0 / M_PI};
+    }
+
+    void set_pose(tr_pose new_pose) const
+    {
+        *pose = {new_pose.x * 2.54, new_pose.y * 2.54, -new_pose.theta * M_PI / 180.0};
+    }
+};
+
+static_assert(tr_drivebase_adapter<metric_drivebase>);
+
+/**
+ * Pose kept in the simulated EZ-Template odometry, through the virtual interface.
+ */
+class generic_drivebase : public tr_drivebase_generic
+{
+public:
+    tr_vector3 getPose() override
+    {
+        return tr_vector3(tr_host_odom.x, tr_host_odom.y, tr_host_odom.theta);
+    }
+
+    void setPose(tr_vector3 pose) override
+    {
+        tr_host_odom = {pose.x, pose.y, pose.z};
+    }
+};
+
+static bool same_pose(tr_pose a, tr_pose b, double tolerance)
+{
+    return fabs(a.x - b.x) < tolerance && fabs(a.y - b.y) < tolerance && fabs(a.theta - b.theta) < tolerance;
+}
+
+/**
+ * @brief Sets a pose through a drivebase and reads it back, plain and through a mirror.
+ */
+static void check_round_trip(tr_drivebase base, tr_drivebase_kind kind, double tolerance, const char* name)
+{
+    char message[96];
+    snprintf(message, sizeof(message), "%s kind", name);
+    tr_host_check(base.get_kind() == kind, message);
+
+    // A pose with more digits than a float holds has to come back in double precision.
+    tr_pose pose = {-47.123456789, 31.987654321, 123.456789012};
+    base.set_pose(pose);
+    snprintf(message, sizeof(message), "%s round trip", name);
+    tr_host_check(same_pose(base.get_pose(), pose, tolerance), message);
+
+    base.set_mirror(tr_mirror(true, false, true));
+    base.set_pose(pose);
+    snprintf(message, sizeof(message), "%s mirrored round trip", name);
+    tr_host_check(same_pose(base.get_pose(), pose, tolerance), message);
+    base.set_mirror(tr_mirror());
+    snprintf(message, sizeof(message), "%s mirrored into its own frame", name);
+    tr_host_check(same_pose(base.get_pose(), {-pose.x, pose.y, -pose.theta}, tolerance), message);
+}
+
+int main()
+{
+    ez::Drive* drive = tr_host_drive();
+    tr_pose plain = {0, 0, 0};
+    metric_pose metric = {0, 0, 0};
+    generic_drivebase generic;
+
+    check_round_trip(drive, DRIVEBASE_EZ, 1e-9, "ez::Drive");
+    check_round_trip(tr_ez_drivebase{drive}, DRIVEBASE_EZ, 1e-9, "tr_ez_drivebase");
+    check_round_trip(&plain, DRIVEBASE_STRUCT, 1e-9, "tr_pose");
+    check_round_trip(&generic, DRIVEBASE_VIRTUAL, 1e-4, "tr_drivebase_generic");
+    check_round_trip(metric_drivebase{&metric}, DRIVEBASE_CUSTOM, 1e-9, "custom adapter");
+    check_round_trip(tr_struct_drivebase{&plain}, DRIVEBASE_CUSTOM, 1e-9, "tr_struct_drivebase as an adapter");
+
+    // Only EZ-Template reports its motions, however it is passed.
+    tr_host_drive_mode = ez::DISABLE;
+    tr_host_wheel_velocity = 0;
+    tr_host_check(tr_drivebase(tr_ez_drivebase{drive}).is_stopped(), "EZ adapter reports stopped");
+    tr_host_check(!tr_drivebase(metric_drivebase{&metric}).is_stopped(), "custom adapter never reports stopped");
+
+    // The custom adapter is all a chassis needs to reset.
+    tr_host_sensors sensors;
+    tr_chassis chassis(&drive->imu, metric_drivebase{&metric}, sensors.all());
+    tr_host_place({-60, -40, 0});
+    metric = {(-60 + 2) * 2.54, (-40 - 1.5) * 2.54, 0};
+    tr_dsr_result result = chassis.perform_dsr();
+    tr_host_check(result.applied && fabs(metric.x_cm / 2.54 + 60) < 0.3 && fabs(metric.y_cm / 2.54 + 40) < 0.3, "reset through a custom adapter");
+
+    return tr_host_report("tr_test_drivebase");
+}
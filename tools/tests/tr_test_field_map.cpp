@@ -0,0 +1,144 @@
+/*
+* Off-screen rendering of the field map.
+*
+* Frames are rendered into the off-screen buffer and compared against the empty field: the overlay has to land where the poses
+* and beams are, be erased when the robot moves, and only ever change pixels inside the region render reports. Poses far off
+* the field and NaN have to be clamped. update(tr_chassis*) has to draw the last applied reset without calculating a new one.
+*
+* Built and run by tools/tests/run.sh.
+*/
+
+#include "tr_host.hpp"
+#include "TitanReset/TRChassis.hpp"
+#include "TitanReset/TRFieldMap.hpp"
+#include "liblvgl/lvgl.h"
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+/*
+* The canvas only needs the few LVGL calls the field map makes, which record the area it invalidates.
+*/
+
+static lv_obj_t* canvas_object = reinterpret_cast<lv_obj_t*>(1);
+static lv_area_t invalidated = {0, 0, -1, -1};
+
+extern "C"
+{
+    lv_obj_t* lv_canvas_create(lv_obj_t*) { return canvas_object; }
+    void lv_canvas_set_buffer(lv_obj_t*, void*, lv_coord_t, lv_coord_t, lv_img_cf_t) {}
+    void lv_obj_set_pos(lv_obj_t*, lv_coord_t, lv_coord_t) {}
+    void lv_obj_invalidate(const lv_obj_t*) {}
+    void lv_obj_invalidate_area(const lv_obj_t*, const lv_area_t* area) { invalidated = *area; }
+
+    void lv_obj_get_coords(const lv_obj_t*, lv_area_t* coords)
+    {
+        *coords = {140, 20, 140 + tr_field_map::size - 1, 20 + tr_field_map::size - 1};
+    }
+}
+
+static constexpr int pixel_count = tr_field_map::size * tr_field_map::size;
+static uint32_t blank[pixel_count];
+
+static uint32_t pixel_at(const tr_field_map& map, float x, float y)
+{
+    return map.get_buffer()[tr_field_map::to_px_y(y) * tr_field_map::size + tr_field_map::to_px_x(x)];
+}
+
+static bool blank_at(const tr_field_map& map, float x, float y)
+{
+    return pixel_at(map, x, y) == blank[tr_field_map::to_px_y(y) * tr_field_map::size + tr_field_map::to_px_x(x)];
+}
+
+/**
+ * @brief Whether every pixel outside of an area still shows the empty field.
+ */
+static bool blank_outside(const tr_field_map& map, tr_rect area)
+{
+    for (int y = 0; y < tr_field_map::size; y++)
+    {
+        for (int x = 0; x < tr_field_map::size; x++)
+        {
+            bool inside = !area.empty() && x >= area.x1 && x <= area.x2 && y >= area.y1 && y <= area.y2;
+            if (!inside && map.get_buffer()[y * tr_field_map::size + x] != blank[y * tr_field_map::size + x]) return false;
+        }
+    }
+    return true;
+}
+
+static tr_field_frame make_frame(tr_vector3 pose, int sensors, float beam_length)
+{
+    tr_field_frame frame;
+    frame.odom_pose = pose;
+    frame.dsr_pose = pose;
+    frame.active_sensors = sensors;
+    for (float& length : frame.beam_lengths) length = beam_length;
+    return frame;
+}
+
+int main()
+{
+    static tr_field_map map(tr_vector2(18, 18));
+    memcpy(blank, map.get_buffer(), sizeof(blank));
+
+    // The field is drawn with its walls on the edges of the canvas.
+    tr_host_check(tr_field_map::to_px_x(-wall_coord) == 0 && tr_field_map::to_px_x(wall_coord) == tr_field_map::size - 1, "walls on the edges along X");
+    tr_host_check(tr_field_map::to_px_y(wall_coord) == 0 && tr_field_map::to_px_y(-wall_coord) == tr_field_map::size - 1, "walls on the edges along Y");
+    tr_host_check(blank[0] != blank[tr_field_map::size + 1], "wall drawn over the field");
+
+    // Active beams are drawn from the dsr pose, inactive ones are not.
+    tr_rect changed = map.render(make_frame(tr_vector3(-30, -30, 0), NORTH | EAST, 25));
+    tr_host_check(!changed.empty() && blank_outside(map, changed), "first frame stays inside its region");
+    tr_host_check(!blank_at(map, -30, -30), "dsr pose drawn");
+    tr_host_check(!blank_at(map, -30, -30 + 20), "north beam drawn");
+    tr_host_check(!blank_at(map, -30 + 20, -30), "east beam drawn");
+    tr_host_check(blank_at(map, -30, -30 - 20), "south beam not drawn");
+    tr_host_check(blank_at(map, -30 - 20, -30), "west beam not drawn");
+
+    // Moving the robot erases the old overlay.
+    changed = map.render(make_frame(tr_vector3(30, 30, 90), NORTH, 25));
+    tr_host_check(changed.x1 <= tr_field_map::to_px_x(-30) && changed.y2 >= tr_field_map::to_px_y(-30), "changed region covers the old overlay");
+    tr_host_check(blank_at(map, -30, -30) && blank_at(map, -30, -30 + 20), "old overlay erased");
+    tr_host_check(!blank_at(map, 30 + 20, 30), "beam turned with the robot");
+    tr_host_check(blank_outside(map, changed), "second frame stays inside its region");
+
+    // Coordinates far off the field and NaN are clamped before the cast, so the rasterizer stays bounded.
+    tr_host_check(tr_field_map::to_px_x(1e9f) == 2 * tr_field_map::size && tr_field_map::to_px_y(1e9f) == -tr_field_map::size, "far coordinates clamped");
+    tr_host_check(tr_field_map::to_px_x(NAN) == -tr_field_map::size, "NaN clamped");
+    auto start = std::chrono::steady_clock::now();
+    tr_field_frame far = make_frame(tr_vector3(1e9f, -1e9f, 45), NORTH | EAST | SOUTH | WEST, 1e7f);
+    far.dsr_pose = tr_vector3(NAN, NAN, NAN);
+    changed = map.render(far);
+    double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    tr_host_check(elapsed < 50, "far off-field frame renders quickly");
+    tr_host_check(changed.x1 >= 0 && changed.y1 >= 0 && changed.x2 < tr_field_map::size && changed.y2 < tr_field_map::size, "changed region clipped to the canvas");
+    map.render(make_frame(tr_vector3(30, 30, 90), 0, -1));
+
+    // Updating from a chassis draws the last applied reset and leaves the state of the chassis alone.
+    tr_host_sensors sensors;
+    ez::Drive* drive = tr_host_drive();
+    tr_chassis chassis(&drive->imu, drive, sensors.all());
+    map.create(nullptr, 140, 20);
+
+    tr_host_place({-60, -40, 0}, 3, 2);
+    map.update(&chassis);
+    tr_host_check(!blank_at(map, -57, -38) && blank_at(map, -60, -40 + 20), "before a reset the dsr pose follows odometry without beams");
+    tr_host_check(invalidated.x1 >= 140 && invalidated.y1 >= 20 && invalidated.x2 < 140 + tr_field_map::size, "changed region invalidated on the screen");
+
+    tr_dsr_result result = chassis.perform_dsr();
+    tr_host_check(result.applied, "reset applied");
+    int used[4] = {chassis.is_sensor_used(NORTH), chassis.is_sensor_used(EAST), chassis.is_sensor_used(SOUTH), chassis.is_sensor_used(WEST)};
+    tr_beam_quality quality = chassis.get_beam_quality(0);
+
+    // Facing east puts other beams on the walls, which a fresh calculation would switch the chassis to.
+    tr_host_place({-60, -40, 90}, 5, 5);
+    map.update(&chassis);
+    bool unchanged = true;
+    for (int i = 0; i < 4; i++) unchanged = unchanged && chassis.is_sensor_used(1 << i) == used[i];
+    tr_host_check(unchanged && chassis.get_beam_quality(0).variance == quality.variance, "update leaves the sensors of the chassis alone");
+    tr_host_check(!blank_at(map, -60, -40), "last reset pose drawn");
+    tr_host_check(!blank_at(map, -60, -40 - 12), "beam of the last reset drawn from its pose");
+
+    return tr_host_report("tr_test_field_map");
+}
@@ -0,0 +1,138 @@
+/*
+* GPS fusion against a simulated GPS sensor.
+*
+* A fix has to land back on the pose it was simulated at for every mounting and field rotation. Mid-field, where the beams cannot
+* reset, the fix is used alone with a confidence from its reported error, so the trust policy can turn down a poor one. Near a wall
+* a fix that agrees with the beams is fused in and one that does not is gated out, and a missing or poor fix leaves the beams alone.
+* The counters of the GPS only move for resets the trust policy applied.
+*
+* Built and run by tools/tests/run.sh.
+*/
+
+#include "tr_host.hpp"
+#include "tr_simulated_gps.hpp"
+#include "TitanReset/TRAngle.hpp"
+#include "TitanReset/TRChassis.hpp"
+#include <math.h>
+
+/**
+ * @brief Places the robot, odometry and the simulated sensor, odometry at an offset from the others.
+ */
+static void place(tr_simulated_gps& sim, tr_pose truth, double odom_x, double odom_y)
+{
+    tr_host_place(truth, odom_x, odom_y);
+    sim.set_pose(tr_vector3(truth.x, truth.y, truth.theta));
+}
+
+static bool counted(const tr_gps& gps, uint32_t fused, uint32_t alone, uint32_t gated)
+{
+    return gps.get_fused() == fused && gps.get_alone() == alone && gps.get_gated() == gated;
+}
+
+int main()
+{
+    // Every mounting, field rotation and heading round trips through the simulator.
+    bool round_trip = true;
+    for (int rotation = -1; rotation < 5; rotation++)
+    {
+        for (float yaw : {0.0f, 90.0f, 180.0f, -37.0f})
+        {
+            for (float heading = 0; heading < 360; heading += 23)
+            {
+                tr_simulated_gps sim(tr_vector2(3, -5), yaw, rotation);
+                tr_gps gps(tr_simulated_gps::read, &sim, tr_vector2(3, -5), yaw, rotation);
+                sim.set_pose(tr_vector3(12.5, -40, heading));
+                sim.set_error(0, 0.01f);
+
+                tr_gps_fix fix;
+                bool measured = gps.measure(heading, fix);
+                float heading_error = (tr_angle::from_degrees(fix.heading) - tr_angle::from_degrees(heading)).to_signed_degrees();
+                round_trip = round_trip && measured && fabsf(fix.position.x - 12.5f) < 1e-3f && fabsf(fix.position.y + 40) < 1e-3f && fabsf(heading_error) < 0.012f &&
+                             fix.variance == tr_gps::min_error * tr_gps::min_error && fix.confidence == 1;
+            }
+        }
+    }
+    tr_host_check(round_trip, "frame round trip");
+
+    // The confidence of a fix falls with the error it reports.
+    {
+        tr_simulated_gps sim(tr_vector2(0, 0));
+        tr_gps gps(tr_simulated_gps::read, &sim, tr_vector2(0, 0));
+        tr_gps_fix fix;
+        sim.set_error(0, 2.0f);
+        tr_host_check(gps.measure(0, fix) && fabsf(fix.confidence - tr_gps::min_error / 2.0f) < 1e-6f && fix.variance == 4.0f, "confidence from error");
+    }
+
+    tr_host_sensors sensors;
+    ez::Drive* drive = tr_host_drive();
+    tr_chassis chassis(&drive->imu, drive, sensors.all(), {1.0, 12.0});
+    tr_simulated_gps sim(tr_vector2(0, -6), 180, 1, 7);
+    tr_gps gps(tr_simulated_gps::read, &sim, tr_vector2(0, -6), 180, 1);
+
+    // Mid-field at a steep heading the beams cannot reset, the GPS alone can.
+    place(sim, {10, 5, 40}, 3, -2);
+    sim.set_error(0.3f, 0.5f);
+    tr_dsr_result result = chassis.perform_dsr();
+    tr_host_check(!result.applied, "beams alone fail mid-field");
+
+    chassis.set_gps(&gps);
+    place(sim, {10, 5, 40}, 3, -2);
+    result = chassis.perform_dsr();
+    tr_host_check(result.applied && result.sensors_used == GPS_SENSOR && result.confidence == 1, "GPS alone mid-field");
+    tr_host_check(fabs(tr_host_odom.x - 10) < 1.5 && fabs(tr_host_odom.y - 5) < 1.5 && counted(gps, 0, 1, 0), "GPS alone pose");
+
+    // Near a wall and square, a fix that agrees is fused in and shrinks the variance.
+    chassis.set_gps(nullptr);
+    place(sim, {-60, -40, 0}, 2, 1);
+    tr_dsr_result beams = chassis.perform_dsr();
+    tr_host_check(beams.applied, "beams alone near wall");
+
+    chassis.set_gps(&gps);
+    place(sim, {-60, -40, 0}, 2, 1);
+    sim.set_error(0.5f, 1.0f);
+    result = chassis.perform_dsr();
+    tr_host_check(result.applied && result.sensors_used == (beams.sensors_used | GPS_SENSOR) && result.variance.x < beams.variance.x &&
+                  result.variance.y < beams.variance.y && counted(gps, 1, 1, 0), "fused near wall");
+    tr_host_check(fabs(tr_host_odom.x + 60) < 1 && fabs(tr_host_odom.y + 40) < 1, "fused pose");
+
+    // A fix far from the beams is gated out and the beams reset alone.
+    place(sim, {-60, -40, 0}, 2, 1);
+    sim.set_pose(tr_vector3(-50, -40, 0));
+    sim.set_error(0, 1.0f);
+    result = chassis.perform_dsr();
+    tr_host_check(result.applied && result.sensors_used == beams.sensors_used && fabsf(result.correction.x - beams.correction.x) < 1e-3f && counted(gps, 1, 1, 1),
+                  "gated");
+
+    // No fix leaves the beams alone, and a fix reporting more than max_error counts as none.
+    place(sim, {-60, -40, 0}, 2, 1);
+    sim.set_connected(false);
+    result = chassis.perform_dsr();
+    tr_host_check(result.applied && result.sensors_used == beams.sensors_used && counted(gps, 1, 1, 1), "unplugged");
+
+    sim.set_connected(true);
+    sim.set_error(0, 10);
+    place(sim, {10, 5, 40}, 3, -2);
+    result = chassis.perform_dsr();
+    tr_host_check(!result.applied && counted(gps, 1, 1, 1), "large error not used");
+
+    // The trust policy still bounds a fix used alone, and a rejected reset is not counted.
+    sim.set_error(0.3f, 0.5f);
+    place(sim, {10, 5, 40}, 20, 0);
+    result = chassis.perform_dsr();
+    tr_host_check(!result.applied && result.rejection == REJECT_CORRECTION_TOO_LARGE && counted(gps, 1, 1, 1), "trust policy");
+
+    // With a minimum confidence, a fix used alone has to report an error small enough to meet it.
+    tr_chassis cautious(&drive->imu, drive, sensors.all(), {0.5, 12.0});
+    cautious.set_gps(&gps);
+    place(sim, {10, 5, 40}, 3, -2);
+    sim.set_error(0.3f, 2.0f);
+    result = cautious.perform_dsr();
+    tr_host_check(!result.applied && result.rejection == REJECT_LOW_CONFIDENCE && counted(gps, 1, 1, 1), "poor fix below the minimum confidence");
+
+    place(sim, {10, 5, 40}, 3, -2);
+    sim.set_error(0.3f, 0.5f);
+    result = cautious.perform_dsr();
+    tr_host_check(result.applied && result.sensors_used == GPS_SENSOR && counted(gps, 1, 2, 1), "good fix meets the minimum confidence");
+
+    return tr_host_report("tr_test_gps");
+}
@@ -0,0 +1,88 @@
+/*
+* Writes into the drivebase IMU the IMU fusion writes into.
+*
+* The fusion writes its rotation into the IMU of an EZ-Template drivebase every period. When something else writes into that IMU, as
+* EZ-Template does when it resets or sets its heading, the fused rotation has to continue from the written value without rejecting
+* the unit, whether the drivebase IMU is one of the fused units, is not fused, or is the only unit. A destroyed chassis must stop
+* the fusion writing through its drivebase.
+*
+* Built and run by tools/tests/run.sh.
+*/
+
+#include "tr_host.hpp"
+#include "TitanReset/TRChassis.hpp"
+#include "TitanReset/TRImuFusion.hpp"
+#include <math.h>
+#include <stdio.h>
+
+/**
+ * Degrees every IMU turns per update while the robot turns.
+ */
+static constexpr double turn_step = 0.5;
+
+/**
+ * @brief Turns every simulated IMU and updates the fusion.
+ */
+static void turn(tr_imu_fusion& fusion, int updates, double step = turn_step)
+{
+    for (int n = 0; n < updates; n++)
+    {
+        for (int port = 1; port <= 4; port++) tr_host_imu_rotation[port] += step;
+        fusion.update();
+    }
+}
+
+static void check_external_write(std::vector<uint8_t> ports, const char* name)
+{
+    char message[128];
+    for (double& rotation : tr_host_imu_rotation) rotation = 0;
+
+    ez::Drive* drive = tr_host_drive();
+    tr_drivebase base(drive);
+    tr_imu_fusion fusion(ports);
+    fusion.set_drivebase(&base);
+    turn(fusion, 40);
+
+    // EZ-Template sets its heading to 90 degrees, then the robot keeps turning.
+    drive->imu.set_rotation(90);
+    turn(fusion, 20);
+    double expected = 90 + 20 * turn_step;
+    snprintf(message, sizeof(message), "%s: fusion continues from the write, %.2f instead of %.2f", name, fusion.get_rotation(), expected);
+    tr_host_check(fabs(fusion.get_rotation() - expected) < 0.1, message);
+    snprintf(message, sizeof(message), "%s: drivebase IMU keeps the write", name);
+    tr_host_check(fabs(drive->imu.get_rotation() - expected) < 0.1, message);
+
+    bool healthy = true;
+    for (int i = 0; i < fusion.get_unit_count(); i++) healthy = healthy && fusion.get_unit(i).health == IMU_HEALTHY;
+    snprintf(message, sizeof(message), "%s: no unit rejected for the write", name);
+    tr_host_check(healthy, message);
+
+    // A small write is kept too, such as a reset squaring the heading.
+    drive->imu.set_rotation(tr_host_imu_rotation[1] - 3);
+    turn(fusion, 1);
+    expected = tr_host_imu_rotation[1];
+    snprintf(message, sizeof(message), "%s: small write kept", name);
+    tr_host_check(fabs(fusion.get_rotation() - expected) < 0.1, message);
+}
+
+int main()
+{
+    check_external_write({1, 2, 3}, "drivebase IMU fused with two others");
+    check_external_write({1, 2}, "drivebase IMU fused with one other");
+    check_external_write({2, 3, 4}, "drivebase IMU not fused");
+    check_external_write({1}, "drivebase IMU fused alone");
+
+    // Destroying the chassis detaches its drivebase from the fusion.
+    tr_host_sensors sensors;
+    ez::Drive* drive = tr_host_drive();
+    tr_imu_fusion fusion({2, 3});
+    {
+        tr_chassis chassis(&fusion, drive, sensors.all());
+        turn(fusion, 5);
+    }
+    tr_host_imu_rotation[1] = 1234;
+    turn(fusion, 5, 0);
+    tr_host_check(tr_host_imu_rotation[1] == 1234, "destroyed chassis no longer written through");
+
+    return tr_host_report("tr_test_imu_fusion");
+}
@@ -0,0 +1,106 @@
+/*
+* Alliance mirroring against every combination of EZ-Template odometry flips.
+*
+* For each of the eight combinations of odom_x_flip, odom_y_flip and odom_theta_flip, the robot is placed at poses spread over
+* all four quadrants and headings. A routine written for the frame odometry reports in has to initialize, reset, reset in a
+* known quadrant, report its quadrant and be found by the start detector at the true pose on the field, unless a start a quarter
+* turn around the center of the field fits as well.
+*
+* Built and run by tools/tests/run.sh.
+*/
+
+#include "tr_host.hpp"
+#include "TitanReset/TRChassis.hpp"
+#include "TitanReset/TRStartPose.hpp"
+#include "TitanReset/TRAngle.hpp"
+#include "TitanReset/TRWalls.hpp"
+#include <math.h>
+#include <stdio.h>
+
+/**
+ * Largest distance in inches odometry may end up from the true pose after a reset.
+ */
+static constexpr double position_tolerance = 0.3;
+
+static const tr_pose truths[] = {{-60, -40, 0}, {-40, -58, 90}, {50, 30, 180}, {35, 55, 270}, {-45, 45, 0},
+                                 {55, -35, 90}, {-30, -50, 180}, {40, -55, 0}, {-55, 30, 270}};
+
+static bool at_truth()
+{
+    return fabs(tr_host_odom.x - tr_host_truth.x) < position_tolerance && fabs(tr_host_odom.y - tr_host_truth.y) < position_tolerance;
+}
+
+static bool check(bool passed, const char* what, int flips, const tr_pose& truth)
+{
+    char message[128];
+    snprintf(message, sizeof(message), "%s, flips %d, truth (%.0f, %.0f, %.0f)", what, flips, truth.x, truth.y, truth.theta);
+    return tr_host_check(passed, message);
+}
+
+int main()
+{
+    tr_host_sensors sensors;
+    ez::Drive* drive = tr_host_drive();
+
+    for (int flips = 0; flips < 8; flips++)
+    {
+        for (const tr_pose& truth : truths)
+        {
+            tr_host_flip_x = flips & 1;
+            tr_host_flip_y = flips & 2;
+            tr_host_flip_theta = flips & 4;
+            tr_host_place(truth);
+            tr_host_odom = {0, 0, 0};
+
+            tr_chassis chassis(&drive->imu, drive, sensors.all());
+            check(chassis.sync_mirror(), "sync_mirror", flips, truth);
+            tr_mirror mirror = chassis.get_mirror();
+
+            // A mirrored routine writes the pose in the frame odometry reports in.
+            tr_pose user = {tr_host_flip_x ? -truth.x : truth.x, tr_host_flip_y ? -truth.y : truth.y, tr_host_flip_theta ? -truth.theta : truth.theta};
+            tr_quadrant user_quadrant = tr_position_quadrant(user.x, user.y);
+            check(mirror.quadrant(user_quadrant) == tr_position_quadrant(truth.x, truth.y), "mirrored quadrant", flips, truth);
+            tr_vector2 point = mirror.point(tr_vector2(user.x, user.y));
+            check(fabsf(point.x - truth.x) < 1e-3f && fabsf(point.y - truth.y) < 1e-3f, "mirrored point", flips, truth);
+
+            tr_dsr_result result = chassis.perform_dsr_init(user_quadrant, user.theta);
+            check(result.applied && at_truth(), "perform_dsr_init", flips, truth);
+            check(fabsf((tr_angle::from_degrees(drive->imu.get_heading()) - tr_angle::from_degrees(truth.theta)).to_signed_degrees()) < 0.01f, "IMU heading", flips, truth);
+            check(chassis.get_quadrant() == user_quadrant, "get_quadrant", flips, truth);
+
+            tr_host_odom.x += 2;
+            tr_host_odom.y -= 1.5;
+            result = chassis.perform_dsr();
+            check(result.applied && at_truth(), "perform_dsr", flips, truth);
+
+            tr_host_odom.x -= 1;
+            tr_host_odom.y += 2;
+            result = chassis.perform_dsr_quad(user_quadrant);
+            check(result.applied && at_truth(), "perform_dsr_quad", flips, truth);
+
+            // Starts are registered in the frame of odometry, next to a decoy on the other side of the field.
+            tr_start_detector detector(&chassis);
+            detector.add("here", tr_vector2(user.x, user.y), user.theta);
+            detector.add("decoy", tr_vector2(-user.x, user.y), user.theta + 180);
+            tr_start_match match = detector.detect(3, 0);
+            check(match.index == 0 && match.unique && match.rms < 1.0f, "start detect", flips, truth);
+
+            tr_host_odom = {0, 0, 0};
+            result = detector.apply(match);
+            check(result.applied && at_truth(), "start apply", flips, truth);
+
+
+            // The square field reads the same a quarter turn around its center, so a start there cannot be told apart and neither is applied.
+            tr_pose twin = {truth.y, -truth.x, truth.theta + 90};
+            tr_start_detector ambiguous(&chassis);
+            ambiguous.add("here", tr_vector2(user.x, user.y), user.theta);
+            ambiguous.add("twin", tr_vector2(tr_host_flip_x ? -twin.x : twin.x, tr_host_flip_y ? -twin.y : twin.y), tr_host_flip_theta ? -twin.theta : twin.theta);
+            tr_host_place(truth);
+            match = ambiguous.detect(3, 0);
+            result = ambiguous.apply(match);
+            check(!match.unique && !result.applied && result.rejection == REJECT_START_UNKNOWN, "ambiguous start not applied", flips, truth);
+        }
+    }
+
+    return tr_host_report("tr_test_mirror");
+}
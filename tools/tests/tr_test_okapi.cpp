@@ -0,0 +1,170 @@
+/*
+* okapi drivebase adapters against a mock odometry.
+*
+* The mock odometry keeps its state in FRAME_TRANSFORMATION, +X forward and +Y right, and converts to CARTESIAN on the way in and
+* out the way okapi's own odometry does. Poses set through tr_drivebase in the TitanReset frame have to land in the mock with
+* the axes swapped and read back unchanged, for an OdomChassisController and for a bare Odometry in both state modes, and a
+* tr_chassis on the mock has to reset to the true pose.
+*
+* okapi itself is only shipped for the V5, so the few OdomChassisController and TimeUtil members the mock needs are defined here the
+* way okapi defines them.
+*
+* Built and run by tools/tests/run.sh.
+*/
+
+#include "tr_host.hpp"
+#include "TitanReset/TRChassis.hpp"
+#include "TitanReset/TRDrivebase.hpp"
+#include "okapi/api/chassis/controller/odomChassisController.hpp"
+#include "okapi/api/odometry/odometry.hpp"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+okapi::TimeUtil::TimeUtil(const Supplier<std::unique_ptr<AbstractTimer>>& itimerSupplier, const Supplier<std::unique_ptr<AbstractRate>>& irateSupplier,
+                          const Supplier<std::unique_ptr<SettledUtil>>& isettledUtilSupplier) :
+    timerSupplier(itimerSupplier), rateSupplier(irateSupplier), settledUtilSupplier(isettledUtilSupplier)
+{}
+
+okapi::OdomChassisController::OdomChassisController(TimeUtil itimeUtil, std::shared_ptr<Odometry> iodometry, const StateMode& imode, const QLength& imoveThreshold,
+                                                    const QAngle& iturnThreshold, std::shared_ptr<Logger> ilogger) :
+    logger(std::move(ilogger)), timeUtil(std::move(itimeUtil)), moveThreshold(imoveThreshold), turnThreshold(iturnThreshold), odom(std::move(iodometry)),
+    defaultStateMode(imode)
+{}
+
+okapi::OdomChassisController::~OdomChassisController() {}
+okapi::OdomState okapi::OdomChassisController::getState() const { return odom->getState(defaultStateMode); }
+void okapi::OdomChassisController::setState(const OdomState& istate) { odom->setState(istate, defaultStateMode); }
+void okapi::OdomChassisController::setMoveThreshold(const QLength& imoveThreshold) { moveThreshold = imoveThreshold; }
+void okapi::OdomChassisController::setTurnThreshold(const QAngle& iturnThreshold) { turnThreshold = iturnThreshold; }
+okapi::QLength okapi::OdomChassisController::getMoveThreshold() const { return moveThreshold; }
+okapi::QAngle okapi::OdomChassisController::getTurnThreshold() const { return turnThreshold; }
+
+/**
+ * Odometry holding a state set by the test, in the frame okapi's odometry keeps it in.
+ */
+class mock_odometry : public okapi::Odometry
+{
+public:
+    okapi::OdomState frame_state;
+
+    void setScales(const okapi::ChassisScales&) override {}
+    void step() override {}
+
+    okapi::OdomState getState(const okapi::StateMode& imode) const override
+    {
+        if (imode == okapi::StateMode::FRAME_TRANSFORMATION) return frame_state;
+        return {frame_state.y, frame_state.x, frame_state.theta};
+    }
+
+    void setState(const okapi::OdomState& istate, const okapi::StateMode& imode) override
+    {
+        if (imode == okapi::StateMode::FRAME_TRANSFORMATION) frame_state = istate;
+        else frame_state = {istate.y, istate.x, istate.theta};
+    }
+
+    std::shared_ptr<okapi::ReadOnlyChassisModel> getModel() override { return nullptr; }
+    okapi::ChassisScales getScales() override { abort(); }
+};
+
+/**
+ * Chassis controller on the mock odometry. Motions are never run, only the state is used.
+ */
+class mock_chassis_controller : public okapi::OdomChassisController
+{
+public:
+    mock_chassis_controller(std::shared_ptr<okapi::Odometry> odometry) :
+        OdomChassisController(okapi::TimeUtil(okapi::Supplier<std::unique_ptr<okapi::AbstractTimer>>([] { return std::unique_ptr<okapi::AbstractTimer>(); }),
+                                              okapi::Supplier<std::unique_ptr<okapi::AbstractRate>>([] { return std::unique_ptr<okapi::AbstractRate>(); }),
+                                              okapi::Supplier<std::unique_ptr<okapi::SettledUtil>>([] { return std::unique_ptr<okapi::SettledUtil>(); })),
+                              odometry, okapi::StateMode::FRAME_TRANSFORMATION, 0 * okapi::inch, 0 * okapi::degree, nullptr)
+    {}
+
+    void driveToPoint(const okapi::Point&, bool, const okapi::QLength&) override {}
+    void turnToPoint(const okapi::Point&) override {}
+    void turnToAngle(const okapi::QAngle&) override {}
+    void moveDistance(okapi::QLength) override {}
+    void moveRaw(double) override {}
+    void moveDistanceAsync(okapi::QLength) override {}
+    void moveRawAsync(double) override {}
+    void turnAngle(okapi::QAngle) override {}
+    void turnRaw(double) override {}
+    void turnAngleAsync(okapi::QAngle) override {}
+    void turnRawAsync(double) override {}
+    void setTurnsMirrored(bool) override {}
+    bool isSettled() override { return true; }
+    void waitUntilSettled() override {}
+    void stop() override {}
+    void setMaxVelocity(double) override {}
+    double getMaxVelocity() const override { return 0; }
+    okapi::ChassisScales getChassisScales() const override { abort(); }
+    okapi::AbstractMotor::GearsetRatioPair getGearsetRatioPair() const override { abort(); }
+    std::shared_ptr<okapi::ChassisModel> getModel() override { return nullptr; }
+    okapi::ChassisModel& model() override { abort(); }
+};
+
+static bool near(double a, double b)
+{
+    return fabs(a - b) < 1e-9;
+}
+
+/**
+ * @brief Whether the mock holds a TitanReset pose with forward and right swapped, as FRAME_TRANSFORMATION keeps it.
+ */
+static bool holds(const mock_odometry& odometry, tr_pose pose)
+{
+    const okapi::OdomState& state = odometry.frame_state;
+    return near(state.x.convert(okapi::inch), pose.y) && near(state.y.convert(okapi::inch), pose.x) && near(state.theta.convert(okapi::degree), pose.theta);
+}
+
+static void check_adapter(tr_drivebase base, mock_odometry& odometry, tr_drivebase_kind kind, const char* name)
+{
+    char message[96];
+    tr_pose pose = {-47.123456789, 31.987654321, 123.456789012};
+
+    snprintf(message, sizeof(message), "%s kind", name);
+    tr_host_check(base.get_kind() == kind, message);
+
+    base.set_pose(pose);
+    snprintf(message, sizeof(message), "%s writes forward as Y and right as X", name);
+    tr_host_check(holds(odometry, pose), message);
+
+    odometry.frame_state = {10 * okapi::inch, -20 * okapi::inch, 30 * okapi::degree};
+    tr_pose read = base.get_pose();
+    snprintf(message, sizeof(message), "%s reads forward as Y and right as X", name);
+    tr_host_check(near(read.x, -20) && near(read.y, 10) && near(read.theta, 30), message);
+
+    base.set_pose(pose);
+    read = base.get_pose();
+    snprintf(message, sizeof(message), "%s round trip in double precision", name);
+    tr_host_check(near(read.x, pose.x) && near(read.y, pose.y) && near(read.theta, pose.theta), message);
+}
+
+int main()
+{
+    auto odometry = std::make_shared<mock_odometry>();
+    mock_chassis_controller controller(odometry);
+
+    check_adapter(static_cast<okapi::OdomChassisController*>(&controller), *odometry, DRIVEBASE_OKAPI, "OdomChassisController");
+    check_adapter(static_cast<okapi::Odometry*>(odometry.get()), *odometry, DRIVEBASE_OKAPI_ODOMETRY, "Odometry");
+    check_adapter(tr_drivebase(odometry.get(), okapi::StateMode::FRAME_TRANSFORMATION), *odometry, DRIVEBASE_OKAPI_ODOMETRY, "Odometry in FRAME_TRANSFORMATION");
+    check_adapter(tr_drivebase(odometry.get(), okapi::StateMode::CARTESIAN), *odometry, DRIVEBASE_OKAPI_ODOMETRY, "Odometry in CARTESIAN");
+
+    // Mirrored for the other alliance, the state okapi keeps is in the mirrored frame.
+    tr_drivebase mirrored(static_cast<okapi::OdomChassisController*>(&controller));
+    mirrored.set_mirror(tr_mirror(true, false, true));
+    mirrored.set_pose({-40, 20, 90});
+    tr_host_check(holds(*odometry, {40, 20, -90}), "mirrored pose written in the frame of okapi");
+
+    // A chassis on the mock resets okapi's state to the true pose.
+    tr_host_sensors sensors;
+    ez::Drive* drive = tr_host_drive();
+    tr_chassis chassis(&drive->imu, static_cast<okapi::OdomChassisController*>(&controller), sensors.all());
+    tr_host_place({-60, -40, 0});
+    odometry->frame_state = {(-40 - 1.5) * okapi::inch, (-60 + 2) * okapi::inch, 0 * okapi::degree};
+    tr_dsr_result result = chassis.perform_dsr();
+    tr_host_check(result.applied && fabs(odometry->frame_state.y.convert(okapi::inch) + 60) < 0.3 && fabs(odometry->frame_state.x.convert(okapi::inch) + 40) < 0.3,
+                  "reset through the chassis controller");
+
+    return tr_host_report("tr_test_okapi");
+}
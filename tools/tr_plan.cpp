@@ -0,0 +1,82 @@
+/*
+* Offline reset point planner.
+*
+* Build and run on the host from the project root:
+*   g++ -std=gnu++20 -O2 -Iinclude tools/tr_plan.cpp tools/tr_planner.cpp src/TitanReset/TRBeamModel.cpp -o tr_plan
+*   ./tr_plan path.txt tr_calibration.txt 4 skills_resets > include/skills_resets.hpp
+*
+* path.txt holds one waypoint per line as "x y" or "x y heading" in inches and degrees, starting with the start pose,
+* the same points given to pid_odom_set. tr_calibration.txt is the calibration file written by tr_calibrator, one
+* "port parallel perpendicular yaw" line per sensor ordered north, east, south, west.
+*/
+
+#include "tr_planner.hpp"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static constexpr int max_waypoints = 256;
+
+static int read_path(const char* file_name, tr_plan_waypoint* path)
+{
+    FILE* file = fopen(file_name, "r");
+    if (file == nullptr) return -1;
+
+    char line[128];
+    int count = 0;
+    while (count < max_waypoints && fgets(line, sizeof(line), file) != nullptr)
+    {
+        tr_plan_waypoint& waypoint = path[count];
+        int fields = sscanf(line, "%f %f %f", &waypoint.x, &waypoint.y, &waypoint.heading);
+        if (fields < 2) continue;
+        if (fields == 2) waypoint.heading = NAN;
+        count++;
+    }
+    fclose(file);
+    return count;
+}
+
+static bool read_sensors(const char* file_name, tr_plan_sensor* sensors)
+{
+    FILE* file = fopen(file_name, "r");
+    if (file == nullptr) return false;
+
+    int port;
+    int count = 0;
+    while (count < 4 && fscanf(file, "%d %f %f %f", &port, &sensors[count].offset.x, &sensors[count].offset.y, &sensors[count].yaw) == 4) count++;
+    fclose(file);
+    return count == 4;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 4)
+    {
+        fprintf(stderr, "usage: %s <path.txt> <tr_calibration.txt> <points> [table name]\n", argv[0]);
+        return 1;
+    }
+
+    static tr_plan_waypoint path[max_waypoints];
+    int count = read_path(argv[1], path);
+    if (count < 2)
+    {
+        fprintf(stderr, "%s: needs at least two waypoints\n", argv[1]);
+        return 1;
+    }
+
+    tr_plan_sensor sensors[4];
+    if (!read_sensors(argv[2], sensors))
+    {
+        fprintf(stderr, "%s: needs four sensor lines\n", argv[2]);
+        return 1;
+    }
+
+    int k = atoi(argv[3]);
+    const char* name = argc > 4 ? argv[4] : "tr_reset_plan";
+
+    tr_plan_point points[64];
+    int picked = tr_plan_resets(path, count, sensors, tr_beam_model(), k, points);
+    if (picked < k) fprintf(stderr, "only %d of %d reset points have two valid beams\n", picked, k);
+
+    return tr_write_plan(stdout, points, picked, name) ? 0 : 1;
+}
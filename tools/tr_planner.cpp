@@ -0,0 +1,167 @@
+#include "tr_planner.hpp"
+#include "TitanReset/TRWalls.hpp"
+#include "TitanReset/TRAngle.hpp"
+#include "TitanReset/TRUnits.hpp"
+#include <math.h>
+
+/**
+ * Most samples a path is split into. Paths longer than this many spacings are only sampled up to it.
+ */
+static constexpr int max_plan_samples = 2048;
+
+/**
+ * Sample of a path with its score and distance along the path.
+ */
+struct tr_plan_sample
+{
+    tr_plan_point point;
+    float score;
+    float distance;
+};
+
+static tr_plan_sample plan_samples[max_plan_samples];
+
+/**
+ * Most reset points picked from a path.
+ */
+static constexpr int max_plan_points = 64;
+
+typedef tr_quantity<tr_degree, float> tr_plan_degrees;
+
+/**
+ * @brief Variance of the axis an assigned beam measures, or infinity if the beam is invalid.
+ */
+static float plan_axis_variance(tr_vector2 position, float heading, int beam, bool x_axis, const tr_plan_sensor& sensor, const tr_beam_model& model)
+{
+    float facing = heading + 90.0f * tr_sensor_mounts[beam];
+    float facing_rad = tr_plan_degrees(facing).to<tr_radian>().get();
+    tr_vector2 origin(position.x + sensor.offset.x * sinf(facing_rad) + sensor.offset.y * cosf(facing_rad),
+                      position.y + sensor.offset.x * cosf(facing_rad) - sensor.offset.y * sinf(facing_rad));
+    facing += sensor.yaw;
+
+    tr_beam_trace trace = tr_trace_beam(origin, facing);
+    if (trace.hits_x_wall != x_axis) return HUGE_VALF;
+
+    float bias = model.corner_bias(origin, facing, trace);
+    tr_beam_quality quality = model.evaluate(trace.range + bias, 1.0f, trace.incidence, bias);
+    if (!quality.is_valid()) return HUGE_VALF;
+
+    // Sensitivity of the transformed distance to the reading and to the heading, from cos(e) * (r + a) - sin(e) * b.
+    float error = tr_plan_degrees(tr_angle::from_degrees(heading).square_error_degrees()).to<tr_radian>().get();
+    float beam_error = error + tr_plan_degrees(sensor.yaw).to<tr_radian>().get();
+    float reading_gain = cosf(beam_error);
+    float heading_gain = -sinf(error) * (trace.range + sensor.offset.x) - cosf(error) * sensor.offset.y;
+    float heading_sigma = tr_plan_degrees(tr_plan_heading_sigma).to<tr_radian>().get();
+
+    return quality.variance * reading_gain * reading_gain + heading_gain * heading_gain * heading_sigma * heading_sigma;
+}
+
+float tr_plan_information(tr_vector2 position, float heading, const tr_plan_sensor sensors[4], const tr_beam_model& model, float& sigma_x, float& sigma_y)
+{
+    tr_quadrant quadrant = tr_position_quadrant(position.x, position.y);
+    tr_quadrant heading_quadrant = tr_angle::from_degrees(heading).quadrant();
+    const tr_wall_assignment& walls = tr_wall_table[quadrant & 3][heading_quadrant & 3];
+
+    float variance_x = plan_axis_variance(position, heading, walls.x_beam, true, sensors[walls.x_beam], model);
+    float variance_y = plan_axis_variance(position, heading, walls.y_beam, false, sensors[walls.y_beam], model);
+    sigma_x = sqrtf(variance_x);
+    sigma_y = sqrtf(variance_y);
+
+    // The measurements are independent and each observes one axis, so the information matrix is diagonal.
+    if (isinf(variance_x) || isinf(variance_y)) return 0;
+    return fminf(1.0f / variance_x, 1.0f / variance_y);
+}
+
+/**
+ * @brief Fills a sample at a point of a segment of the path and scores it.
+ */
+static void plan_sample(tr_plan_sample& sample, float x, float y, float heading, int index, float distance, const tr_plan_sensor sensors[4], const tr_beam_model& model)
+{
+    sample.point.x = x;
+    sample.point.y = y;
+    sample.point.heading = tr_angle::from_degrees(heading).to_degrees();
+    sample.point.index = index;
+    sample.distance = distance;
+    sample.score = tr_plan_information(tr_vector2(x, y), sample.point.heading, sensors, model, sample.point.sigma_x, sample.point.sigma_y);
+}
+
+int tr_plan_resets(const tr_plan_waypoint* path, int count, const tr_plan_sensor sensors[4], const tr_beam_model& model, int k, tr_plan_point* out, float spacing, float separation)
+{
+    if (count < 2 || k <= 0 || spacing <= 0) return 0;
+
+    int samples = 0;
+    float travelled = 0;
+    float heading = 0;
+    for (int i = 1; i < count && samples < max_plan_samples; i++)
+    {
+        float dx = path[i].x - path[i - 1].x;
+        float dy = path[i].y - path[i - 1].y;
+        float length = sqrtf(dx * dx + dy * dy);
+
+        // Headings follow EZ-Template, clockwise from +Y, so the direction of travel is atan2(dx, dy).
+        heading = isnan(path[i].heading) ? tr_quantity<tr_radian, float>(atan2f(dx, dy)).to<tr_degree>().get() : path[i].heading;
+
+        for (float along = 0; along < length && samples < max_plan_samples; along += spacing)
+        {
+            float t = along / length;
+            plan_sample(plan_samples[samples++], path[i - 1].x + dx * t, path[i - 1].y + dy * t, heading, i, travelled + along, sensors, model);
+        }
+        travelled += length;
+    }
+
+    // Each segment is sampled up to its end, so the end of the path is sampled on its own, facing the way the last segment does.
+    if (samples < max_plan_samples) plan_sample(plan_samples[samples++], path[count - 1].x, path[count - 1].y, heading, count - 1, travelled, sensors, model);
+
+    // Greedy pick of the best samples that are far enough from every sample already picked.
+    if (k > max_plan_points) k = max_plan_points;
+    int picks[max_plan_points];
+    int picked = 0;
+    while (picked < k)
+    {
+        int best = -1;
+        for (int i = 0; i < samples; i++)
+        {
+            if (plan_samples[i].score <= 0) continue;
+            if (best >= 0 && plan_samples[i].score <= plan_samples[best].score) continue;
+
+            // A sample is never clear of itself, even without a separation.
+            bool clear = true;
+            for (int j = 0; j < picked && clear; j++)
+            {
+                clear = picks[j] != i && fabsf(plan_samples[i].distance - plan_samples[picks[j]].distance) >= separation;
+            }
+            if (clear) best = i;
+        }
+        if (best < 0) break;
+        picks[picked++] = best;
+    }
+
+    // Samples are stored in path order, so sorting the picks by sample orders them along the path.
+    for (int i = 1; i < picked; i++)
+    {
+        int pick = picks[i];
+        int j = i - 1;
+        while (j >= 0 && picks[j] > pick)
+        {
+            picks[j + 1] = picks[j];
+            j--;
+        }
+        picks[j + 1] = pick;
+    }
+    for (int i = 0; i < picked; i++) out[i] = plan_samples[picks[i]].point;
+    return picked;
+}
+
+bool tr_write_plan(FILE* file, const tr_plan_point* points, int count, const char* name)
+{
+    bool ok = fprintf(file, "// Generated by tools/tr_plan.cpp. Regenerate it instead of editing.\n\n#pragma once\n\n#include \"TitanReset/TRPlanPoint.hpp\"\n\n") > 0;
+    ok = ok && fprintf(file, "/**\n * Reset points {x, y, heading, path index, sigma x, sigma y}. Schedule with perform_dsr_at_point({x, y}).\n */\n") > 0;
+    ok = ok && fprintf(file, "static constexpr tr_plan_point %s[] = {\n", name) > 0;
+    for (int i = 0; i < count; i++)
+    {
+        const tr_plan_point& point = points[i];
+        ok = ok && fprintf(file, "    {%.2ff, %.2ff, %.1ff, %d, %.3ff, %.3ff},\n", point.x, point.y, point.heading, point.index, point.sigma_x, point.sigma_y) > 0;
+    }
+    ok = ok && fprintf(file, "};\n\nstatic constexpr int %s_count = %d;\n", name, count) > 0;
+    return ok;
+}
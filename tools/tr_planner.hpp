@@ -0,0 +1,75 @@
+#pragma once
+
+#include "TitanReset/TRTypes.hpp"
+#include "TitanReset/TRBeamModel.hpp"
+#include "TitanReset/TRPlanPoint.hpp"
+#include <stdio.h>
+
+/*
+* Reset point planner. Samples a planned path and scores how well a reset at each sample would observe X and Y.
+*
+* Only built for the host, by tools/tr_plan.cpp, and writes the best points as a C++ table for perform_dsr_at_point.
+* The field is modelled as its four walls, the same as the rest of TitanReset.
+*/
+
+/**
+ * Point of a planned path. A NaN heading faces the direction of travel.
+ */
+struct tr_plan_waypoint
+{
+    float x;
+    float y;
+    float heading;
+};
+
+/**
+ * Mounting of a sensor, ordered north, east, south, west.
+ */
+struct tr_plan_sensor
+{
+    tr_vector2 offset;
+    float yaw;
+};
+
+/**
+ * Heading uncertainty in degrees assumed when scoring a reset, it grows the error of beams that are not square to their wall.
+ */
+static constexpr float tr_plan_heading_sigma = 0.5f;
+
+/**
+ * @brief Fisher information of the position a reset would measure at a pose.
+ *
+ * The assigned X and Y beams are traced with the beam model. The information of each axis is the inverse of its beam variance plus the error heading uncertainty adds to it.
+ *
+ * @param sensors mounting of every sensor
+ * @param model beam validity and noise model
+ * @param sigma_x standard deviation of the measured X, infinite if its beam is invalid
+ * @param sigma_y standard deviation of the measured Y, infinite if its beam is invalid
+ * @return Information of the worse observed axis in inverse square inches, 0 if either beam is invalid
+ */
+float tr_plan_information(tr_vector2 position, float heading, const tr_plan_sensor sensors[4], const tr_beam_model& model, float& sigma_x, float& sigma_y);
+
+/**
+ * @brief Picks the best reset points along a path.
+ *
+ * Samples the path up to and including its last waypoint, scores each sample by the information of its worse axis, and greedily picks the highest scoring
+ * samples at least a separation apart. Each sample is picked at most once.
+ *
+ * @param path waypoints, starting with the start of the path
+ * @param count amount of waypoints
+ * @param sensors mounting of every sensor
+ * @param model beam validity and noise model
+ * @param k largest amount of points to pick, at most 64
+ * @param out picked points ordered along the path, room for k
+ * @param spacing distance between samples in inches
+ * @param separation least distance along the path between picked points in inches
+ * @return Amount of points picked
+ */
+int tr_plan_resets(const tr_plan_waypoint* path, int count, const tr_plan_sensor sensors[4], const tr_beam_model& model, int k, tr_plan_point* out, float spacing = 1.0f, float separation = 12.0f);
+
+/**
+ * @brief Writes picked points as a C++ header holding a constant table.
+ * @param name name of the table
+ * @return Whether the header was written
+ */
+bool tr_write_plan(FILE* file, const tr_plan_point* points, int count, const char* name);